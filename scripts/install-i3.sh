@@ -44,6 +44,7 @@ mkdir -p ~/.config/i3
 # Copy the binary
 echo -e "${YELLOW}Installing binary...${NC}"
 cp -f build/clipboard_manager ~/.local/bin/
+cp -f build/vmcastle-toggle ~/.local/bin/
 
 # Create systemd service file
 echo -e "${YELLOW}Creating systemd service...${NC}"
@@ -70,11 +71,8 @@ echo -e "${YELLOW}Creating toggle script...${NC}"
 cat > ~/.local/bin/toggle-clipboard.sh << EOF
 #!/bin/bash
 
-# Check if the process is running
-if pidof clipboard_manager > /dev/null; then
-    # Send USR1 signal to toggle visibility
-    pkill -USR1 -f clipboard_manager
-else
+# Ask the running instance to toggle its window over the activation socket
+if ! /home/$USER/.local/bin/vmcastle-toggle 2>/dev/null; then
     # Start the clipboard manager
     /home/$USER/.local/bin/clipboard_manager &
 fi
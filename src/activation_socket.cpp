@@ -0,0 +1,158 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "activation_socket.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// /tmp is shared: anyone can create our path first and listen there, so
+// the socket lives in a directory that must be ours and closed to others
+static bool private_directory(const std::string& dir) {
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    struct stat info;
+    return lstat(dir.c_str(), &info) == 0 && S_ISDIR(info.st_mode) &&
+           info.st_uid == getuid() && (info.st_mode & 077) == 0;
+}
+
+std::string activation_socket_path() {
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir) {
+        return std::string(runtime_dir) + "/vmcastle.sock";
+    }
+    std::string dir = "/tmp/vmcastle-" + std::to_string(getuid());
+    if (!private_directory(dir)) {
+        return std::string();
+    }
+    return dir + "/activation.sock";
+}
+
+int64_t activation_clock_us() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool make_address(sockaddr_un& address, socklen_t& length) {
+    std::string path = activation_socket_path();
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+    return true;
+}
+
+bool activation_send(const char* command) {
+    sockaddr_un address;
+    socklen_t length;
+    if (!make_address(address, length)) {
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    // The send time lets the instance measure hotkey-to-frame latency
+    char message[64];
+    int size = snprintf(message, sizeof(message), "%s %lld", command,
+                        static_cast<long long>(activation_clock_us()));
+    bool sent = sendto(fd, message, static_cast<size_t>(size), 0,
+                       reinterpret_cast<sockaddr*>(&address), length) == size;
+    close(fd);
+    return sent;
+}
+
+int activation_listen() {
+    sockaddr_un address;
+    socklen_t length;
+    if (!make_address(address, length)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // A socket file nobody answers on is left over from a crash
+    int probe = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0) {
+        bool live = connect(probe, reinterpret_cast<sockaddr*>(&address), length) == 0;
+        close(probe);
+        if (live) {
+            close(fd);
+            return -1;
+        }
+    }
+    unlink(address.sun_path);
+
+    // Have the kernel attach the sender's credentials to every datagram
+    int pass_credentials = 1;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_PASSCRED, &pass_credentials, sizeof(pass_credentials)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool activation_receive(int fd, ActivationRequest& request) {
+    char message[64];
+    iovec data = {message, sizeof(message) - 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(ucred))];
+    msghdr header = {};
+    header.msg_iov = &data;
+    header.msg_iovlen = 1;
+    header.msg_control = control;
+    header.msg_controllen = sizeof(control);
+
+    ssize_t size = recvmsg(fd, &header, 0);
+    if (size <= 0) {
+        return false;
+    }
+    message[size] = '\0';
+
+    // Only this user may drive the instance
+    cmsghdr* credentials = CMSG_FIRSTHDR(&header);
+    if (!credentials || credentials->cmsg_level != SOL_SOCKET || credentials->cmsg_type != SCM_CREDENTIALS) {
+        return false;
+    }
+    ucred sender;
+    memcpy(&sender, CMSG_DATA(credentials), sizeof(sender));
+    if (sender.uid != getuid()) {
+        return false;
+    }
+
+    char command[32];
+    long long sent_at = 0;
+    int fields = sscanf(message, "%31s %lld", command, &sent_at);
+    if (fields < 1) {
+        return false;
+    }
+    request.command = command;
+    request.sent_at_us = fields == 2 ? sent_at : 0;
+    return true;
+}
+
+void activation_close(int fd) {
+    if (fd < 0) {
+        return;
+    }
+    close(fd);
+    unlink(activation_socket_path().c_str());
+}
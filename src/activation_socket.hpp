@@ -0,0 +1,45 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef ACTIVATION_SOCKET_HPP
+#define ACTIVATION_SOCKET_HPP
+
+#include <cstdint>
+#include <string>
+
+// Datagram socket through which the hotkey client asks the running instance
+// to show its window. It only needs libc, so the client starts in well
+// under a millisecond instead of loading GTK.
+
+// A request read from the socket
+struct ActivationRequest {
+    std::string command;       // e.g. "toggle"
+    int64_t sent_at_us = 0;    // CLOCK_MONOTONIC time the client sent it
+};
+
+// $XDG_RUNTIME_DIR/vmcastle.sock, or a socket in a private per-user
+// directory in /tmp. Empty if that directory exists but is not private to
+// this user.
+std::string activation_socket_path();
+
+// Current CLOCK_MONOTONIC time in microseconds (same clock as
+// g_get_monotonic_time)
+int64_t activation_clock_us();
+
+// Send command to the running instance; false if none is listening
+bool activation_send(const char* command);
+
+// Bind the socket for this instance. Returns the non-blocking descriptor,
+// or -1 if another instance already listens or the socket cannot be made.
+int activation_listen();
+
+// Read one pending request from a listening descriptor. Requests sent by
+// other users are dropped.
+bool activation_receive(int fd, ActivationRequest& request);
+
+// Close a listening descriptor and remove its socket file
+void activation_close(int fd);
+
+#endif // ACTIVATION_SOCKET_HPP
@@ -0,0 +1,43 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef CAPTURE_EVENT_HPP
+#define CAPTURE_EVENT_HPP
+
+#include <string>
+#include <cstdint>
+#include <memory>
+
+// X selections tracked as separate history streams
+enum class Selection {
+    CLIPBOARD,   // Explicit copies (Ctrl+C)
+    PRIMARY      // Mouse selections, debounced
+};
+
+// One selection change seen by the capture thread. The payload is allocated
+// once and shared read-only from capture to the stored entry.
+struct CaptureEvent {
+    Selection selection = Selection::CLIPBOARD;
+    std::shared_ptr<const std::string> text;
+    int64_t timestamp_us = 0;   // Monotonic capture time
+};
+
+// Buckets of the ingest latency histogram; bucket i counts latencies
+// below 2^i microseconds (and at least 2^(i-1))
+const size_t LATENCY_BUCKETS = 32;
+
+// Ingestion counters, updated by the capture thread and the store
+struct CaptureStats {
+    uint64_t captured = 0;    // Events pushed into the ring
+    uint64_t dropped = 0;     // Events replaced while the ring was full
+    uint64_t coalesced = 0;   // Events merged with an identical neighbour
+    uint64_t batches = 0;     // Batches drained by the store
+    
+    // Time from capture to the end of the batch that stored the event
+    uint64_t latency_buckets[LATENCY_BUCKETS] = {};
+    uint64_t latency_max_us = 0;
+};
+
+#endif // CAPTURE_EVENT_HPP
@@ -0,0 +1,95 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "capture_filter.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Targets holding text; anything under text/ counts too
+static const char* const TEXT_TARGETS[] = {
+    "UTF8_STRING", "STRING", "TEXT", "COMPOUND_TEXT",
+};
+
+static std::string to_lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+        return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    });
+    return text;
+}
+
+static bool is_text_target(const std::string& target) {
+    for (const char* name : TEXT_TARGETS) {
+        if (target == name) {
+            return true;
+        }
+    }
+    return target.compare(0, 5, "text/") == 0;
+}
+
+CaptureFilter CaptureFilter::from_environment() {
+    CaptureFilter filter;
+
+    const char* secrets = getenv("VMCASTLE_CAPTURE_SECRETS");
+    filter.skip_secrets = !(secrets && strcmp(secrets, "0") != 0);
+
+    const char* max_size = getenv("VMCASTLE_MAX_CAPTURE_BYTES");
+    if (max_size && *max_size) {
+        char* end = nullptr;
+        long long parsed = strtoll(max_size, &end, 10);
+        if (*end == '\0' && parsed >= 0) {
+            filter.max_size = parsed;
+        }
+    }
+
+    const char* apps = getenv("VMCASTLE_IGNORE_APPS");
+    if (apps) {
+        std::string list = apps;
+        size_t start = 0;
+        while (start <= list.size()) {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos) {
+                end = list.size();
+            }
+            std::string name = to_lower(list.substr(start, end - start));
+            name.erase(0, name.find_first_not_of(' '));
+            name.erase(name.find_last_not_of(' ') + 1);
+            if (!name.empty()) {
+                filter.ignored_classes.push_back(name);
+            }
+            start = end + 1;
+        }
+    }
+
+    return filter;
+}
+
+bool CaptureFilter::is_active() const {
+    return skip_secrets || skip_non_text || max_size > 0 || !ignored_classes.empty();
+}
+
+bool CaptureFilter::allows(const SelectionMetadata& metadata) const {
+    if (skip_secrets && metadata.password_hint) {
+        return false;
+    }
+
+    if (!metadata.owner_class.empty() && !ignored_classes.empty()) {
+        std::string owner_class = to_lower(metadata.owner_class);
+        if (std::find(ignored_classes.begin(), ignored_classes.end(), owner_class) != ignored_classes.end()) {
+            return false;
+        }
+    }
+
+    // An owner that did not answer TARGETS may still convert to text
+    if (skip_non_text && !metadata.targets.empty() &&
+        std::none_of(metadata.targets.begin(), metadata.targets.end(), is_text_target)) {
+        return false;
+    }
+
+    if (max_size > 0 && metadata.size > max_size) {
+        return false;
+    }
+
+    return true;
+}
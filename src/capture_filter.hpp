@@ -0,0 +1,57 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef CAPTURE_FILTER_HPP
+#define CAPTURE_FILTER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// What the owner of a selection tells about it before any content moves
+struct SelectionMetadata {
+    // Names of the targets the owner converts to (TARGETS)
+    std::vector<std::string> targets;
+
+    // The owner marked the content as a secret (x-kde-passwordManagerHint)
+    bool password_hint = false;
+
+    // WM_CLASS class of the owner window or its client leader, if set
+    std::string owner_class;
+
+    // Size from the LENGTH target, -1 when the owner does not offer it
+    long long size = -1;
+};
+
+// Rules deciding from the metadata whether a selection is worth reading at
+// all, so content that would be discarded never crosses the connection.
+// Without an X connection the metadata comes from xclip, which tells the
+// targets and the hint only; the class and size rules never skip there.
+struct CaptureFilter {
+    // Skip content a password manager marks as secret
+    bool skip_secrets = true;
+
+    // Skip owners that offer no text target (images, files)
+    bool skip_non_text = true;
+
+    // Skip content advertised as larger than this many bytes (0: no limit)
+    long long max_size = 0;
+
+    // Lowercase WM_CLASS classes whose selections are never read
+    std::vector<std::string> ignored_classes;
+
+    // Defaults, overridden by VMCASTLE_CAPTURE_SECRETS=1 (read hinted
+    // content anyway), VMCASTLE_MAX_CAPTURE_BYTES and VMCASTLE_IGNORE_APPS
+    // (comma-separated WM_CLASS classes, e.g. keepassxc,1password)
+    static CaptureFilter from_environment();
+
+    // Whether any rule is on, i.e. whether the metadata is worth asking for
+    bool is_active() const;
+
+    // Whether a selection with this metadata should be read
+    bool allows(const SelectionMetadata& metadata) const;
+};
+
+#endif // CAPTURE_FILTER_HPP
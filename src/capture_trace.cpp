@@ -0,0 +1,199 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "capture_trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+// Magic at the start of a trace; version in the last byte
+static const char TRACE_MAGIC[8] = {'V', 'M', 'C', 'T', 'R', 'A', 'C', 1};
+
+static const uint8_t FLAG_PRIMARY = 1;
+static const uint8_t FLAG_PAYLOAD = 2;
+
+// Payloads larger than this are treated as corruption
+static const uint64_t MAX_TRACE_PAYLOAD = uint64_t(1) << 32;
+
+// The writer flushes at most this often, so bursts stay cheap
+static const int64_t FLUSH_INTERVAL_US = 1000000;
+
+static void write_varint(FILE* file, uint64_t value) {
+    unsigned char bytes[10];
+    size_t length = 0;
+    do {
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        bytes[length++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    fwrite(bytes, 1, length, file);
+}
+
+static bool read_varint(FILE* file, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = fgetc(file);
+        if (byte == EOF) {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void write_u64(FILE* file, uint64_t value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+static bool read_u64(FILE* file, uint64_t& value) {
+    unsigned char bytes[8];
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    return true;
+}
+
+uint64_t trace_hash(const std::string& text) {
+    return std::hash<std::string_view>()(std::string_view(text));
+}
+
+std::string synthesize_payload(uint64_t hash, size_t size) {
+    // Words of letters between spaces and newlines, from a generator seeded
+    // with the hash (splitmix64)
+    std::string text;
+    text.reserve(size);
+    uint64_t state = hash;
+    while (text.size() < size) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        for (int i = 0; i < 8 && text.size() < size; ++i, z >>= 8) {
+            unsigned char r = z & 0xFF;
+            text += r < 8 ? '\n' : r < 48 ? ' ' : static_cast<char>('a' + r % 26);
+        }
+    }
+    return text;
+}
+
+CaptureTraceWriter::~CaptureTraceWriter() {
+    close();
+}
+
+bool CaptureTraceWriter::open(const std::string& path, bool with_payloads) {
+    close();
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+    with_payloads_ = with_payloads;
+    last_us_ = 0;
+    count_ = 0;
+    fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), file_);
+    return true;
+}
+
+void CaptureTraceWriter::close() {
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void CaptureTraceWriter::record(const CaptureEvent& event) {
+    if (!file_ || !event.text) {
+        return;
+    }
+
+    // The first event starts the clock
+    int64_t delta = count_ == 0 ? 0 : std::max<int64_t>(0, event.timestamp_us - last_us_);
+    last_us_ = event.timestamp_us;
+
+    uint8_t flags = (event.selection == Selection::PRIMARY ? FLAG_PRIMARY : 0) |
+                    (with_payloads_ ? FLAG_PAYLOAD : 0);
+    fputc(flags, file_);
+    write_varint(file_, static_cast<uint64_t>(delta));
+    write_varint(file_, event.text->size());
+    write_u64(file_, trace_hash(*event.text));
+    if (with_payloads_) {
+        fwrite(event.text->data(), 1, event.text->size(), file_);
+    }
+    count_++;
+
+    if (event.timestamp_us - last_flush_us_ >= FLUSH_INTERVAL_US) {
+        fflush(file_);
+        last_flush_us_ = event.timestamp_us;
+    }
+}
+
+uint64_t CaptureTraceWriter::get_count() const {
+    return count_;
+}
+
+CaptureTraceReader::~CaptureTraceReader() {
+    if (file_) {
+        fclose(file_);
+    }
+}
+
+bool CaptureTraceReader::open(const std::string& path) {
+    file_ = fopen(path.c_str(), "rb");
+    if (!file_) {
+        error_ = strerror(errno);
+        return false;
+    }
+    char magic[sizeof(TRACE_MAGIC)];
+    if (fread(magic, 1, sizeof(magic), file_) != sizeof(magic) ||
+        memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        error_ = "not a capture trace";
+        return false;
+    }
+    return true;
+}
+
+bool CaptureTraceReader::next(TraceRecord& record) {
+    int flags = fgetc(file_);
+    if (flags == EOF) {
+        return false;
+    }
+
+    uint64_t delta = 0;
+    if (!read_varint(file_, delta) || !read_varint(file_, record.size) || !read_u64(file_, record.hash) ||
+        record.size > MAX_TRACE_PAYLOAD) {
+        error_ = "truncated or corrupt record";
+        return false;
+    }
+    offset_us_ += static_cast<int64_t>(delta);
+    record.offset_us = offset_us_;
+    record.selection = (flags & FLAG_PRIMARY) ? Selection::PRIMARY : Selection::CLIPBOARD;
+    record.has_payload = (flags & FLAG_PAYLOAD) != 0;
+
+    record.payload.clear();
+    if (record.has_payload) {
+        record.payload.resize(record.size);
+        if (fread(&record.payload[0], 1, record.size, file_) != record.size) {
+            error_ = "truncated payload";
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::string& CaptureTraceReader::get_error() const {
+    return error_;
+}
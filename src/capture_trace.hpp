@@ -0,0 +1,92 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef CAPTURE_TRACE_HPP
+#define CAPTURE_TRACE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "capture_event.hpp"
+
+// Recording of the capture event stream, to replay a user's copy pattern
+// (burst rates, payload sizes, repeats) as a benchmark.
+//
+// The file starts with an 8-byte magic, followed by one record per event:
+//
+//   u8      flags          bit 0: PRIMARY selection, bit 1: payload follows
+//   varint  delta_us       capture time since the previous event
+//   varint  size           payload size in bytes
+//   u64     hash           content hash, little-endian (equal texts, equal hash)
+//   bytes   payload        only with bit 1
+//
+// Payloads are left out unless asked for, so a trace can be shared without
+// its content; replay then synthesizes text of the same size per hash.
+
+struct TraceRecord {
+    Selection selection = Selection::CLIPBOARD;
+    int64_t offset_us = 0;     // Time since the first event
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    bool has_payload = false;
+    std::string payload;
+};
+
+class CaptureTraceWriter {
+public:
+    CaptureTraceWriter() = default;
+    ~CaptureTraceWriter();
+
+    CaptureTraceWriter(const CaptureTraceWriter&) = delete;
+    CaptureTraceWriter& operator=(const CaptureTraceWriter&) = delete;
+
+    // Create the file (replacing it) and write the magic
+    bool open(const std::string& path, bool with_payloads);
+    void close();
+
+    // Append one captured event
+    void record(const CaptureEvent& event);
+
+    uint64_t get_count() const;
+
+private:
+    FILE* file_ = nullptr;
+    bool with_payloads_ = false;
+    int64_t last_us_ = 0;
+    int64_t last_flush_us_ = 0;
+    uint64_t count_ = 0;
+};
+
+class CaptureTraceReader {
+public:
+    CaptureTraceReader() = default;
+    ~CaptureTraceReader();
+
+    CaptureTraceReader(const CaptureTraceReader&) = delete;
+    CaptureTraceReader& operator=(const CaptureTraceReader&) = delete;
+
+    // Open a trace and check its magic
+    bool open(const std::string& path);
+
+    // Next event; false at the end or on a corrupt record (see get_error)
+    bool next(TraceRecord& record);
+
+    const std::string& get_error() const;
+
+private:
+    FILE* file_ = nullptr;
+    int64_t offset_us_ = 0;
+    std::string error_;
+};
+
+// Hash stored for a payload
+uint64_t trace_hash(const std::string& text);
+
+// Deterministic printable text standing in for a payload that was not
+// recorded: same hash and size, same text
+std::string synthesize_payload(uint64_t hash, size_t size);
+
+#endif // CAPTURE_TRACE_HPP
@@ -0,0 +1,90 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "case_fold.hpp"
+#include <glib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Lowercase the leading ASCII run of data into out.
+// Returns the number of bytes consumed (the index of the first non-ASCII byte).
+static size_t fold_ascii_prefix(const char* data, size_t size, char* out) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i before_upper = _mm_set1_epi8('A' - 1);
+    const __m128i after_upper = _mm_set1_epi8('Z' + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+
+        // Any byte with the high bit set ends the fast path
+        if (_mm_movemask_epi8(chunk) != 0) {
+            break;
+        }
+
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, before_upper), _mm_cmplt_epi8(chunk, after_upper));
+        chunk = _mm_add_epi8(chunk, _mm_and_si128(upper, case_bit));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), chunk);
+    }
+#endif
+
+    for (; i < size; ++i) {
+        if (static_cast<unsigned char>(data[i]) >= 0x80) {
+            break;
+        }
+        out[i] = ascii_lower(data[i]);
+    }
+    return i;
+}
+
+// Fold valid UTF-8: decompose (NFKD), case fold, then drop combining marks
+static void fold_unicode(const char* data, size_t size, std::string& out) {
+    gchar* decomposed = g_utf8_normalize(data, static_cast<gssize>(size), G_NORMALIZE_NFKD);
+    if (!decomposed) {
+        return;
+    }
+    gchar* folded = g_utf8_casefold(decomposed, -1);
+    g_free(decomposed);
+
+    char buffer[6];
+    for (const gchar* p = folded; *p; p = g_utf8_next_char(p)) {
+        gunichar c = g_utf8_get_char(p);
+        if (g_unichar_ismark(c)) {
+            continue;
+        }
+        out.append(buffer, g_unichar_to_utf8(c, buffer));
+    }
+    g_free(folded);
+}
+
+std::string fold_text(const char* data, size_t size, bool valid_utf8) {
+    std::string out(size, '\0');
+    size_t ascii = fold_ascii_prefix(data, size, &out[0]);
+    if (ascii == size) {
+        return out;
+    }
+
+    // The ASCII prefix always ends on a character boundary
+    out.resize(ascii);
+    const char* rest = data + ascii;
+    size_t rest_size = size - ascii;
+
+    if (valid_utf8 || g_utf8_validate(rest, static_cast<gssize>(rest_size), nullptr)) {
+        fold_unicode(rest, rest_size, out);
+    } else {
+        // Not text we can decode: keep bytes, lowercase ASCII
+        for (size_t i = 0; i < rest_size; ++i) {
+            out.push_back(ascii_lower(rest[i]));
+        }
+    }
+    return out;
+}
@@ -0,0 +1,23 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef CASE_FOLD_HPP
+#define CASE_FOLD_HPP
+
+#include <string>
+#include <cstddef>
+
+// Search representation of a text: case-folded and stripped of accents.
+// ASCII runs are lowercased 16 bytes at a time; anything else goes through
+// Unicode compatibility decomposition and case folding. Invalid UTF-8 is
+// only ASCII-lowercased; pass valid_utf8 for text validated at ingest to
+// skip checking it again.
+std::string fold_text(const char* data, size_t size, bool valid_utf8 = false);
+
+inline std::string fold_text(const std::string& text) {
+    return fold_text(text.data(), text.size());
+}
+
+#endif // CASE_FOLD_HPP
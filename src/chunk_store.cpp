@@ -0,0 +1,177 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "chunk_store.hpp"
+#include "compression.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string_view>
+
+// Gear table: one pseudo-random word per byte value (splitmix64, fixed seed
+// so cut points stay the same across runs)
+static constexpr std::array<uint64_t, 256> make_gear_table() {
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < table.size(); ++i) {
+        state += 0x9E3779B97F4A7C15ull;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        table[i] = z ^ (z >> 31);
+    }
+    return table;
+}
+
+static constexpr std::array<uint64_t, 256> GEAR = make_gear_table();
+
+// Normalized chunking: a stricter mask before the average size and a looser
+// one after it keep most chunks close to the average. The gear hash shifts
+// left, so its top bits cover the last 64 bytes.
+static const uint64_t MASK_STRICT = ~0ull << (64 - 15);
+static const uint64_t MASK_LOOSE = ~0ull << (64 - 11);
+
+size_t fastcdc_next_cut(const unsigned char* data, size_t size) {
+    if (size <= CHUNK_MIN_SIZE) {
+        return size;
+    }
+    size_t normal = std::min(size, CHUNK_AVG_SIZE);
+    size_t limit = std::min(size, CHUNK_MAX_SIZE);
+
+    // Bytes before the minimum size never end a chunk, so skip them
+    uint64_t hash = 0;
+    size_t i = CHUNK_MIN_SIZE;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + GEAR[data[i]];
+        if (!(hash & MASK_STRICT)) {
+            return i + 1;
+        }
+    }
+    for (; i < limit; ++i) {
+        hash = (hash << 1) + GEAR[data[i]];
+        if (!(hash & MASK_LOOSE)) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+bool chunk_reassemble(const ChunkList& chunks, char* dst, size_t raw_size) {
+    size_t written = 0;
+    for (const ChunkRef& chunk : chunks) {
+        if (chunk->raw_size > raw_size - written) {
+            return false;
+        }
+        if (chunk->compressed) {
+            if (!lz4_decompress_to(chunk->data.data(), chunk->data.size(), dst + written, chunk->raw_size)) {
+                return false;
+            }
+        } else {
+            memcpy(dst + written, chunk->data.data(), chunk->raw_size);
+        }
+        written += chunk->raw_size;
+    }
+    return written == raw_size;
+}
+
+static ChunkRef make_chunk(uint64_t hash, const char* data, size_t size) {
+    auto chunk = std::make_shared<StoredChunk>();
+    chunk->hash = hash;
+    chunk->raw_size = size;
+
+    // Same rule as whole entries: compress if it saves at least an eighth
+    std::string block = lz4_compress(data, size);
+    if (block.size() <= size - size / 8) {
+        chunk->compressed = true;
+        chunk->data = std::move(block);
+    } else {
+        chunk->data.assign(data, size);
+    }
+    return chunk;
+}
+
+static bool chunk_equals(const StoredChunk& chunk, const char* data, size_t size) {
+    if (chunk.raw_size != size) {
+        return false;
+    }
+    if (!chunk.compressed) {
+        return memcmp(chunk.data.data(), data, size) == 0;
+    }
+    std::string raw;
+    return lz4_decompress(chunk.data.data(), chunk.data.size(), size, raw) &&
+           memcmp(raw.data(), data, size) == 0;
+}
+
+ChunkPool& ChunkPool::shared() {
+    static ChunkPool pool;
+    return pool;
+}
+
+ChunkList ChunkPool::store(const char* data, size_t size) {
+    ChunkList chunks;
+    chunks.reserve(size / CHUNK_AVG_SIZE + 1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t offset = 0;
+    while (offset < size) {
+        size_t length = fastcdc_next_cut(bytes + offset, size - offset);
+        chunks.push_back(intern_locked(data + offset, length));
+        offset += length;
+    }
+    return chunks;
+}
+
+ChunkRef ChunkPool::intern(const char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return intern_locked(data, size);
+}
+
+ChunkRef ChunkPool::intern_locked(const char* data, size_t size) {
+    uint64_t hash = std::hash<std::string_view>()(std::string_view(data, size));
+
+    auto it = chunks_.find(hash);
+    if (it != chunks_.end()) {
+        ChunkRef existing = it->second.lock();
+        if (existing) {
+            // A hash collision keeps its own, unshared chunk
+            return chunk_equals(*existing, data, size) ? existing : make_chunk(hash, data, size);
+        }
+    }
+
+    ChunkRef chunk = make_chunk(hash, data, size);
+    chunks_[hash] = chunk;
+    if (chunks_.size() >= prune_at_) {
+        prune_locked();
+    }
+    return chunk;
+}
+
+void ChunkPool::prune_locked() {
+    for (auto it = chunks_.begin(); it != chunks_.end();) {
+        if (it->second.expired()) {
+            it = chunks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    prune_at_ = std::max<size_t>(1024, chunks_.size() * 2);
+}
+
+size_t ChunkPool::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    prune_locked();
+    return chunks_.size();
+}
+
+size_t ChunkPool::stored_bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const auto& slot : chunks_) {
+        if (ChunkRef chunk = slot.second.lock()) {
+            total += chunk->data.size();
+        }
+    }
+    return total;
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef CHUNK_STORE_HPP
+#define CHUNK_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Content-defined chunking (FastCDC) and a process-wide pool of chunks.
+// Large payloads are cut where a rolling hash of the content matches, so an
+// edit only changes the chunks around it; versions of the same text then
+// share every other chunk in memory and in the history file.
+
+// Payloads smaller than this are stored as a single LZ4 block instead
+const size_t CHUNKING_MIN_SIZE = 16 * 1024;
+
+// Chunk size limits; cuts land around the average
+const size_t CHUNK_MIN_SIZE = 2 * 1024;
+const size_t CHUNK_AVG_SIZE = 8 * 1024;
+const size_t CHUNK_MAX_SIZE = 64 * 1024;
+
+// One chunk, LZ4-compressed when that saves space
+struct StoredChunk {
+    uint64_t hash = 0;
+    size_t raw_size = 0;
+    bool compressed = false;
+    std::string data;    // Raw bytes, or an LZ4 block of raw_size bytes
+};
+
+// Chunks are freed when the last entry using them goes away
+using ChunkRef = std::shared_ptr<const StoredChunk>;
+using ChunkList = std::vector<ChunkRef>;
+
+// Length of the chunk starting at data (at most size bytes)
+size_t fastcdc_next_cut(const unsigned char* data, size_t size);
+
+// Copy the content of chunks into dst, which holds raw_size bytes;
+// false if a block is corrupt or the sizes do not add up
+bool chunk_reassemble(const ChunkList& chunks, char* dst, size_t raw_size);
+
+class ChunkPool {
+public:
+    // The pool shared by all entries
+    static ChunkPool& shared();
+
+    // Split a payload and intern its chunks
+    ChunkList store(const char* data, size_t size);
+
+    // Intern one chunk of raw bytes, reusing an identical one if present
+    ChunkRef intern(const char* data, size_t size);
+
+    // Number of live chunks and their stored size
+    size_t size();
+    size_t stored_bytes();
+
+private:
+    ChunkRef intern_locked(const char* data, size_t size);
+    void prune_locked();
+
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::weak_ptr<const StoredChunk>> chunks_;
+    size_t prune_at_ = 1024;    // Sweep expired slots when the map grows past this
+};
+
+#endif // CHUNK_STORE_HPP
@@ -3,31 +3,267 @@
 // Consulte o arquivo LICENSE para mais informações.
 
 #include "clipboard_entry.hpp"
+#include "compression.hpp"
+#include "case_fold.hpp"
 #include <ctime>
 #include <iomanip>
 #include <sstream>
+#include <mutex>
+#include <array>
 
-ClipboardEntry::ClipboardEntry(const std::string& text)
-    : text_(text), timestamp_(std::time(nullptr)) {
+// Small ring of recently decompressed payloads shared by all entries.
+// Entries only hold weak references, so a payload is freed once it falls out
+// of the ring and nobody else is using it.
+static const size_t DECOMPRESSION_CACHE_SIZE = 8;
+static std::array<ClipboardText, DECOMPRESSION_CACHE_SIZE> decompression_cache;
+static size_t decompression_cache_next = 0;
+static std::mutex decompression_mutex;
+
+ClipboardEntry::ClipboardEntry(ClipboardText text)
+    : timestamp_(std::time(nullptr)) {
+    std::string repaired;
+    kind_ = utf8_is_valid(text->data(), text->size()) ? TextKind::UTF8 : repair_utf8(*text, repaired);
+
+    text_ = kind_ == TextKind::REPAIRED ? std::make_shared<const std::string>(std::move(repaired)) : std::move(text);
+    size_ = text_->size();
+    set_search_text(*text_);
 }
 
-const std::string& ClipboardEntry::get_text() const {
-    return text_;
+ClipboardEntry::ClipboardEntry(ClipboardText text, TextKind kind)
+    : text_(std::move(text)), timestamp_(std::time(nullptr)), kind_(kind) {
+    size_ = text_->size();
+    set_search_text(*text_);
 }
 
-std::string ClipboardEntry::get_preview(size_t max_length) const {
-    if (text_.length() <= max_length) {
+void ClipboardEntry::set_search_text(const std::string& text) {
+    // Binary payloads never match a search
+    if (kind_ == TextKind::BINARY) {
+        fold_is_identity_ = false;
+        folded_ = std::make_shared<const std::string>();
+        signature_ = TextSignature();
+        facets_ = 0;
+        return;
+    }
+
+    signature_ = compute_signature(text.data(), text.size());
+    facets_ = classify_content(text.data(), text.size());
+
+    std::string folded = fold_text(text.data(), text.size(), true);
+
+    // Most text is already lowercase ASCII; share the payload then
+    fold_is_identity_ = folded == text;
+    if (!fold_is_identity_) {
+        folded_size_ = folded.size();
+        if (folded.size() < FOLDED_PACK_SIZE || !pack(folded, folded_compressed_, folded_chunks_)) {
+            folded_ = std::make_shared<const std::string>(std::move(folded));
+        }
+    }
+}
+
+std::shared_ptr<ClipboardEntry> ClipboardEntry::from_compressed(std::string compressed, size_t raw_size) {
+    // Validate the block once and keep the preview head
+    std::string raw;
+    if (!lz4_decompress(compressed.data(), compressed.size(), raw_size, raw)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<ClipboardEntry> entry(new ClipboardEntry());
+    entry->compressed_ = std::move(compressed);
+    entry->load_cold(raw);
+    return entry;
+}
+
+std::shared_ptr<ClipboardEntry> ClipboardEntry::from_chunks(ChunkList chunks, size_t raw_size) {
+    std::string raw(raw_size, '\0');
+    if (!chunk_reassemble(chunks, raw.empty() ? nullptr : &raw[0], raw_size)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<ClipboardEntry> entry(new ClipboardEntry());
+    entry->chunks_ = std::move(chunks);
+    entry->load_cold(raw);
+    return entry;
+}
+
+void ClipboardEntry::load_cold(std::string& raw) {
+    timestamp_ = std::time(nullptr);
+    size_ = raw.size();
+
+    // Files written by older versions may hold invalid UTF-8
+    bool repack = false;
+    if (!utf8_is_valid(raw.data(), raw.size())) {
+        std::string repaired;
+        kind_ = repair_utf8(raw, repaired);
+        if (kind_ == TextKind::REPAIRED) {
+            raw.swap(repaired);
+            size_ = raw.size();
+            repack = true;
+        }
+    }
+
+    // Large single blocks from older files move to shared chunks
+    if (repack || (!compressed_.empty() && raw.size() >= CHUNKING_MIN_SIZE)) {
+        compressed_.clear();
+        chunks_.clear();
+        if (!pack(raw, compressed_, chunks_)) {
+            text_ = std::make_shared<const std::string>(raw);
+        }
+    }
+
+    if (!text_) {
+        head_ = raw.substr(0, HEAD_LENGTH);
+    }
+    set_search_text(raw);
+
+    // Loaded entries stay cold until they are used
+    if (!text_ && folded_ && kind_ != TextKind::BINARY &&
+        pack(*folded_, folded_compressed_, folded_chunks_)) {
+        folded_.reset();
+    }
+}
+
+bool ClipboardEntry::pack(const std::string& raw, std::string& block, ChunkList& chunks) {
+    // Large payloads share chunks with other versions of the same text
+    if (raw.size() >= CHUNKING_MIN_SIZE) {
+        chunks = ChunkPool::shared().store(raw.data(), raw.size());
+        return true;
+    }
+
+    std::string compressed = lz4_compress(raw.data(), raw.size());
+
+    // Keep the raw text unless we save at least an eighth of it
+    if (compressed.size() > raw.size() - raw.size() / 8) {
+        return false;
+    }
+    block = std::move(compressed);
+    return true;
+}
+
+void ClipboardEntry::unpack(const std::string& block, const ChunkList& chunks, size_t raw_size, std::string& out) {
+    if (chunks.empty()) {
+        lz4_decompress(block.data(), block.size(), raw_size, out);
+        return;
+    }
+    out.assign(raw_size, '\0');
+    chunk_reassemble(chunks, out.empty() ? nullptr : &out[0], raw_size);
+}
+
+ClipboardText ClipboardEntry::get_text() const {
+    if (text_) {
         return text_;
     }
-    
-    // Truncate and add ellipsis
-    return text_.substr(0, max_length - 3) + "...";
+
+    std::lock_guard<std::mutex> lock(decompression_mutex);
+
+    // Reuse a payload that is still cached
+    ClipboardText cached = decompressed_.lock();
+    if (cached) {
+        return cached;
+    }
+
+    auto raw = std::make_shared<std::string>();
+    unpack(compressed_, chunks_, size_, *raw);
+    cached = raw;
+
+    decompressed_ = cached;
+    decompression_cache[decompression_cache_next] = cached;
+    decompression_cache_next = (decompression_cache_next + 1) % DECOMPRESSION_CACHE_SIZE;
+    return cached;
+}
+
+void ClipboardEntry::release_decompression_cache() {
+    std::lock_guard<std::mutex> lock(decompression_mutex);
+    for (ClipboardText& cached : decompression_cache) {
+        cached.reset();
+    }
+}
+
+ClipboardText ClipboardEntry::get_search_text() const {
+    if (fold_is_identity_) {
+        return get_text();
+    }
+    if (folded_) {
+        return folded_;
+    }
+
+    // Cold entries are searched rarely enough to skip the cache
+    auto folded = std::make_shared<std::string>();
+    unpack(folded_compressed_, folded_chunks_, folded_size_, *folded);
+    return folded;
+}
+
+const TextSignature& ClipboardEntry::get_signature() const {
+    return signature_;
+}
+
+FacetMask ClipboardEntry::get_facets() const {
+    return facets_;
+}
+
+TextKind ClipboardEntry::get_text_kind() const {
+    return kind_;
+}
+
+bool ClipboardEntry::is_binary() const {
+    return kind_ == TextKind::BINARY;
+}
+
+std::string ClipboardEntry::get_preview(size_t max_length) const {
+    if (kind_ == TextKind::BINARY) {
+        return "[binary data, " + std::to_string(size_) + " bytes]";
+    }
+
+    // Serve previews from the head when possible
+    ClipboardText full;
+    if (text_ || (max_length >= head_.size() && head_.size() < size_)) {
+        full = get_text();
+    }
+    const std::string& text = full ? *full : head_;
+
+    if (text.length() <= max_length) {
+        return text;
+    }
+
+    // Truncate on a character boundary and add ellipsis
+    size_t cut = max_length - 3;
+    while (cut > 0 && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80) {
+        --cut;
+    }
+    return text.substr(0, cut) + "...";
 }
 
 std::time_t ClipboardEntry::get_timestamp() const {
     return timestamp_;
 }
 
+void ClipboardEntry::set_timestamp(std::time_t timestamp) {
+    timestamp_ = timestamp;
+}
+
+std::time_t ClipboardEntry::get_expiry() const {
+    return expiry_;
+}
+
+void ClipboardEntry::set_expiry(std::time_t expiry) {
+    expiry_ = expiry;
+}
+
+EntryId ClipboardEntry::get_id() const {
+    return id_;
+}
+
+void ClipboardEntry::set_id(EntryId id) {
+    id_ = id;
+}
+
+bool ClipboardEntry::is_pinned() const {
+    return pinned_;
+}
+
+void ClipboardEntry::set_pinned(bool pinned) {
+    pinned_ = pinned;
+}
+
 std::string ClipboardEntry::get_formatted_time() const {
     std::tm* tm = std::localtime(&timestamp_);
     std::ostringstream oss;
@@ -36,5 +272,57 @@ std::string ClipboardEntry::get_formatted_time() const {
 }
 
 size_t ClipboardEntry::get_size() const {
-    return text_.size();
+    return size_;
+}
+
+bool ClipboardEntry::compress() {
+    if (!text_) {
+        return true;
+    }
+
+    if (!pack(*text_, compressed_, chunks_)) {
+        return false;
+    }
+    head_ = text_->substr(0, HEAD_LENGTH);
+    text_.reset();
+
+    if (folded_ && kind_ != TextKind::BINARY && pack(*folded_, folded_compressed_, folded_chunks_)) {
+        folded_.reset();
+    }
+    return true;
+}
+
+void ClipboardEntry::decompress() {
+    if (text_) {
+        return;
+    }
+
+    text_ = get_text();
+    compressed_.clear();
+    compressed_.shrink_to_fit();
+    chunks_.clear();
+    head_.clear();
+
+    if (!fold_is_identity_ && folded_size_ < FOLDED_PACK_SIZE) {
+        folded_ = get_search_text();
+        folded_compressed_.clear();
+        folded_compressed_.shrink_to_fit();
+        folded_chunks_.clear();
+    }
+}
+
+bool ClipboardEntry::is_compressed() const {
+    return !text_;
+}
+
+const std::string& ClipboardEntry::get_compressed() const {
+    return compressed_;
+}
+
+bool ClipboardEntry::is_chunked() const {
+    return !chunks_.empty();
+}
+
+const ChunkList& ClipboardEntry::get_chunks() const {
+    return chunks_;
 }
@@ -8,30 +8,145 @@
 
 #include <string>
 #include <ctime>
+#include <memory>
+#include <cstdint>
+
+#include "utf8_validate.hpp"
+#include "chunk_store.hpp"
+#include "near_duplicate.hpp"
+#include "content_facets.hpp"
+
+// Shared, immutable clipboard text
+using ClipboardText = std::shared_ptr<const std::string>;
+
+// Identifies an entry for as long as it lives, whatever its position
+using EntryId = uint64_t;
+const EntryId NO_ENTRY_ID = 0;
 
 class ClipboardEntry {
 public:
-    // Constructor
-    explicit ClipboardEntry(const std::string& text);
-    
-    // Get the text content
-    const std::string& get_text() const;
-    
-    // Get preview text (truncated if too long)
+    // Constructor; validates text and repairs or classifies invalid UTF-8.
+    // Valid text is adopted as is, without copying the buffer.
+    explicit ClipboardEntry(ClipboardText text);
+
+    // Constructor for text already checked at ingest (repaired unless BINARY)
+    ClipboardEntry(ClipboardText text, TextKind kind);
+
+    // Create an entry from an LZ4 block (as stored in the history file)
+    static std::shared_ptr<ClipboardEntry> from_compressed(std::string compressed, size_t raw_size);
+
+    // Create an entry from pooled chunks (as stored in the history file)
+    static std::shared_ptr<ClipboardEntry> from_chunks(ChunkList chunks, size_t raw_size);
+
+    // Get the text content (decompressed on demand for cold entries)
+    ClipboardText get_text() const;
+
+    // Get the case-folded, accent-stripped search text (computed at ingest)
+    ClipboardText get_search_text() const;
+
+    // MinHash signature used to find variants of this text (computed at ingest)
+    const TextSignature& get_signature() const;
+
+    // Kinds of content found in the text (computed at ingest)
+    FacetMask get_facets() const;
+
+    // What validation found in the captured payload
+    TextKind get_text_kind() const;
+    bool is_binary() const;
+
+    // Get preview text (truncated if too long, always valid UTF-8)
     std::string get_preview(size_t max_length = 50) const;
-    
+
     // Get timestamp when entry was created
     std::time_t get_timestamp() const;
-    
+
+    // Restore the creation time of an entry read from the history file
+    void set_timestamp(std::time_t timestamp);
+
+    // Time after which the entry expires (0 if it never does)
+    std::time_t get_expiry() const;
+    void set_expiry(std::time_t expiry);
+
+    // Stable id given by the manager when the entry joins a history stream
+    EntryId get_id() const;
+    void set_id(EntryId id);
+
+    // Pinned entries are kept past the history limit and never expire
+    bool is_pinned() const;
+    void set_pinned(bool pinned);
+
     // Get timestamp as formatted string
     std::string get_formatted_time() const;
-    
+
     // Get size in bytes
     size_t get_size() const;
-    
+
+    // Compress the payload in place; returns false if it does not pay off
+    bool compress();
+
+    // Restore the raw payload of a compressed entry
+    void decompress();
+
+    // Whether the payload is currently held compressed
+    bool is_compressed() const;
+
+    // Drop the shared cache of recently decompressed payloads
+    static void release_decompression_cache();
+
+    // Compressed payload (empty if the entry is not compressed or chunked)
+    const std::string& get_compressed() const;
+
+    // Whether the compressed payload is held as pooled chunks
+    bool is_chunked() const;
+
+    // Chunks of the payload (empty unless the entry is chunked)
+    const ChunkList& get_chunks() const;
+
 private:
-    std::string text_;        // The clipboard text content
+    // Number of leading bytes kept raw so previews skip decompression
+    static const size_t HEAD_LENGTH = 128;
+
+    // Search texts this large are packed as soon as they are built, even
+    // while the payload stays raw, so a large copy is not held twice
+    static const size_t FOLDED_PACK_SIZE = 64 * 1024;
+
+    ClipboardEntry() = default;
+
+    // Build the search text, signature and facets from the raw content
+    void set_search_text(const std::string& text);
+
+    // Set up an entry whose payload was loaded cold from the history file
+    void load_cold(std::string& raw);
+
+    // Move a payload out of the way: chunk large ones, LZ4 the rest.
+    // False if neither pays off.
+    static bool pack(const std::string& raw, std::string& block, ChunkList& chunks);
+
+    // Restore a payload stored by pack()
+    static void unpack(const std::string& block, const ChunkList& chunks, size_t raw_size, std::string& out);
+
+    ClipboardText text_;      // The clipboard text content (null while compressed)
+    std::string compressed_;  // LZ4 block of the content for cold entries
+    ChunkList chunks_;        // Pooled chunks of large cold content (instead of compressed_)
+    std::string head_;        // First bytes of the content while compressed
+    size_t size_ = 0;         // Uncompressed size in bytes
     std::time_t timestamp_;   // When the entry was created
+    std::time_t expiry_ = 0;  // When the entry expires (0 = never)
+    bool pinned_ = false;
+    EntryId id_ = NO_ENTRY_ID;
+    TextKind kind_ = TextKind::UTF8;
+    TextSignature signature_;
+    FacetMask facets_ = 0;
+
+    // Search text; only stored when folding changed something
+    bool fold_is_identity_ = true;
+    ClipboardText folded_;             // Null while packed or identical to the text
+    std::string folded_compressed_;    // LZ4 block of the search text for cold or large entries
+    ChunkList folded_chunks_;          // Pooled chunks of a large cold search text
+    size_t folded_size_ = 0;
+
+    // Last decompressed copy, kept alive by the shared decompression cache
+    mutable std::weak_ptr<const std::string> decompressed_;
 };
 
 #endif // CLIPBOARD_ENTRY_HPP
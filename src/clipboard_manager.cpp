@@ -3,104 +3,559 @@
 // Consulte o arquivo LICENSE para mais informações.
 
  #include "clipboard_manager.hpp"
+ #include "history_file.hpp"
+ #include "x11_selection.hpp"
+ #include "capture_trace.hpp"
+ #include "history_archive.hpp"
+ #include "text_hash.hpp"
+ #include "regex_search.hpp"
+ #include "case_fold.hpp"
+ #include "entry_content.hpp"
+ #include <glib-unix.h>
  #include <iostream>
  #include <cstdio>
  #include <cstdlib>
  #include <array>
  #include <memory>
+ #include <new>
+ #include <algorithm>
+ #include <numeric>
+ #include <unordered_set>
  #include <unistd.h>
  #include <fcntl.h>
  #include <string.h>
  #include <cerrno>
+ #include <poll.h>
+ #include <sys/eventfd.h>
+ 
+ // Whether a shared buffer holds text
+ static bool same_text(const ClipboardText& shared, const std::string& text) {
+     return shared && *shared == text;
+ }
  
  // Define the static constant
  const size_t ClipboardManager::MAX_ENTRIES;
+ const size_t ClipboardManager::MAX_PRIMARY_ENTRIES;
+ const guint ClipboardManager::PRIMARY_DEBOUNCE_MS;
+ const size_t ClipboardManager::HOT_ENTRIES;
+ const size_t ClipboardManager::COMPRESS_MIN_SIZE;
+ const size_t ClipboardManager::COMPRESS_LARGE_SIZE;
+ const size_t ClipboardManager::CAPTURE_RING_SIZE;
+ const guint ClipboardManager::POLL_MIN_MS;
+ const guint ClipboardManager::POLL_MAX_MS;
+ const guint ClipboardManager::POLL_LOCKED_MS;
+ const long ClipboardManager::ARCHIVE_DAYS;
+ const size_t ClipboardManager::ARCHIVE_SEARCH_BYTES;
  
- ClipboardManager::ClipboardManager()
-     : clipboard_(nullptr), updating_clipboard_(false), monitor_source_id_(0) {
+ ClipboardManager::ClipboardManager(const std::string& history_path)
+     : history_path_(history_path), clipboard_(nullptr), corpus_valid_(false), primary_corpus_valid_(false),
+       facet_index_valid_(false), primary_facet_index_valid_(false),
+       replace_near_duplicates_(false), next_entry_id_(1),
+       expiry_policy_(ExpiryPolicy::from_environment()), expiry_wheel_(std::time(nullptr)),
+       expiry_source_(0), expiry_armed_at_(0), next_callback_id_(1),
+       updating_clipboard_(false), primary_tracking_(true), pasted_variant_valid_(false),
+       capture_running_(false), capture_wake_fd_(-1), pending_primary_since_(0),
+       discard_pending_primary_(false), capture_filter_(CaptureFilter::from_environment()),
+       polling_(false), poll_activity_(false), screen_locked_(false),
+       capture_ring_(CAPTURE_RING_SIZE), has_capture_overflow_(false), drain_scheduled_(false),
+       captured_count_(0), dropped_count_(0), coalesced_count_(0), batch_count_(0),
+       latency_buckets_(), latency_max_us_(0) {
      // Get default display for GTK functionality
      GdkDisplay* display = gdk_display_get_default();
      if (display) {
          // Get clipboard for default display (still needed for GTK UI integration)
          clipboard_ = gdk_display_get_clipboard(display);
      }
+     
+     // VMCASTLE_REPLACE_SIMILAR=1 keeps only the newest variant of a text
+     const char* replace_similar = getenv("VMCASTLE_REPLACE_SIMILAR");
+     replace_near_duplicates_ = replace_similar && strcmp(replace_similar, "0") != 0;
+     
+     // Evicted entries go to an archive next to the history file, kept for
+     // VMCASTLE_ARCHIVE_DAYS days (0 disables it)
+     long archive_days = ARCHIVE_DAYS;
+     const char* archive_setting = getenv("VMCASTLE_ARCHIVE_DAYS");
+     if (archive_setting && *archive_setting) {
+         char* end = nullptr;
+         long parsed = strtol(archive_setting, &end, 10);
+         if (*end == '\0' && parsed >= 0) {
+             archive_days = parsed;
+         }
+     }
+     if (!history_path_.empty() && archive_days > 0) {
+         archive_.reset(new HistoryArchive(history_path_ + ".archive", HistoryArchive::period_from_environment(),
+                                           static_cast<std::time_t>(archive_days) * 24 * 60 * 60));
+     }
  }
  
  ClipboardManager::~ClipboardManager() {
      // Stop monitoring
      stop_monitoring();
      
-     // Save clipboard history before closing
-     save_history_to_file();
+     if (expiry_source_ != 0) {
+         g_source_remove(expiry_source_);
+     }
+     
+     // Save clipboard history before closing; an empty one was either never
+     // loaded or already removed from disk
+     if (get_entry_count() > 0) {
+         save_history_to_file();
+     }
+     
+     // Evictions queued behind an archive search
+     std::lock_guard<std::mutex> lock(mutex_);
+     flush_archive_queue(true);
  }
  
  void ClipboardManager::start_monitoring() {
-     // Use xclip-based monitoring for Arch Linux
-     start_xclip_monitoring();
+     // Check if already monitoring
+     if (capture_running_) {
+         return;
+     }
+     
+     // Try to load existing clipboard history from saved file if exists
+     load_history_from_file();
+     
+     // Seal archived entries of past days
+     if (archive_) {
+         std::lock_guard<std::mutex> lock(archive_mutex_);
+         archive_->roll(std::time(nullptr));
+     }
+     
+     // VMCASTLE_RECORD_TRACE=FILE records the capture events for replay, with
+     // their content only if VMCASTLE_RECORD_PAYLOADS=1
+     const char* trace_path = getenv("VMCASTLE_RECORD_TRACE");
+     if (trace_path && *trace_path) {
+         const char* payloads = getenv("VMCASTLE_RECORD_PAYLOADS");
+         trace_writer_.reset(new CaptureTraceWriter());
+         if (!trace_writer_->open(trace_path, payloads && strcmp(payloads, "0") != 0)) {
+             std::cerr << "Could not create capture trace " << trace_path << ": " << strerror(errno) << std::endl;
+             trace_writer_.reset();
+         }
+     }
+     
+     // Polling slows down while the screen is locked and checks again on unlock
+     screen_lock_.start([this](bool locked) {
+         screen_locked_ = locked;
+         if (!locked) {
+             note_user_activity();
+         }
+     });
+     
+     // Capture runs off the GTK main loop; the store drains it in batches
+     start_capture_thread();
+ }
+  
+ void ClipboardManager::start_injected_monitoring() {
+     load_history_from_file();
+     if (archive_) {
+         std::lock_guard<std::mutex> lock(archive_mutex_);
+         archive_->roll(std::time(nullptr));
+     }
  }
  
  void ClipboardManager::stop_monitoring() {
-     stop_xclip_monitoring();
+     stop_capture_thread();
+     screen_lock_.stop();
+     screen_locked_ = false;
+     
+     if (trace_writer_) {
+         trace_writer_->close();
+         trace_writer_.reset();
+     }
  }
  
- void ClipboardManager::start_xclip_monitoring() {
-     // Check if already monitoring
-     if (monitor_source_id_ != 0) {
+ void ClipboardManager::start_capture_thread() {
+     capture_wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+     capture_running_ = true;
+     capture_thread_ = std::thread(&ClipboardManager::capture_loop, this);
+ }
+ 
+ void ClipboardManager::stop_capture_thread() {
+     if (!capture_running_) {
          return;
      }
      
-     // Try to load existing clipboard history from saved file if exists
-     load_history_from_file();
+     capture_running_ = false;
+     uint64_t one = 1;
+     if (write(capture_wake_fd_, &one, sizeof(one)) < 0) {
+         std::cerr << "Could not wake the capture thread: " << strerror(errno) << std::endl;
+     }
+     
+     if (capture_thread_.joinable()) {
+         capture_thread_.join();
+     }
+     close(capture_wake_fd_);
+     capture_wake_fd_ = -1;
+ }
+ 
+ void ClipboardManager::capture_loop() {
+     // Prefer owner change notifications; without XFixes, poll the owners over
+     // the same connection, and through xclip when there is no connection
+     std::unique_ptr<X11Selection> source = X11Selection::open();
+     if (source && source->watch_selections()) {
+         run_x11_capture(*source);
+     } else {
+         polling_ = true;
+         run_polling_capture(source.get());
+         polling_ = false;
+     }
+ }
+ 
+ void ClipboardManager::run_x11_capture(X11Selection& source) {
+     std::string content;
+     
+     // Pick up whatever the clipboard holds at startup
+     if (wants_selection(&source, Selection::CLIPBOARD) && source.fetch_text(Selection::CLIPBOARD, content)) {
+         ClipboardText text = std::make_shared<const std::string>(std::move(content));
+         seen_clipboard_content_.remember(text);
+         publish_capture(Selection::CLIPBOARD, std::move(text));
+     }
+     
+     // Deadline (monotonic us) at which a settled PRIMARY selection is read, 0 if none
+     gint64 primary_deadline = 0;
+     
+     while (capture_running_) {
+         int timeout_ms = -1;
+         if (primary_deadline != 0) {
+             timeout_ms = static_cast<int>(std::max<gint64>(0, (primary_deadline - g_get_monotonic_time()) / 1000));
+         }
+         if (has_capture_overflow_) {
+             timeout_ms = timeout_ms < 0 ? 50 : std::min(timeout_ms, 50);
+         }
+         
+         pollfd fds[2] = {{source.get_fd(), POLLIN, 0}, {capture_wake_fd_, POLLIN, 0}};
+         poll(fds, 2, timeout_ms);
+         if (!capture_running_) {
+             break;
+         }
+         
+         for (Selection selection : source.read_changes()) {
+             if (selection == Selection::CLIPBOARD) {
+                 if (wants_selection(&source, Selection::CLIPBOARD) &&
+                     source.fetch_text(Selection::CLIPBOARD, content) && !content.empty() &&
+                     !seen_clipboard_content_.matches(content)) {
+                     ClipboardText text = std::make_shared<const std::string>(std::move(content));
+                     seen_clipboard_content_.remember(text);
+                     publish_capture(Selection::CLIPBOARD, std::move(text));
+                 }
+             } else if (primary_tracking_) {
+                 // Each drag step re-announces ownership; only read once it goes quiet
+                 primary_deadline = g_get_monotonic_time() + static_cast<gint64>(PRIMARY_DEBOUNCE_MS) * 1000;
+             }
+         }
+         
+         if (primary_deadline != 0 && g_get_monotonic_time() >= primary_deadline) {
+             primary_deadline = 0;
+             if (wants_selection(&source, Selection::PRIMARY) &&
+                 source.fetch_text(Selection::PRIMARY, content) && !content.empty() &&
+                 !seen_primary_content_.matches(content) && !seen_clipboard_content_.matches(content)) {
+                 ClipboardText text = std::make_shared<const std::string>(std::move(content));
+                 seen_primary_content_.remember(text);
+                 publish_capture(Selection::PRIMARY, std::move(text));
+             }
+         }
+         
+         // Retry an event that did not fit in the ring
+         flush_capture_overflow();
+     }
+ }
+ 
+ struct ClipboardManager::PollState {
+     ClipboardManager* manager;
+     X11Selection* source;
+     GMainContext* context;
+     GMainLoop* loop;
+     GSource* timer;
+     PollBackoff backoff;
+ };
+ 
+ void ClipboardManager::run_polling_capture(X11Selection* source) {
+     // The loop runs on a context of its own so its timers never land on the
+     // GTK main loop; long intervals use second timers, which GLib wakes
+     // together with the other second timers of the session
+     GMainContext* context = g_main_context_new();
+     g_main_context_push_thread_default(context);
      
-     // Try to get initial clipboard content
-     last_clipboard_content_ = execute_xclip("-o -selection clipboard 2>/dev/null");
+     PollState state = {this, source, context, g_main_loop_new(context, FALSE), nullptr,
+                        PollBackoff(POLL_MIN_MS, POLL_MAX_MS, POLL_LOCKED_MS)};
      
-     // If we got content from clipboard, add it to history
-     if (!last_clipboard_content_.empty()) {
-         add_entry(last_clipboard_content_);
+     // stop_capture_thread() and note_user_activity() write to the eventfd
+     GSource* wake = g_unix_fd_source_new(capture_wake_fd_, G_IO_IN);
+     g_source_set_callback(wake, G_SOURCE_FUNC(on_poll_wake), &state, nullptr);
+     g_source_attach(wake, context);
+     
+     poll_selections(state);
+     if (capture_running_) {
+         g_main_loop_run(state.loop);
      }
      
-     // Set up a timer to check for clipboard changes
-     // Check every 500ms (adjust as needed for performance vs responsiveness)
-     monitor_source_id_ = g_timeout_add(500, check_clipboard_changes, this);
+     if (state.timer) {
+         g_source_destroy(state.timer);
+         g_source_unref(state.timer);
+     }
+     g_source_destroy(wake);
+     g_source_unref(wake);
+     g_main_loop_unref(state.loop);
+     g_main_context_pop_thread_default(context);
+     g_main_context_unref(context);
+ }
+ 
+ gboolean ClipboardManager::on_poll_timer(gpointer user_data) {
+     PollState* state = static_cast<PollState*>(user_data);
+     g_source_unref(state->timer);
+     state->timer = nullptr;
+     state->manager->poll_selections(*state);
+     return G_SOURCE_REMOVE;
  }
  
- void ClipboardManager::stop_xclip_monitoring() {
-     if (monitor_source_id_ != 0) {
-         g_source_remove(monitor_source_id_);
-         monitor_source_id_ = 0;
+ gboolean ClipboardManager::on_poll_wake(gint fd, GIOCondition condition G_GNUC_UNUSED, gpointer user_data) {
+     PollState* state = static_cast<PollState*>(user_data);
+     uint64_t count = 0;
+     if (read(fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+         std::cerr << "Could not read the capture wakeup: " << strerror(errno) << std::endl;
      }
+     
+     if (!state->manager->capture_running_) {
+         g_main_loop_quit(state->loop);
+     } else {
+         state->manager->poll_selections(*state);
+     }
+     return G_SOURCE_CONTINUE;
  }
  
- std::vector<std::shared_ptr<ClipboardEntry>> ClipboardManager::get_entries() const {
+ void ClipboardManager::poll_selections(PollState& state) {
+     flush_capture_overflow();
+     
+     // Poll fast while things change or the user is around, and back off
+     // exponentially while nothing does
+     bool activity = check_clipboard_changes(state.source);
+     if (poll_activity_.exchange(false) || activity) {
+         state.backoff.reset();
+     }
+     guint delay_ms = state.backoff.next(screen_locked_);
+     
+     // Come back on time for a settling PRIMARY selection or a full ring
+     if (pending_primary_content_) {
+         gint64 settled_at = pending_primary_since_ + static_cast<gint64>(PRIMARY_DEBOUNCE_MS) * 1000;
+         gint64 wait_ms = std::max<gint64>(0, (settled_at - g_get_monotonic_time()) / 1000) + 1;
+         delay_ms = std::min<guint>(delay_ms, static_cast<guint>(wait_ms));
+     }
+     if (has_capture_overflow_) {
+         delay_ms = std::min<guint>(delay_ms, 50);
+     }
+     schedule_poll(state, delay_ms);
+ }
+ 
+ void ClipboardManager::schedule_poll(PollState& state, guint delay_ms) {
+     if (state.timer) {
+         g_source_destroy(state.timer);
+         g_source_unref(state.timer);
+     }
+     state.timer = delay_ms >= 1000 ? g_timeout_source_new_seconds(delay_ms / 1000) : g_timeout_source_new(delay_ms);
+     g_source_set_callback(state.timer, on_poll_timer, &state, nullptr);
+     g_source_attach(state.timer, state.context);
+ }
+ 
+ void ClipboardManager::note_user_activity() {
+     // Only the polling backend sleeps between checks
+     if (!polling_ || !capture_running_) {
+         return;
+     }
+     poll_activity_ = true;
+     uint64_t one = 1;
+     if (write(capture_wake_fd_, &one, sizeof(one)) < 0) {
+         std::cerr << "Could not wake the capture thread: " << strerror(errno) << std::endl;
+     }
+ }
+ 
+ CaptureStats ClipboardManager::get_capture_stats() const {
+     CaptureStats stats;
+     stats.captured = captured_count_;
+     stats.dropped = dropped_count_;
+     stats.coalesced = coalesced_count_;
+     stats.batches = batch_count_;
+     
      std::lock_guard<std::mutex> lock(mutex_);
-     return entries_;
+     std::copy(latency_buckets_, latency_buckets_ + LATENCY_BUCKETS, stats.latency_buckets);
+     stats.latency_max_us = latency_max_us_;
+     return stats;
  }
  
- std::shared_ptr<ClipboardEntry> ClipboardManager::get_entry(size_t index) const {
+ void ClipboardManager::inject_capture(Selection selection, ClipboardText text) {
+     publish_capture(selection, std::move(text));
+ }
+ 
+ bool ClipboardManager::flush_injection() {
+     flush_capture_overflow();
+     return !has_capture_overflow_;
+ }
+ 
+ void ClipboardManager::finish_injection() {
+     while (!flush_injection()) {
+         usleep(1000);
+     }
+ }
+ 
+ void ClipboardManager::set_primary_tracking(bool enabled) {
+     primary_tracking_ = enabled;
+ }
+ 
+ bool ClipboardManager::get_primary_tracking() const {
+     return primary_tracking_;
+ }
+ 
+ std::vector<std::shared_ptr<ClipboardEntry>>& ClipboardManager::entries_for(Selection selection) {
+     return selection == Selection::PRIMARY ? primary_entries_ : entries_;
+ }
+ 
+ const std::vector<std::shared_ptr<ClipboardEntry>>& ClipboardManager::entries_for(Selection selection) const {
+     return selection == Selection::PRIMARY ? primary_entries_ : entries_;
+ }
+ 
+ size_t ClipboardManager::capacity_for(Selection selection) const {
+     return selection == Selection::PRIMARY ? MAX_PRIMARY_ENTRIES : MAX_ENTRIES;
+ }
+ 
+ std::vector<std::shared_ptr<ClipboardEntry>> ClipboardManager::get_entries(Selection selection) const {
+     std::lock_guard<std::mutex> lock(mutex_);
+     return entries_for(selection);
+ }
+ 
+ std::vector<std::shared_ptr<ClipboardEntry>> ClipboardManager::get_recent_entries(size_t count, Selection selection) const {
+     std::lock_guard<std::mutex> lock(mutex_);
+     const auto& entries = entries_for(selection);
+     return std::vector<std::shared_ptr<ClipboardEntry>>(entries.begin(),
+                                                         entries.begin() + std::min(count, entries.size()));
+ }
+ 
+ std::shared_ptr<ClipboardEntry> ClipboardManager::get_entry(size_t index, Selection selection) const {
      std::lock_guard<std::mutex> lock(mutex_);
-     if (index < entries_.size()) {
-         return entries_[index];
+     const auto& entries = entries_for(selection);
+     if (index < entries.size()) {
+         return entries[index];
      }
      return nullptr;
  }
  
- size_t ClipboardManager::get_entry_count() const {
+ size_t ClipboardManager::get_entry_count(Selection selection) const {
+     std::lock_guard<std::mutex> lock(mutex_);
+     return entries_for(selection).size();
+ }
+ 
+ std::shared_ptr<ClipboardEntry> ClipboardManager::find_entry(EntryId id) const {
      std::lock_guard<std::mutex> lock(mutex_);
-     return entries_.size();
+     auto it = entries_by_id_.find(id);
+     return it != entries_by_id_.end() ? it->second.entry : nullptr;
  }
  
- bool ClipboardManager::copy_to_clipboard(size_t index) {
+ bool ClipboardManager::copy_to_clipboard(EntryId id) {
      std::lock_guard<std::mutex> lock(mutex_);
-     if (index >= entries_.size()) {
+     auto found = entries_by_id_.find(id);
+     if (found == entries_by_id_.end()) {
+         // An archive search result comes back into the history
+         auto archived = archive_results_.find(id);
+         if (archived == archive_results_.end() || !set_system_clipboard(archived->second->get_text())) {
+             return false;
+         }
+         insert_entry(archived->second->get_text(), Selection::CLIPBOARD);
+         archive_results_.erase(archived);
+         notify_callbacks(Selection::CLIPBOARD);
+         return true;
+     }
+     const TrackedEntry& tracked = found->second;
+     
+     if (!set_system_clipboard(tracked.entry->get_text())) {
+         return false;
+     }
+     
+     // Move the copied entry to the front
+     auto& entries = entries_for(tracked.selection);
+     auto it = std::find(entries.begin(), entries.end(), tracked.entry);
+     std::rotate(entries.begin(), it, it + 1);
+     apply_compression_policy(entries);
+     invalidate_corpus(tracked.selection);
+     return true;
+ }
+ 
+ bool ClipboardManager::paste_transformed(EntryId id, const std::vector<PasteTransform>& transforms) {
+     std::unique_ptr<EntryContent> content;
+     {
+         std::lock_guard<std::mutex> lock(mutex_);
+         std::shared_ptr<ClipboardEntry> entry;
+         auto found = entries_by_id_.find(id);
+         if (found != entries_by_id_.end()) {
+             entry = found->second.entry;
+         } else {
+             // Archive search results can be pasted as a variant too
+             auto archived = archive_results_.find(id);
+             if (archived == archive_results_.end()) {
+                 return false;
+             }
+             entry = archived->second;
+         }
+         if (entry->is_binary()) {
+             return false;
+         }
+         
+         // The snapshot holds its own references; no need to keep the lock
+         content.reset(new EntryContent(*entry));
+     }
+     
+     // A first pass sizes and hashes the output, and finds content a stage
+     // rejects before anything reaches the selections
+     TransformedSize variant;
+     if (!run_paste_transforms(*content, transforms, [](const char*, size_t) { return true; }, &variant) ||
+         variant.size == 0) {
+         return false;
+     }
+     
+     if (!stream_to_system_clipboard(*content, transforms)) {
          return false;
      }
      
+     // The capture will see the variant come back; it is served, not stored
+     pasted_variant_ = variant;
+     pasted_variant_valid_ = true;
+     return true;
+ }
+ 
+ bool ClipboardManager::stream_to_system_clipboard(const EntryContent& content,
+                                                   const std::vector<PasteTransform>& transforms) {
      // Set updating flag to prevent recursive clipboard changes
      updating_clipboard_ = true;
      
-     // Get the entry text
-     const std::string& text = entries_[index]->get_text();
+     // xclip -f passes its input on, so one stream fills both selections
+     FILE* pipe = popen("xclip -selection clipboard -i -f 2>/dev/null | xclip -selection primary -i >/dev/null 2>&1", "w");
+     if (!pipe) {
+         std::cerr << "Error running xclip command" << std::endl;
+         updating_clipboard_ = false;
+         return false;
+     }
+     
+     bool written = run_paste_transforms(content, transforms, [pipe](const char* data, size_t size) {
+         return fwrite(data, 1, size, pipe) == size;
+     });
+     int result = pclose(pipe);
+     
+     if (!written || result != 0) {
+         std::cerr << "Error running xclip command" << std::endl;
+         updating_clipboard_ = false;
+         return false;
+     }
+     
+     // No entry holds what the selections have now
+     last_clipboard_content_.reset();
+     last_primary_content_.reset();
+     discard_pending_primary_ = true;
+     
+     updating_clipboard_ = false;
+     return true;
+ }
+ 
+ bool ClipboardManager::set_system_clipboard(const ClipboardText& text) {
+     // Set updating flag to prevent recursive clipboard changes
+     updating_clipboard_ = true;
      
      try {
          // Create a temporary file to store the text
@@ -122,7 +577,7 @@
              return false;
          }
          
-         fwrite(text.c_str(), sizeof(char), text.length(), file);
+         fwrite(text->c_str(), sizeof(char), text->length(), file);
          fclose(file);
          
          // Use xclip to set both clipboard and primary selection content
@@ -153,35 +608,496 @@
          return false;
      }
      
-     // Update last clipboard content
-     last_clipboard_content_ = text;
-     
-     // Move the copied entry to the front
-     auto entry = entries_[index];
-     entries_.erase(entries_.begin() + index);
-     entries_.insert(entries_.begin(), entry);
+     // Update last clipboard content (both selections now hold it)
+     last_clipboard_content_.remember(text);
+     last_primary_content_.remember(text);
+     discard_pending_primary_ = true;
+     pasted_variant_valid_ = false;
      
      updating_clipboard_ = false;
      return true;
  }
  
- void ClipboardManager::clear_entries() {
+ void ClipboardManager::clear_entries(Selection selection) {
      std::lock_guard<std::mutex> lock(mutex_);
-     entries_.clear();
-     notify_callbacks();
+     auto& entries = entries_for(selection);
+     for (const auto& entry : entries) {
+         entries_by_id_.erase(entry->get_id());
+     }
+     entries.clear();
+     near_index_for(selection).clear();
+     notify_callbacks(selection);
+     if (selection == Selection::CLIPBOARD) {
+         save_history_locked();
+     }
+ }
+ 
+ bool ClipboardManager::remove_entry(EntryId id) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     auto found = entries_by_id_.find(id);
+     if (found == entries_by_id_.end()) {
+         return false;
+     }
+     Selection selection = found->second.selection;
+     
+     // Same path as bulk removal, so the change is saved and the hot set kept
+     const auto& entries = entries_for(selection);
+     std::vector<bool> doomed(entries.size(), false);
+     doomed[std::find(entries.begin(), entries.end(), found->second.entry) - entries.begin()] = true;
+     return remove_marked(doomed, selection) > 0;
+ }
+ 
+ size_t ClipboardManager::remove_entries(const std::vector<EntryId>& ids) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     
+     // Resolve the ids, then flag their positions stream by stream
+     std::unordered_set<const ClipboardEntry*> marked;
+     for (EntryId id : ids) {
+         auto found = entries_by_id_.find(id);
+         if (found != entries_by_id_.end()) {
+             marked.insert(found->second.entry.get());
+         }
+     }
+     
+     size_t removed = 0;
+     for (Selection selection : {Selection::CLIPBOARD, Selection::PRIMARY}) {
+         const auto& entries = entries_for(selection);
+         std::vector<bool> doomed(entries.size(), false);
+         for (size_t i = 0; i < entries.size(); ++i) {
+             doomed[i] = marked.count(entries[i].get()) > 0;
+         }
+         removed += remove_marked(doomed, selection);
+     }
+     return removed;
+ }
+ 
+ size_t ClipboardManager::remove_matches(const std::string& query, SearchMode mode, Selection selection,
+                                         std::string* error, FacetMask facets) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     auto& entries = entries_for(selection);
+     
+     std::vector<size_t> matches;
+     bool valid = search_entries(entries, query, mode, matches, error, &corpus_for(selection));
+     if (!valid) {
+         return 0;
+     }
+     facet_index_for(selection).filter(facets, matches);
+     
+     // Pinned entries survive bulk cleanup
+     std::vector<bool> doomed(entries.size(), false);
+     for (size_t index : matches) {
+         doomed[index] = !entries[index]->is_pinned();
+     }
+     return remove_marked(doomed, selection);
+ }
+ 
+ size_t ClipboardManager::remove_marked(const std::vector<bool>& doomed, Selection selection) {
+     auto& entries = entries_for(selection);
+     
+     // One compaction pass, however many entries go
+     size_t kept = 0;
+     for (size_t i = 0; i < entries.size(); ++i) {
+         if (doomed[i]) {
+             untrack_entry(entries[i].get(), selection);
+         } else {
+             entries[kept++] = std::move(entries[i]);
+         }
+     }
+     size_t removed = entries.size() - kept;
+     entries.resize(kept);
+     
+     if (removed > 0) {
+         apply_compression_policy(entries);
+         notify_callbacks(selection);
+         if (selection == Selection::CLIPBOARD) {
+             save_history_locked();
+         }
+     }
+     return removed;
  }
  
- void ClipboardManager::remove_entry(size_t index) {
+ size_t ClipboardManager::set_entries_pinned(const std::vector<EntryId>& ids, bool pinned) {
      std::lock_guard<std::mutex> lock(mutex_);
-     if (index < entries_.size()) {
-         entries_.erase(entries_.begin() + index);
-         notify_callbacks();
+     std::time_t now = std::time(nullptr);
+     
+     size_t changed = 0;
+     bool clipboard_changed = false;
+     bool primary_changed = false;
+     for (EntryId id : ids) {
+         auto found = entries_by_id_.find(id);
+         if (found == entries_by_id_.end() || found->second.entry->is_pinned() == pinned) {
+             continue;
+         }
+         const auto& entry = found->second.entry;
+         Selection selection = found->second.selection;
+         entry->set_pinned(pinned);
+         (selection == Selection::PRIMARY ? primary_changed : clipboard_changed) = true;
+         changed++;
+         
+         // Expiry timers skip pinned entries; give an unpinned one a new timer
+         if (!pinned && entry->get_expiry() != 0) {
+             std::time_t deadline = std::max(entry->get_expiry(), now);
+             expiry_wheel_.schedule(ExpiryTimer{entry, selection}, static_cast<uint64_t>(deadline));
+         }
+     }
+     
+     if (changed > 0) {
+         arm_expiry_timer();
+     }
+     if (primary_changed) {
+         notify_callbacks(Selection::PRIMARY);
      }
+     if (clipboard_changed) {
+         notify_callbacks(Selection::CLIPBOARD);
+         save_history_locked();
+     }
+     return changed;
  }
  
- void ClipboardManager::register_callback(ClipboardChangedCallback callback) {
+ bool ClipboardManager::copy_entries(const std::vector<EntryId>& ids, const std::string& separator) {
      std::lock_guard<std::mutex> lock(mutex_);
-     callbacks_.push_back(callback);
+     
+     // Size the buffer once, then append each text in the given order
+     std::vector<ClipboardText> texts;
+     size_t total = 0;
+     for (EntryId id : ids) {
+         auto found = entries_by_id_.find(id);
+         if (found != entries_by_id_.end()) {
+             texts.push_back(found->second.entry->get_text());
+             total += texts.back()->size() + (texts.size() > 1 ? separator.size() : 0);
+         }
+     }
+     if (texts.empty()) {
+         return false;
+     }
+     
+     std::string joined;
+     joined.reserve(total);
+     for (size_t i = 0; i < texts.size(); ++i) {
+         if (i > 0) {
+             joined += separator;
+         }
+         joined += *texts[i];
+     }
+     return set_system_clipboard(std::make_shared<const std::string>(std::move(joined)));
+ }
+ 
+ bool ClipboardManager::search(const std::string& query, SearchMode mode, Selection selection,
+                               std::vector<std::shared_ptr<ClipboardEntry>>& entries,
+                               std::vector<size_t>& matches, std::string* error, FacetMask facets) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     entries = entries_for(selection);
+     
+     // A type filter alone is read straight off the bitmaps, and no filter
+     // at all lists everything without packing a corpus
+     if (query.empty() && facets != 0) {
+         facet_index_for(selection).select(facets, matches);
+         return true;
+     }
+     if (query.empty() && mode == SearchMode::EXACT) {
+         matches.resize(entries.size());
+         std::iota(matches.begin(), matches.end(), size_t(0));
+         return true;
+     }
+     
+     // Searches scan the packed corpus; pack it on first use after a change
+     bool valid = search_entries(entries, query, mode, matches, error, &corpus_for(selection));
+     if (valid) {
+         facet_index_for(selection).filter(facets, matches);
+     }
+     return valid;
+ }
+ 
+ ClipboardManager::HistorySnapshot ClipboardManager::snapshot_history() const {
+     std::lock_guard<std::mutex> lock(mutex_);
+     HistorySnapshot history;
+     history.reserve(entries_.size());
+     for (const auto& entry : entries_) {
+         ClipboardText text = entry->get_text();
+         history.emplace(text->size(), hash_text(*text));
+     }
+     return history;
+ }
+ 
+ bool ClipboardManager::search_archive(const std::string& query, SearchMode mode, std::time_t since, std::time_t until,
+                                       size_t limit, const HistorySnapshot& history,
+                                       std::vector<std::shared_ptr<ClipboardEntry>>& results,
+                                       bool* complete, std::string* error, FacetMask facets) {
+     results.clear();
+     if (complete) {
+         *complete = true;
+     }
+     
+     std::shared_ptr<const RegexQuery> regex;
+     std::string folded_query;
+     if (mode == SearchMode::REGEX && !query.empty()) {
+         regex = RegexQuery::compile(query, error);
+         if (!regex) {
+             return false;
+         }
+     } else {
+         folded_query = fold_text(query);
+     }
+     
+     {
+         std::lock_guard<std::mutex> lock(mutex_);
+         archive_results_.clear();
+         if (!archive_ || limit == 0) {
+             return true;
+         }
+         flush_archive_queue(false);
+     }
+     
+     // Only the newest copy of a text is read; older ones are skipped by hash
+     std::unordered_set<uint64_t> seen;
+     std::vector<ArchivedText> found;
+     bool finished;
+     {
+         std::lock_guard<std::mutex> lock(archive_mutex_);
+         finished = archive_->scan(since, until,
+             [&](uint64_t hash) { return seen.count(hash) == 0; },
+             [&](const ArchivedText& archived) {
+                 seen.insert(archived.hash);
+                 
+                 // Archived texts carry no tags; classifying is cheaper than folding
+                 if (facets != 0 && (classify_content(archived.text) & facets) != facets) {
+                     return true;
+                 }
+                 bool match = regex ? regex->matches(archived.text)
+                                    : folded_query.empty() ||
+                                      fold_text(archived.text).find(folded_query) != std::string::npos;
+                 if (!match) {
+                     return true;
+                 }
+                 
+                 // Texts copied again since they were archived show in the history
+                 auto same_size = history.equal_range(archived.text.size());
+                 for (auto it = same_size.first; it != same_size.second; ++it) {
+                     if (it->second == archived.hash) {
+                         return true;
+                     }
+                 }
+                 
+                 found.push_back(archived);
+                 return found.size() < limit;
+             }, ARCHIVE_SEARCH_BYTES);
+     }
+     
+     for (ArchivedText& archived : found) {
+         auto entry = std::make_shared<ClipboardEntry>(std::make_shared<const std::string>(std::move(archived.text)));
+         entry->set_timestamp(archived.timestamp);
+         results.push_back(entry);
+     }
+     
+     std::lock_guard<std::mutex> lock(mutex_);
+     for (const auto& entry : results) {
+         entry->set_id(next_entry_id_++);
+         archive_results_[entry->get_id()] = entry;
+     }
+     
+     if (complete) {
+         *complete = finished;
+     }
+     return true;
+ }
+ 
+ void ClipboardManager::set_expiry_policy(const ExpiryPolicy& policy) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     expiry_policy_ = policy;
+ }
+ 
+ ExpiryPolicy ClipboardManager::get_expiry_policy() const {
+     std::lock_guard<std::mutex> lock(mutex_);
+     return expiry_policy_;
+ }
+ 
+ bool ClipboardManager::set_entry_ttl(EntryId id, std::time_t ttl) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     auto found = entries_by_id_.find(id);
+     if (found == entries_by_id_.end()) {
+         return false;
+     }
+     schedule_expiry(found->second.entry, found->second.selection, ttl);
+     return true;
+ }
+ 
+ void ClipboardManager::schedule_expiry(const std::shared_ptr<ClipboardEntry>& entry, Selection selection, std::time_t ttl) {
+     if (ttl <= 0) {
+         entry->set_expiry(0);
+         return;
+     }
+     
+     std::time_t expiry = std::time(nullptr) + ttl;
+     entry->set_expiry(expiry);
+     
+     // A renewed entry already has a timer; it reschedules itself when it fires
+     expiry_wheel_.schedule(ExpiryTimer{entry, selection}, static_cast<uint64_t>(expiry));
+     arm_expiry_timer();
+ }
+ 
+ void ClipboardManager::arm_expiry_timer() {
+     uint64_t delay = expiry_wheel_.next_delay();
+     if (delay == 0) {
+         return;
+     }
+     
+     // Keep the armed timer if it fires no later than needed
+     std::time_t fire_at = std::time(nullptr) + static_cast<std::time_t>(delay);
+     if (expiry_source_ != 0) {
+         if (expiry_armed_at_ <= fire_at) {
+             return;
+         }
+         g_source_remove(expiry_source_);
+     }
+     
+     expiry_armed_at_ = fire_at;
+     expiry_source_ = g_timeout_add_seconds(static_cast<guint>(delay), on_expiry_timer, this);
+ }
+ 
+ gboolean ClipboardManager::on_expiry_timer(gpointer user_data) {
+     ClipboardManager* self = static_cast<ClipboardManager*>(user_data);
+     self->expiry_source_ = 0;
+     self->expire_entries();
+     return G_SOURCE_REMOVE;
+ }
+ 
+ void ClipboardManager::expire_entries() {
+     bool clipboard_changed = false;
+     bool primary_changed = false;
+     {
+         std::lock_guard<std::mutex> lock(mutex_);
+         std::time_t now = std::time(nullptr);
+         
+         expiry_wheel_.advance(static_cast<uint64_t>(now), [&](ExpiryTimer& timer) {
+             auto entry = timer.entry.lock();
+             
+             // Removed or evicted meanwhile, or made permanent; pinned
+             // entries are rescheduled when they are unpinned
+             if (!entry || entry->get_expiry() == 0 || entry->is_pinned()) {
+                 return;
+             }
+             
+             // Renewed since this timer was set
+             if (entry->get_expiry() > now) {
+                 expiry_wheel_.schedule(timer, static_cast<uint64_t>(entry->get_expiry()));
+                 return;
+             }
+             
+             auto& entries = entries_for(timer.selection);
+             auto it = std::find(entries.begin(), entries.end(), entry);
+             if (it != entries.end()) {
+                 untrack_entry(entry.get(), timer.selection);
+                 entries.erase(it);
+                 (timer.selection == Selection::PRIMARY ? primary_changed : clipboard_changed) = true;
+             }
+         });
+         
+         if (clipboard_changed) {
+             notify_callbacks(Selection::CLIPBOARD);
+         }
+         if (primary_changed) {
+             notify_callbacks(Selection::PRIMARY);
+         }
+         
+         arm_expiry_timer();
+     }
+     
+     // Drop expired entries from disk right away rather than at exit
+     if (clipboard_changed) {
+         save_history_to_file();
+     }
+ }
+ 
+ SearchCorpus& ClipboardManager::corpus_for(Selection selection) {
+     bool& valid = selection == Selection::PRIMARY ? primary_corpus_valid_ : corpus_valid_;
+     SearchCorpus& corpus = selection == Selection::PRIMARY ? primary_corpus_ : corpus_;
+     if (!valid) {
+         corpus.build(entries_for(selection));
+         valid = true;
+     }
+     return corpus;
+ }
+ 
+ FacetIndex& ClipboardManager::facet_index_for(Selection selection) {
+     bool& valid = selection == Selection::PRIMARY ? primary_facet_index_valid_ : facet_index_valid_;
+     FacetIndex& index = selection == Selection::PRIMARY ? primary_facet_index_ : facet_index_;
+     if (!valid) {
+         index.build(entries_for(selection));
+         valid = true;
+     }
+     return index;
+ }
+ 
+ void ClipboardManager::invalidate_corpus(Selection selection) {
+     if (selection == Selection::PRIMARY) {
+         primary_corpus_valid_ = false;
+         primary_corpus_.clear();
+         primary_facet_index_valid_ = false;
+         primary_facet_index_.clear();
+     } else {
+         corpus_valid_ = false;
+         corpus_.clear();
+         facet_index_valid_ = false;
+         facet_index_.clear();
+     }
+ }
+ 
+ void ClipboardManager::release_caches() {
+     std::lock_guard<std::mutex> lock(mutex_);
+     invalidate_corpus(Selection::CLIPBOARD);
+     invalidate_corpus(Selection::PRIMARY);
+     ClipboardEntry::release_decompression_cache();
+ }
+ 
+ void ClipboardManager::release_search_corpora() {
+     std::lock_guard<std::mutex> lock(mutex_);
+     corpus_valid_ = false;
+     corpus_.clear();
+     primary_corpus_valid_ = false;
+     primary_corpus_.clear();
+ }
+ 
+ NearDuplicateIndex& ClipboardManager::near_index_for(Selection selection) {
+     return selection == Selection::PRIMARY ? primary_near_index_ : near_index_;
+ }
+ 
+ void ClipboardManager::track_entry(const std::shared_ptr<ClipboardEntry>& entry, Selection selection) {
+     entry->set_id(next_entry_id_++);
+     entries_by_id_.emplace(entry->get_id(), TrackedEntry{entry, selection});
+     near_index_for(selection).add(entry.get());
+ }
+ 
+ void ClipboardManager::untrack_entry(const ClipboardEntry* entry, Selection selection) {
+     near_index_for(selection).remove(entry);
+     entries_by_id_.erase(entry->get_id());
+ }
+ 
+ void ClipboardManager::set_replace_near_duplicates(bool enabled) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     replace_near_duplicates_ = enabled;
+ }
+ 
+ bool ClipboardManager::get_replace_near_duplicates() const {
+     std::lock_guard<std::mutex> lock(mutex_);
+     return replace_near_duplicates_;
+ }
+ 
+ ClipboardManager::CallbackId ClipboardManager::register_callback(ClipboardChangedCallback callback,
+                                                                  Selection selection) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     CallbackId id = next_callback_id_++;
+     auto& callbacks = selection == Selection::PRIMARY ? primary_callbacks_ : callbacks_;
+     callbacks.emplace_back(id, std::move(callback));
+     return id;
+ }
+ 
+ void ClipboardManager::unregister_callback(CallbackId id) {
+     std::lock_guard<std::mutex> lock(mutex_);
+     for (auto* callbacks : {&callbacks_, &primary_callbacks_}) {
+         callbacks->erase(std::remove_if(callbacks->begin(), callbacks->end(),
+             [id](const std::pair<CallbackId, ClipboardChangedCallback>& registered) { return registered.first == id; }),
+             callbacks->end());
+     }
  }
  
  void ClipboardManager::on_clipboard_changed(GdkClipboard* clipboard, gpointer user_data) {
@@ -207,53 +1123,155 @@
          }, self);
  }
  
- void ClipboardManager::add_entry(const std::string& text) {
+ void ClipboardManager::add_entry(const std::string& text, Selection selection) {
      // Don't add empty text
      if (text.empty()) {
          return;
      }
      
      std::lock_guard<std::mutex> lock(mutex_);
+     insert_entry(std::make_shared<const std::string>(text), selection);
+     
+     // Notify callbacks
+     notify_callbacks(selection);
+ }
+ 
+ void ClipboardManager::insert_entry(ClipboardText captured, Selection selection) {
+     auto& entries = entries_for(selection);
+     
+     // Validate once at ingest; entries hold repaired text so that rendering,
+     // search and deduplication never see invalid UTF-8
+     TextKind kind = TextKind::UTF8;
+     if (!utf8_is_valid(captured->data(), captured->size())) {
+         std::string repaired;
+         kind = repair_utf8(*captured, repaired);
+         if (kind == TextKind::REPAIRED) {
+             captured = std::make_shared<const std::string>(std::move(repaired));
+         }
+     }
+     const std::string& text = *captured;
      
      // Check if text already exists
      // Use manual loop instead of std::find_if for better compiler compatibility
-     auto it = entries_.end();
-     for (auto iter = entries_.begin(); iter != entries_.end(); ++iter) {
-         if ((*iter)->get_text() == text) {
+     auto it = entries.end();
+     for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+         // Compare sizes first so cold entries are only decompressed on a likely match
+         if ((*iter)->get_size() == text.size() && *(*iter)->get_text() == text) {
              it = iter;
              break;
          }
      }
      
-     if (it != entries_.end()) {
-         // Move existing entry to front
+     if (it != entries.end()) {
+         // Move existing entry to front; copying it again renews its lifetime
          auto entry = *it;
-         entries_.erase(it);
-         entries_.insert(entries_.begin(), entry);
+         entries.erase(it);
+         entries.insert(entries.begin(), entry);
+         schedule_expiry(entry, selection, expiry_policy_.ttl_for(text));
      } else {
          // Create new entry
-         auto new_entry = std::make_shared<ClipboardEntry>(text);
-         entries_.insert(entries_.begin(), new_entry);
+         auto new_entry = std::make_shared<ClipboardEntry>(captured, kind);
+         NearDuplicateIndex& near_index = near_index_for(selection);
          
-         // Limit the number of entries
-         if (entries_.size() > MAX_ENTRIES) {
-             entries_.pop_back();
+         // Optionally drop the older variants this text supersedes
+         if (replace_near_duplicates_) {
+             std::vector<const ClipboardEntry*> variants;
+             near_index.find(new_entry->get_signature(), variants);
+             for (const ClipboardEntry* variant : variants) {
+                 if (variant->is_pinned()) {
+                     continue;
+                 }
+                 untrack_entry(variant, selection);
+                 entries.erase(std::remove_if(entries.begin(), entries.end(),
+                     [variant](const std::shared_ptr<ClipboardEntry>& entry) { return entry.get() == variant; }),
+                     entries.end());
+             }
+         }
+         
+         entries.insert(entries.begin(), new_entry);
+         track_entry(new_entry, selection);
+         schedule_expiry(new_entry, selection, expiry_policy_.ttl_for(text));
+         
+         // Limit the number of entries, evicting the oldest unpinned one
+         if (entries.size() > capacity_for(selection)) {
+             auto evicted = std::find_if(entries.rbegin(), entries.rend(),
+                 [](const std::shared_ptr<ClipboardEntry>& entry) { return !entry->is_pinned(); });
+             auto it = evicted != entries.rend() ? std::prev(evicted.base()) : entries.end() - 1;
+             if (selection == Selection::CLIPBOARD) {
+                 archive_entry(**it);
+             }
+             untrack_entry(it->get(), selection);
+             entries.erase(it);
          }
      }
      
-     // Notify callbacks
-     notify_callbacks();
+     apply_compression_policy(entries);
  }
  
- void ClipboardManager::notify_callbacks() {
-     for (const auto& callback : callbacks_) {
-         callback();
+ void ClipboardManager::archive_entry(const ClipboardEntry& entry) {
+     // Like the history file, the archive never sees short-lived entries
+     if (!archive_ || entry.is_binary() ||
+         (entry.get_expiry() != 0 && entry.get_expiry() - std::time(nullptr) <= expiry_policy_.secret_ttl)) {
+         return;
+     }
+     archive_queue_.emplace_back(entry.get_timestamp(), entry.get_text());
+     flush_archive_queue(false);
+ }
+ 
+ void ClipboardManager::flush_archive_queue(bool wait) {
+     if (archive_queue_.empty()) {
+         return;
+     }
+     
+     // A search may hold the archive for a while; the next eviction retries
+     std::unique_lock<std::mutex> lock(archive_mutex_, std::defer_lock);
+     if (wait) {
+         lock.lock();
+     } else if (!lock.try_lock()) {
+         return;
+     }
+     for (const auto& queued : archive_queue_) {
+         archive_->append(queued.first, *queued.second);
+     }
+     archive_queue_.clear();
+ }
+ 
+ void ClipboardManager::apply_compression_policy(std::vector<std::shared_ptr<ClipboardEntry>>& entries) {
+     if (entries.empty()) {
+         return;
+     }
+     
+     // The front entry is about to be pasted again, keep it raw unless it is huge
+     const auto& front = entries.front();
+     if (front->is_compressed() && front->get_size() < COMPRESS_LARGE_SIZE) {
+         front->decompress();
+     } else if (!front->is_compressed() && front->get_size() >= COMPRESS_LARGE_SIZE) {
+         front->compress();
+     }
+     
+     // Entries only move back one slot per insertion, so only the entry that
+     // just left the hot set needs to be looked at
+     if (entries.size() > HOT_ENTRIES) {
+         const auto& cold = entries[HOT_ENTRIES];
+         if (!cold->is_compressed() && cold->get_size() >= COMPRESS_MIN_SIZE) {
+             cold->compress();
+         }
+     }
+ }
+ 
+ void ClipboardManager::notify_callbacks(Selection selection) {
+     // Every change to a stream is notified, so its corpus is stale from here
+     invalidate_corpus(selection);
+     
+     const auto& callbacks = selection == Selection::PRIMARY ? primary_callbacks_ : callbacks_;
+     for (const auto& callback : callbacks) {
+         callback.second();
      }
  }
  
  std::string ClipboardManager::execute_xclip(const std::string& args) {
      std::string command = "xclip " + args;
-     std::array<char, 128> buffer;
+     std::array<char, 64 * 1024> buffer;
      std::string result;
      
      // Prevent recursion
@@ -276,9 +1294,10 @@
              ~PipeCloser() { if (pipe) pclose(pipe); }
          } pipe_closer{raw_pipe};
          
-         // Read output
-         while (fgets(buffer.data(), buffer.size(), raw_pipe) != nullptr) {
-             result += buffer.data();
+         // Read output in large blocks (fread also keeps NUL bytes)
+         size_t count;
+         while ((count = fread(buffer.data(), 1, buffer.size(), raw_pipe)) > 0) {
+             result.append(buffer.data(), count);
          }
      } catch (const std::exception& e) {
          std::cerr << "Exception executing xclip: " << e.what() << std::endl;
@@ -287,46 +1306,300 @@
      return result;
  }
  
- gboolean ClipboardManager::check_clipboard_changes(gpointer user_data) {
-     ClipboardManager* self = static_cast<ClipboardManager*>(user_data);
+ bool ClipboardManager::probe_selection(X11Selection* source, Selection selection, SelectionProbe& probe) {
+     // xclip can only tell by reading the content
+     if (!source) {
+         return true;
+     }
      
-     // Prevent recursive updates
-     if (self->updating_clipboard_) {
-         return G_SOURCE_CONTINUE;
+     // An owner takes the selection again for every copy, so the owner window
+     // or the time it took the selection changes whenever the content may have
+     unsigned long owner = source->get_owner(selection);
+     unsigned long timestamp = 0;
+     if (owner != 0 && !source->fetch_timestamp(selection, timestamp)) {
+         timestamp = 0;
+     }
+     
+     bool changed = !probe.valid || owner != probe.owner || timestamp != probe.timestamp;
+     probe.owner = owner;
+     probe.timestamp = timestamp;
+     probe.valid = true;
+     
+     // Nothing to read from an unowned selection; an owner without TIMESTAMP
+     // has to be read every time
+     return owner != 0 && (changed || timestamp == 0);
+ }
+ 
+ std::string ClipboardManager::fetch_selection(X11Selection* source, Selection selection) {
+     std::string content;
+     if (!wants_selection(source, selection)) {
+         return content;
+     }
+     if (source) {
+         source->fetch_text(selection, content);
+         return content;
      }
      
-     // Get current clipboard content
      // Redirect stderr to /dev/null to suppress error messages
-     // Try both primary and clipboard selections to ensure we catch all changes
-     std::string current_content = self->execute_xclip("-o -selection clipboard 2>/dev/null");
+     return execute_xclip(selection == Selection::PRIMARY ? "-o -selection primary 2>/dev/null"
+                                                          : "-o -selection clipboard 2>/dev/null");
+ }
+ 
+ bool ClipboardManager::wants_selection(X11Selection* source, Selection selection) {
+     if (!capture_filter_.is_active()) {
+         return true;
+     }
+     
+     // An owner that does not answer TARGETS is read as before
+     SelectionMetadata metadata;
+     bool fetched = source ? source->fetch_metadata(selection, metadata) : fetch_xclip_metadata(selection, metadata);
+     if (!fetched) {
+         return true;
+     }
+     return capture_filter_.allows(metadata);
+ }
+ 
+ bool ClipboardManager::fetch_xclip_metadata(Selection selection, SelectionMetadata& metadata) {
+     metadata = SelectionMetadata();
+     std::string output = selection == Selection::PRIMARY ? "-o -selection primary" : "-o -selection clipboard";
+     
+     // One target name per line
+     std::string targets = execute_xclip(output + " -t TARGETS 2>/dev/null");
+     size_t start = 0;
+     while (start < targets.size()) {
+         size_t end = targets.find('\n', start);
+         if (end == std::string::npos) {
+             end = targets.size();
+         }
+         if (end > start) {
+             metadata.targets.push_back(targets.substr(start, end - start));
+         }
+         start = end + 1;
+     }
+     if (metadata.targets.empty()) {
+         return false;
+     }
      
-     // If clipboard selection is empty, try primary selection as fallback
-     if (current_content.empty()) {
-         current_content = self->execute_xclip("-o -selection primary 2>/dev/null");
+     // The password manager hint, as X11Selection reads it; xclip cannot
+     // tell the owner's class or LENGTH
+     if (std::find(metadata.targets.begin(), metadata.targets.end(), "x-kde-passwordManagerHint") !=
+         metadata.targets.end()) {
+         std::string hint = execute_xclip(output + " -t x-kde-passwordManagerHint 2>/dev/null");
+         metadata.password_hint = hint == "secret";
+     }
+     return true;
+ }
+ 
+ bool ClipboardManager::check_clipboard_changes(X11Selection* source) {
+     // A paste replaced whatever PRIMARY was settling on
+     if (discard_pending_primary_.exchange(false)) {
+         pending_primary_content_.reset();
+     }
+     
+     // Prevent recursive updates
+     if (updating_clipboard_) {
+         return false;
+     }
+     
+     bool activity = false;
+     
+     // Get current clipboard content, unless its owner shows it is unchanged
+     std::string current_content;
+     if (probe_selection(source, Selection::CLIPBOARD, clipboard_probe_)) {
+         current_content = fetch_selection(source, Selection::CLIPBOARD);
      }
      
      // If content has changed and is not empty
-     if (!current_content.empty() && current_content != self->last_clipboard_content_) {
+     if (!current_content.empty() && !seen_clipboard_content_.matches(current_content)) {
+         activity = true;
          // Update last content
-         self->last_clipboard_content_ = current_content;
+         ClipboardText text = std::make_shared<const std::string>(std::move(current_content));
+         seen_clipboard_content_.remember(text);
          
-         // Add to entries
-         self->add_entry(current_content);
+         // Hand over to the store
+         publish_capture(Selection::CLIPBOARD, std::move(text));
      }
      
-     // Continue monitoring
-     return G_SOURCE_CONTINUE;
+     // PRIMARY goes to its own stream, never into the clipboard history
+     if (primary_tracking_) {
+         activity = check_primary_selection(source) || activity;
+     } else {
+         pending_primary_content_.reset();
+     }
+     return activity;
  }
  
- void ClipboardManager::load_history_from_file() {
-     // File path in user's home directory
-     const char* home_dir = getenv("HOME");
-     if (!home_dir) {
-         std::cerr << "Could not get HOME directory for history file" << std::endl;
+ bool ClipboardManager::check_primary_selection(X11Selection* source) {
+     gint64 now = g_get_monotonic_time();
+     gint64 debounce_us = static_cast<gint64>(PRIMARY_DEBOUNCE_MS) * 1000;
+     
+     // Same owner as on the last poll: a pending selection may have settled
+     // once the debounce window passed. Some owners update the selection
+     // without taking it again, so it is read once more before it is
+     // published rather than trusting the copy taken at the start.
+     if (!probe_selection(source, Selection::PRIMARY, primary_probe_)) {
+         if (primary_probe_.owner == 0) {
+             pending_primary_content_.reset();
+             return false;
+         }
+         if (!pending_primary_content_ || now - pending_primary_since_ < debounce_us) {
+             return false;
+         }
+     }
+     
+     std::string current_content = fetch_selection(source, Selection::PRIMARY);
+     
+     // Nothing new, or the selection was also copied to the clipboard
+     if (current_content.empty() || seen_primary_content_.matches(current_content) ||
+         seen_clipboard_content_.matches(current_content)) {
+         pending_primary_content_.reset();
+         return false;
+     }
+     
+     // Still changing (e.g. during a drag): restart the debounce window
+     if (!same_text(pending_primary_content_, current_content)) {
+         pending_primary_content_ = std::make_shared<const std::string>(std::move(current_content));
+         pending_primary_since_ = now;
+         return true;
+     }
+     
+     // Record only the selection the drag settled on
+     if (now - pending_primary_since_ >= debounce_us) {
+         seen_primary_content_.remember(pending_primary_content_);
+         publish_capture(Selection::PRIMARY, std::move(pending_primary_content_));
+         pending_primary_content_.reset();
+     }
+     return false;
+ }
+ 
+ void ClipboardManager::publish_capture(Selection selection, ClipboardText text) {
+     CaptureEvent event;
+     event.selection = selection;
+     event.text = std::move(text);
+     event.timestamp_us = g_get_monotonic_time();
+     
+     if (trace_writer_) {
+         trace_writer_->record(event);
+     }
+     
+     // An event kept aside earlier has to go first
+     flush_capture_overflow();
+     
+     if (has_capture_overflow_ || !capture_ring_.push(event)) {
+         // Ring full: keep only the newest event so the final value is never lost
+         if (has_capture_overflow_) {
+             dropped_count_++;
+         }
+         capture_overflow_ = std::move(event);
+         has_capture_overflow_ = true;
          return;
      }
      
-     std::string history_file = std::string(home_dir) + "/.clipboard_history";
+     captured_count_++;
+     schedule_capture_drain();
+ }
+ 
+ void ClipboardManager::flush_capture_overflow() {
+     if (has_capture_overflow_ && capture_ring_.push(capture_overflow_)) {
+         has_capture_overflow_ = false;
+         captured_count_++;
+         schedule_capture_drain();
+     }
+ }
+ 
+ void ClipboardManager::schedule_capture_drain() {
+     // One pending idle source is enough, however many events are queued
+     if (!drain_scheduled_.exchange(true)) {
+         g_idle_add(drain_capture_ring, this);
+     }
+ }
+ 
+ gboolean ClipboardManager::drain_capture_ring(gpointer user_data) {
+     ClipboardManager* self = static_cast<ClipboardManager*>(user_data);
+     
+     // Clear the flag before draining so a concurrent push schedules a new run
+     self->drain_scheduled_ = false;
+     
+     std::vector<CaptureEvent> batch;
+     CaptureEvent event;
+     while (self->capture_ring_.pop(event)) {
+         batch.push_back(std::move(event));
+     }
+     
+     if (!batch.empty()) {
+         self->ingest_batch(batch);
+     }
+     return G_SOURCE_REMOVE;
+ }
+ 
+ void ClipboardManager::ingest_batch(std::vector<CaptureEvent>& batch) {
+     bool clipboard_changed = false;
+     bool primary_changed = false;
+     
+     std::lock_guard<std::mutex> lock(mutex_);
+     
+     for (auto& event : batch) {
+         // Skip repeats of what is already on top, including our own pastes
+         SeenText& last = event.selection == Selection::PRIMARY ? last_primary_content_ : last_clipboard_content_;
+         if (last.matches(event.text)) {
+             coalesced_count_++;
+             continue;
+         }
+         
+         // A transformed paste is recognized by its size and hash
+         if (pasted_variant_valid_ && event.text->size() == pasted_variant_.size &&
+             hash_text(*event.text) == pasted_variant_.hash) {
+             coalesced_count_++;
+             last.remember(event.text);
+             continue;
+         }
+         
+         insert_entry(event.text, event.selection);
+         last.remember(event.text);
+         
+         // The entry owns the text now, so compressing it frees the buffer
+         event.text.reset();
+         pasted_variant_valid_ = false;
+         
+         if (event.selection == Selection::PRIMARY) {
+             primary_changed = true;
+         } else {
+             clipboard_changed = true;
+         }
+     }
+     
+     batch_count_++;
+     
+     // Every event of the batch waited until now
+     gint64 done = g_get_monotonic_time();
+     for (const auto& event : batch) {
+         uint64_t latency = static_cast<uint64_t>(std::max<gint64>(0, done - event.timestamp_us));
+         size_t bucket = 0;
+         while (bucket + 1 < LATENCY_BUCKETS && (latency >> bucket) != 0) {
+             bucket++;
+         }
+         latency_buckets_[bucket]++;
+         latency_max_us_ = std::max(latency_max_us_, latency);
+     }
+     
+     // One notification per stream and batch
+     if (clipboard_changed) {
+         notify_callbacks(Selection::CLIPBOARD);
+     }
+     if (primary_changed) {
+         notify_callbacks(Selection::PRIMARY);
+     }
+ }
+ 
+ std::string ClipboardManager::history_file_path() {
+     return default_history_path();
+ }
+ 
+ void ClipboardManager::load_history_from_file() {
+     const std::string& history_file = history_path_;
+     if (history_file.empty()) {
+         return;
+     }
      
      // Try to open the file
      FILE* file = fopen(history_file.c_str(), "r");
@@ -335,58 +1608,95 @@
          return;
      }
      
-     // Read entries line by line
-     char buffer[4096];
-     std::string current_entry;
-     bool in_entry = false;
+     std::vector<std::shared_ptr<ClipboardEntry>> loaded;
+     std::time_t now = std::time(nullptr);
      
-     while (fgets(buffer, sizeof(buffer), file)) {
-         std::string line(buffer);
-         
-         // Remove trailing newline
-         if (!line.empty() && line[line.length()-1] == '\n') {
-             line.erase(line.length()-1);
-         }
-         
-         // Check for entry markers
-         if (line == "---ENTRY_START---") {
-             in_entry = true;
-             current_entry.clear();
-         } else if (line == "---ENTRY_END---") {
-             if (in_entry && !current_entry.empty()) {
-                 // Add this entry
-                 add_entry(current_entry);
+     // A corrupt file must not keep the app from starting: keep the entries
+     // read before the damage
+     try {
+         HistoryFileReader reader(file);
+         HistoryRecord record;
+         while (reader.next(record)) {
+             std::shared_ptr<ClipboardEntry> entry;
+             if (record.chunked) {
+                 entry = ClipboardEntry::from_chunks(std::move(record.chunks), record.raw_size);
+                 if (!entry) {
+                     continue;
+                 }
+             } else if (record.compressed) {
+                 entry = ClipboardEntry::from_compressed(std::move(record.data), record.raw_size);
+                 if (!entry) {
+                     continue;
+                 }
+             } else {
+                 entry = std::make_shared<ClipboardEntry>(std::make_shared<const std::string>(std::move(record.data)));
+             }
+             
+             // Restore the times of the entry, dropping it if it already expired
+             entry->set_pinned(record.pinned);
+             if (record.has_times) {
+                 entry->set_timestamp(record.timestamp);
+                 entry->set_expiry(record.expiry);
+             } else {
+                 // Older files carry no times: apply the current rules from now on
+                 std::time_t ttl = expiry_policy_.ttl_for(*entry->get_text());
+                 entry->set_expiry(ttl > 0 ? now + ttl : 0);
              }
-             in_entry = false;
-         } else if (in_entry) {
-             // Add line to current entry
-             if (!current_entry.empty()) {
-                 current_entry += "\n";
+             
+             if (entry->get_expiry() != 0 && entry->get_expiry() <= now && !entry->is_pinned()) {
+                 continue;
              }
-             current_entry += line;
+             loaded.push_back(entry);
          }
+     } catch (const std::bad_alloc&) {
+         std::cerr << "History file is corrupt, loaded " << loaded.size() << " entries: " << history_file << std::endl;
      }
      
      fclose(file);
+     
+     if (loaded.empty()) {
+         return;
+     }
+     
+     std::lock_guard<std::mutex> lock(mutex_);
+     
+     // The file is written newest first, so keep its order
+     for (auto& entry : loaded) {
+         if (entries_.size() >= MAX_ENTRIES) {
+             break;
+         }
+         if (entries_.size() >= HOT_ENTRIES && entry->get_size() >= COMPRESS_MIN_SIZE) {
+             entry->compress();
+         }
+         entries_.push_back(entry);
+         track_entry(entry, Selection::CLIPBOARD);
+         
+         if (entry->get_expiry() != 0) {
+             expiry_wheel_.schedule(ExpiryTimer{entry, Selection::CLIPBOARD}, static_cast<uint64_t>(entry->get_expiry()));
+         }
+     }
+     arm_expiry_timer();
+     
+     notify_callbacks();
  }
  
  void ClipboardManager::save_history_to_file() {
      std::lock_guard<std::mutex> lock(mutex_);
-     
-     // Don't save if there are no entries
-     if (entries_.empty()) {
+     save_history_locked();
+ }
+ 
+ void ClipboardManager::save_history_locked() {
+     const std::string& history_file = history_path_;
+     if (history_file.empty()) {
          return;
      }
      
-     // File path in user's home directory
-     const char* home_dir = getenv("HOME");
-     if (!home_dir) {
-         std::cerr << "Could not get HOME directory for history file" << std::endl;
+     // Deleted entries must not come back on the next start
+     if (entries_.empty()) {
+         unlink(history_file.c_str());
          return;
      }
      
-     std::string history_file = std::string(home_dir) + "/.clipboard_history";
-     
      // Open the file for writing
      FILE* file = fopen(history_file.c_str(), "w");
      if (!file) {
@@ -395,14 +1705,35 @@
      }
      
      // Write entries (up to MAX_ENTRIES)
+     std::time_t now = std::time(nullptr);
+     WrittenChunks written_chunks;
      size_t count = std::min(entries_.size(), MAX_ENTRIES);
      for (size_t i = 0; i < count; ++i) {
          const auto& entry = entries_[i];
-         fprintf(file, "---ENTRY_START---\n");
-         fprintf(file, "%s\n", entry->get_text().c_str());
-         fprintf(file, "---ENTRY_END---\n");
+         
+         // Short-lived entries such as secrets never reach the disk
+         if (entry->get_expiry() != 0 && entry->get_expiry() - now <= expiry_policy_.secret_ttl) {
+             continue;
+         }
+         
+         // Reuse the in-memory chunks or block of cold entries, pack the others here.
+         // Chunks shared between versions of a text are written once.
+         if (entry->is_chunked()) {
+             write_history_chunks(file, entry->get_timestamp(), entry->get_expiry(),
+                                  entry->get_chunks(), entry->get_size(), written_chunks, entry->is_pinned());
+         } else if (!entry->is_compressed() && entry->get_size() >= CHUNKING_MIN_SIZE) {
+             ClipboardText text = entry->get_text();
+             write_history_chunks(file, entry->get_timestamp(), entry->get_expiry(),
+                                  ChunkPool::shared().store(text->data(), text->size()),
+                                  entry->get_size(), written_chunks, entry->is_pinned());
+         } else if (entry->is_compressed()) {
+             write_history_block(file, entry->get_timestamp(), entry->get_expiry(),
+                                 entry->get_compressed(), entry->get_size(), entry->is_pinned());
+         } else {
+             write_history_text(file, entry->get_timestamp(), entry->get_expiry(),
+                                *entry->get_text(), COMPRESS_MIN_SIZE, entry->is_pinned());
+         }
      }
      
      fclose(file);
  }
- 
\ No newline at end of file
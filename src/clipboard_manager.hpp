@@ -10,69 +10,352 @@
  #include <memory>
  #include <functional>
  #include <mutex>
+ #include <thread>
+ #include <atomic>
+ #include <unordered_map>
  
  #include "clipboard_entry.hpp"
+ #include "capture_event.hpp"
+ #include "capture_ring.hpp"
+ #include "history_search.hpp"
+ #include "expiry_policy.hpp"
+ #include "timer_wheel.hpp"
+ #include "near_duplicate.hpp"
+ #include "facet_index.hpp"
+ #include "poll_backoff.hpp"
+ #include "screen_lock.hpp"
+ #include "paste_transform.hpp"
+ #include "capture_filter.hpp"
+ #include "seen_text.hpp"
+ #include "history_file.hpp"
+ 
+ class X11Selection;
+ class CaptureTraceWriter;
+ class HistoryArchive;
  
  class ClipboardManager {
  public:
      // Maximum number of entries to store
-     static const size_t MAX_ENTRIES = 50;
+     static const size_t MAX_ENTRIES = HISTORY_MAX_ENTRIES;
+     
+     // Maximum number of entries in the PRIMARY selection stream
+     static const size_t MAX_PRIMARY_ENTRIES = 20;
+     
+     // A PRIMARY selection must stay unchanged this long to be recorded
+     static const guint PRIMARY_DEBOUNCE_MS = 1000;
+     
+     // Entries past this position are kept compressed in memory
+     static const size_t HOT_ENTRIES = 8;
+     
+     // Entries smaller than this are never compressed
+     static const size_t COMPRESS_MIN_SIZE = HISTORY_COMPRESS_MIN_SIZE;
+     
+     // Entries larger than this are compressed even while recent
+     static const size_t COMPRESS_LARGE_SIZE = 64 * 1024;
      
-     // Constructor and destructor
-     ClipboardManager();
+     // Capture events buffered between the capture thread and the store
+     static const size_t CAPTURE_RING_SIZE = 1024;
+     
+     // Polling intervals when no event-driven source is available: right
+     // after a change, at most once idle, and while the screen is locked
+     static const guint POLL_MIN_MS = 250;
+     static const guint POLL_MAX_MS = 8000;
+     static const guint POLL_LOCKED_MS = 30000;
+     
+     // Days evicted entries are kept in the archive unless VMCASTLE_ARCHIVE_DAYS says otherwise
+     static const long ARCHIVE_DAYS = 180;
+     
+     // Archived entries read by one archive search at most
+     static const size_t ARCHIVE_SEARCH_BYTES = 16 * 1024 * 1024;
+     
+     // Constructor and destructor; the history is kept in history_path
+     explicit ClipboardManager(const std::string& history_path = history_file_path());
      ~ClipboardManager();
      
      // Clipboard operations
      void start_monitoring();
      void stop_monitoring();
      
+     // Load the saved history without starting a capture thread; captures
+     // then come from inject_capture() (e.g. one DisplayHub thread watching
+     // several displays)
+     void start_injected_monitoring();
+     
+     // Enable or disable recording of the PRIMARY selection stream
+     void set_primary_tracking(bool enabled);
+     bool get_primary_tracking() const;
+     
+     // The user is around (e.g. the window was shown): the polling backend
+     // checks right away and polls fast again
+     void note_user_activity();
+     
      // Get all entries
-     std::vector<std::shared_ptr<ClipboardEntry>> get_entries() const;
+     std::vector<std::shared_ptr<ClipboardEntry>> get_entries(Selection selection = Selection::CLIPBOARD) const;
+     
+     // Get the newest count entries
+     std::vector<std::shared_ptr<ClipboardEntry>> get_recent_entries(size_t count, Selection selection = Selection::CLIPBOARD) const;
      
      // Get entry at index
-     std::shared_ptr<ClipboardEntry> get_entry(size_t index) const;
+     std::shared_ptr<ClipboardEntry> get_entry(size_t index, Selection selection = Selection::CLIPBOARD) const;
+     
+     // Get a live entry by id in O(1), from either stream (null once it was
+     // removed, evicted or expired)
+     std::shared_ptr<ClipboardEntry> find_entry(EntryId id) const;
      
      // Get the number of entries
-     size_t get_entry_count() const;
+     size_t get_entry_count(Selection selection = Selection::CLIPBOARD) const;
+     
+     // Copy an entry to the system clipboard and move it to the front.
+     // Entries are addressed by id, so captures landing between listing the
+     // entries and acting on one cannot redirect the action to another entry.
+     bool copy_to_clipboard(EntryId id);
      
-     // Copy entry at index to system clipboard
-     bool copy_to_clipboard(size_t index);
+     // Paste a variant of an entry (trimmed, decoded, ...) without storing
+     // it. The transforms run over the payload a block at a time and their
+     // output streams straight to the selections, so a huge entry is never
+     // held whole. The history is left as it is and the capture does not
+     // record the variant. False if a transform rejects the content.
+     bool paste_transformed(EntryId id, const std::vector<PasteTransform>& transforms);
      
      // Clear all entries
-     void clear_entries();
+     void clear_entries(Selection selection = Selection::CLIPBOARD);
+     
+     // Remove an entry; false if it is already gone
+     bool remove_entry(EntryId id);
+     
+     // Batch operations. Each runs in one critical section with a single
+     // change notification and a single history write per stream. Ids of
+     // entries that are already gone are ignored.
+     
+     // Remove a set of entries; returns how many were removed
+     size_t remove_entries(const std::vector<EntryId>& ids);
+     
+     // Remove every unpinned entry matching query and carrying the facets;
+     // returns how many were removed
+     size_t remove_matches(const std::string& query, SearchMode mode, Selection selection = Selection::CLIPBOARD,
+                           std::string* error = nullptr, FacetMask facets = 0);
+     
+     // Pin or unpin a set of entries; returns how many changed
+     size_t set_entries_pinned(const std::vector<EntryId>& ids, bool pinned);
      
-     // Remove entry at index
-     void remove_entry(size_t index);
+     // Put the texts of a set of entries, in the given order and joined by
+     // separator, on the system clipboard
+     bool copy_entries(const std::vector<EntryId>& ids, const std::string& separator);
      
-     // Register callback for clipboard changes
+     // Time-to-live rules for new entries
+     void set_expiry_policy(const ExpiryPolicy& policy);
+     ExpiryPolicy get_expiry_policy() const;
+     
+     // Expire an entry ttl seconds from now (0 keeps it forever)
+     bool set_entry_ttl(EntryId id, std::time_t ttl);
+     
+     // Let a new entry replace the older variants of its text (near-duplicates)
+     // instead of pushing them down the history
+     void set_replace_near_duplicates(bool enabled);
+     bool get_replace_near_duplicates() const;
+     
+     // Search a history stream. Fills entries with a snapshot of the stream and
+     // matches with the indices of the matching entries in that snapshot.
+     // Matches are narrowed to the entries carrying every facet in facets; an
+     // empty query then lists all of those.
+     bool search(const std::string& query, SearchMode mode, Selection selection,
+                 std::vector<std::shared_ptr<ClipboardEntry>>& entries,
+                 std::vector<size_t>& matches, std::string* error = nullptr, FacetMask facets = 0);
+     
+     // Size and hash of every text in the clipboard history (main thread)
+     using HistorySnapshot = std::unordered_multimap<size_t, uint64_t>;
+     HistorySnapshot snapshot_history() const;
+     
+     // Search the archive of entries pushed out of the clipboard history for
+     // up to limit matches created in [since, until] (0 = unbounded), newest
+     // first, leaving out the texts of history, a snapshot_history() taken
+     // before. An empty query matches everything. complete is set to false
+     // when the search stopped at ARCHIVE_SEARCH_BYTES. The results can be
+     // passed to copy_to_clipboard(), which brings them back into the
+     // history, until the next search.
+     // Reads files: call it off the UI thread. It never touches the history
+     // entries, but searches must not run concurrently.
+     bool search_archive(const std::string& query, SearchMode mode, std::time_t since, std::time_t until,
+                         size_t limit, const HistorySnapshot& history,
+                         std::vector<std::shared_ptr<ClipboardEntry>>& results,
+                         bool* complete = nullptr, std::string* error = nullptr, FacetMask facets = 0);
+     
+     // Drop caches that are rebuilt on demand (search corpora, decompressed
+     // payloads), e.g. while the UI is idle
+     void release_caches();
+     
+     // Drop the packed search texts of both streams once nobody is searching
+     // (search box cleared, window hidden); the next search packs them again
+     void release_search_corpora();
+     
+     // Register callback for changes to one history stream. The returned id
+     // unregisters it; owners that may go away first must do so.
      using ClipboardChangedCallback = std::function<void()>;
-     void register_callback(ClipboardChangedCallback callback);
+     using CallbackId = uint64_t;
+     CallbackId register_callback(ClipboardChangedCallback callback, Selection selection = Selection::CLIPBOARD);
+     void unregister_callback(CallbackId id);
+     
+     // Ingestion counters (captured, dropped, coalesced, batches) and latencies
+     CaptureStats get_capture_stats() const;
+     
+     // Feed an event into the capture pipeline as if the capture thread had
+     // seen it (trace replay, multi-display hub). Only one thread may inject,
+     // and only while no capture thread runs. flush_injection() retries an
+     // event kept aside while the ring was full and returns true once none is
+     // left; finish_injection() waits until then.
+     void inject_capture(Selection selection, ClipboardText text);
+     bool flush_injection();
+     void finish_injection();
+     
+     // Location of the history file: $VMCASTLE_HISTORY_FILE, or
+     // ~/.clipboard_history (empty if HOME is not set)
+     static std::string history_file_path();
      
  private:
-     // Monitor clipboard using xclip
-     void start_xclip_monitoring();
-     void stop_xclip_monitoring();
+     // Capture selections on a dedicated thread
+     void start_capture_thread();
+     void stop_capture_thread();
+     void capture_loop();
+     
+     // Event-driven capture through XFixes owner notifications
+     void run_x11_capture(X11Selection& source);
+     
+     // Polling capture; probes owners through source when there is one,
+     // otherwise reads the selections through xclip
+     void run_polling_capture(X11Selection* source);
+     
+     // State of the polling loop and its GLib callbacks (capture thread)
+     struct PollState;
+     struct SelectionProbe {
+         unsigned long owner = 0;
+         unsigned long timestamp = 0;
+         bool valid = false;
+     };
+     static gboolean on_poll_timer(gpointer user_data);
+     static gboolean on_poll_wake(gint fd, GIOCondition condition, gpointer user_data);
+     void poll_selections(PollState& state);
+     void schedule_poll(PollState& state, guint delay_ms);
+     
+     // Whether a selection may have changed since the last probe: true when
+     // its owner or the owner's TIMESTAMP moved, or when neither can be told
+     bool probe_selection(X11Selection* source, Selection selection, SelectionProbe& probe);
+     
+     // Read a selection through source, or xclip without one; empty when
+     // the capture filter skips it
+     std::string fetch_selection(X11Selection* source, Selection selection);
+     
+     // Whether the capture filter lets a selection be read, judging by what
+     // its owner advertises (asked through xclip without a connection)
+     bool wants_selection(X11Selection* source, Selection selection);
+     
+     // Targets and password hint of a selection through xclip; false when
+     // the owner lists no targets
+     bool fetch_xclip_metadata(Selection selection, SelectionMetadata& metadata);
      
      // Clipboard content change handler
      static void on_clipboard_changed(GdkClipboard* clipboard, gpointer user_data);
      
+     // Put text on the clipboard and primary selection through xclip
+     bool set_system_clipboard(const ClipboardText& text);
+     
+     // Stream the transformed content to both selections through xclip
+     bool stream_to_system_clipboard(const EntryContent& content, const std::vector<PasteTransform>& transforms);
+     
+     // Drop the entries flagged in doomed in one pass, then notify and save once
+     // (mutex_ must be held)
+     size_t remove_marked(const std::vector<bool>& doomed, Selection selection);
+     
      // Execute xclip command and get output
      std::string execute_xclip(const std::string& args);
      
-     // Check clipboard for changes
-     static gboolean check_clipboard_changes(gpointer user_data);
+     // Check clipboard for changes (capture thread, polling mode); true if
+     // either selection changed
+     bool check_clipboard_changes(X11Selection* source);
+     
+     // Record the PRIMARY selection once it has settled (capture thread, polling mode)
+     bool check_primary_selection(X11Selection* source);
+     
+     // Hand captured content to the store (capture thread)
+     void publish_capture(Selection selection, ClipboardText text);
+     
+     // Retry the event kept aside while the ring was full (capture thread)
+     void flush_capture_overflow();
+     
+     // Make sure the main loop drains the ring
+     void schedule_capture_drain();
+     
+     // Drain the capture ring on the main loop, one notification per batch
+     static gboolean drain_capture_ring(gpointer user_data);
+     void ingest_batch(std::vector<CaptureEvent>& batch);
      
      // Add new entry
-     void add_entry(const std::string& text);
+     void add_entry(const std::string& text, Selection selection = Selection::CLIPBOARD);
+     
+     // Insert or promote an entry without notifying (mutex_ must be held).
+     // Valid text is stored in the captured buffer itself.
+     void insert_entry(ClipboardText text, Selection selection);
+     
+     // Entries and capacity of a history stream
+     std::vector<std::shared_ptr<ClipboardEntry>>& entries_for(Selection selection);
+     const std::vector<std::shared_ptr<ClipboardEntry>>& entries_for(Selection selection) const;
+     size_t capacity_for(Selection selection) const;
+     
+     // Move an entry evicted from the clipboard history to the archive (mutex_ must be held)
+     void archive_entry(const ClipboardEntry& entry);
+     
+     // Append the queued evicted entries to the archive, unless a search has
+     // it and wait is false (mutex_ must be held)
+     void flush_archive_queue(bool wait);
+     
+     // Compress entries that crossed the recency or size threshold
+     void apply_compression_policy(std::vector<std::shared_ptr<ClipboardEntry>>& entries);
+     
+     // Give a new or renewed entry its expiry time and schedule it (mutex_ must be held)
+     void schedule_expiry(const std::shared_ptr<ClipboardEntry>& entry, Selection selection, std::time_t ttl);
+     
+     // Keep a main loop timer armed for the next slot of the expiry wheel
+     void arm_expiry_timer();
+     static gboolean on_expiry_timer(gpointer user_data);
+     
+     // Remove expired entries from memory and from the history file
+     void expire_entries();
+     
+     // Packed search texts and facet bitmaps of a history stream, rebuilt
+     // after changes
+     SearchCorpus& corpus_for(Selection selection);
+     FacetIndex& facet_index_for(Selection selection);
+     void invalidate_corpus(Selection selection);
+     
+     // Near-duplicate index of a history stream, kept in step with its entries
+     NearDuplicateIndex& near_index_for(Selection selection);
+     
+     // Give an entry joining a stream its id and index it; undo that when it
+     // leaves (mutex_ must be held)
+     void track_entry(const std::shared_ptr<ClipboardEntry>& entry, Selection selection);
+     void untrack_entry(const ClipboardEntry* entry, Selection selection);
      
      // Notify callbacks
-     void notify_callbacks();
+     void notify_callbacks(Selection selection = Selection::CLIPBOARD);
      
      // Load clipboard history from file
      void load_history_from_file();
      
      // Save clipboard history to file
      void save_history_to_file();
+     void save_history_locked();
+     
+     // History file of this instance (empty to keep no history)
+     std::string history_path_;
+     
+     // Evicted clipboard entries, next to the history file (null if disabled),
+     // and the entries found by the last archive search
+     std::unique_ptr<HistoryArchive> archive_;
+     std::unordered_map<EntryId, std::shared_ptr<ClipboardEntry>> archive_results_;
+     
+     // Held while the archive is read or written, so a search does not hold
+     // mutex_; evictions queue up while a search runs (taken after mutex_)
+     std::mutex archive_mutex_;
+     std::vector<std::pair<std::time_t, ClipboardText>> archive_queue_;
      
      // System clipboard
      GdkClipboard* clipboard_;
@@ -80,20 +363,120 @@
      // Clipboard entries
      std::vector<std::shared_ptr<ClipboardEntry>> entries_;
      
+     // PRIMARY selection entries
+     std::vector<std::shared_ptr<ClipboardEntry>> primary_entries_;
+     
+     // Search corpora of both streams and whether they match the entries
+     SearchCorpus corpus_;
+     SearchCorpus primary_corpus_;
+     bool corpus_valid_;
+     bool primary_corpus_valid_;
+     
+     // Facet bitmaps of both streams, valid along with the corpora
+     FacetIndex facet_index_;
+     FacetIndex primary_facet_index_;
+     bool facet_index_valid_;
+     bool primary_facet_index_valid_;
+     
+     // Near-duplicate indexes of both streams and the replacement policy
+     NearDuplicateIndex near_index_;
+     NearDuplicateIndex primary_near_index_;
+     bool replace_near_duplicates_;
+     
+     // Every entry of both streams by id; ids are never reused
+     struct TrackedEntry {
+         std::shared_ptr<ClipboardEntry> entry;
+         Selection selection;
+     };
+     std::unordered_map<EntryId, TrackedEntry> entries_by_id_;
+     EntryId next_entry_id_;
+     
+     // Pending expiries; timers hold weak references and are checked when they fire
+     struct ExpiryTimer {
+         std::weak_ptr<ClipboardEntry> entry;
+         Selection selection;
+     };
+     ExpiryPolicy expiry_policy_;
+     TimerWheel<ExpiryTimer> expiry_wheel_;
+     guint expiry_source_;
+     std::time_t expiry_armed_at_;
+     
      // Mutex for thread safety
      mutable std::mutex mutex_;
      
-     // Callbacks for clipboard changes
-     std::vector<ClipboardChangedCallback> callbacks_;
+     // Callbacks for clipboard changes, by registration id
+     std::vector<std::pair<CallbackId, ClipboardChangedCallback>> callbacks_;
+     
+     // Callbacks for PRIMARY selection changes
+     std::vector<std::pair<CallbackId, ClipboardChangedCallback>> primary_callbacks_;
+     CallbackId next_callback_id_;
      
      // Flag to prevent recursive clipboard changes
-     bool updating_clipboard_;
+     std::atomic<bool> updating_clipboard_;
+     
+     // Last clipboard content stored or pasted (main thread)
+     SeenText last_clipboard_content_;
+     
+     // Whether the PRIMARY selection stream is recorded
+     std::atomic<bool> primary_tracking_;
+     
+     // Last recorded or pasted PRIMARY content (main thread)
+     SeenText last_primary_content_;
+     
+     // Size and hash of the last transformed paste, so the capture of it is
+     // skipped without keeping the text (main thread)
+     TransformedSize pasted_variant_;
+     bool pasted_variant_valid_;
+     
+     // Capture thread and the eventfd used to wake it up
+     std::thread capture_thread_;
+     std::atomic<bool> capture_running_;
+     int capture_wake_fd_;
+     
+     // Last selection contents seen by the capture thread
+     SeenText seen_clipboard_content_;
+     SeenText seen_primary_content_;
+     
+     // PRIMARY content waiting for the debounce window to pass (capture thread)
+     ClipboardText pending_primary_content_;
+     gint64 pending_primary_since_;
+     
+     // Set by a paste on the main thread; the capture thread drops the
+     // pending PRIMARY content when it sees it
+     std::atomic<bool> discard_pending_primary_;
+     
+     // Owners seen by the last poll (capture thread)
+     SelectionProbe clipboard_probe_;
+     SelectionProbe primary_probe_;
+     
+     // Rules for selections not worth reading (capture thread)
+     CaptureFilter capture_filter_;
+     
+     // Whether the capture thread polls, whether it should speed up on its
+     // next wakeup, and the screen lock state that slows it down
+     std::atomic<bool> polling_;
+     std::atomic<bool> poll_activity_;
+     std::atomic<bool> screen_locked_;
+     ScreenLockWatch screen_lock_;
+     
+     // Ingestion ring; the newest event is kept aside while the ring is full
+     CaptureRing<CaptureEvent> capture_ring_;
+     CaptureEvent capture_overflow_;
+     bool has_capture_overflow_;
+     std::atomic<bool> drain_scheduled_;
+     
+     // Ingestion counters
+     std::atomic<uint64_t> captured_count_;
+     std::atomic<uint64_t> dropped_count_;
+     std::atomic<uint64_t> coalesced_count_;
+     std::atomic<uint64_t> batch_count_;
      
-     // Last clipboard content for change detection
-     std::string last_clipboard_content_;
+     // Ingest latency histogram (guarded by mutex_)
+     uint64_t latency_buckets_[LATENCY_BUCKETS];
+     uint64_t latency_max_us_;
      
-     // Monitoring source ID for xclip
-     guint monitor_source_id_;
+     // Capture trace being recorded ($VMCASTLE_RECORD_TRACE; capture thread)
+     std::unique_ptr<CaptureTraceWriter> trace_writer_;
  };
  
  #endif // CLIPBOARD_MANAGER_HPP
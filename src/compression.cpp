@@ -0,0 +1,203 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "compression.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// LZ4 block format constants
+static const size_t MIN_MATCH = 4;
+static const size_t LAST_LITERALS = 5;
+static const size_t MF_LIMIT = 12;
+static const size_t MAX_DISTANCE = 65535;
+static const int HASH_LOG = 14;
+
+// Most output bytes one input byte can produce (a 255 length extension)
+static const size_t LZ4_MAX_EXPANSION = 255;
+
+static uint32_t read32(const char* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t hash_sequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_LOG);
+}
+
+// Write a length that did not fit in the 4-bit token field
+static void write_length(std::string& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+static void write_sequence(std::string& out, const char* literals, size_t literal_length,
+                           size_t offset, size_t match_length) {
+    size_t match_code = match_length - MIN_MATCH;
+    unsigned char token = static_cast<unsigned char>(
+        ((literal_length < 15 ? literal_length : 15) << 4) | (match_code < 15 ? match_code : 15));
+    out.push_back(static_cast<char>(token));
+
+    if (literal_length >= 15) {
+        write_length(out, literal_length - 15);
+    }
+    out.append(literals, literal_length);
+
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>((offset >> 8) & 0xFF));
+
+    if (match_code >= 15) {
+        write_length(out, match_code - 15);
+    }
+}
+
+static void write_last_literals(std::string& out, const char* literals, size_t literal_length) {
+    unsigned char token = static_cast<unsigned char>((literal_length < 15 ? literal_length : 15) << 4);
+    out.push_back(static_cast<char>(token));
+    if (literal_length >= 15) {
+        write_length(out, literal_length - 15);
+    }
+    out.append(literals, literal_length);
+}
+
+std::string lz4_compress(const char* data, size_t size) {
+    std::string out;
+    out.reserve(size + size / 255 + 16);
+
+    // Inputs too small to hold a match are stored as literals only
+    if (size < MF_LIMIT + 1) {
+        write_last_literals(out, data, size);
+        return out;
+    }
+
+    std::vector<uint32_t> table(static_cast<size_t>(1) << HASH_LOG, 0);
+    const size_t match_limit = size - LAST_LITERALS;
+    const size_t search_limit = size - MF_LIMIT;
+    size_t anchor = 0;
+    size_t pos = 0;
+    size_t misses = 0;
+
+    while (pos <= search_limit) {
+        uint32_t sequence = read32(data + pos);
+        uint32_t h = hash_sequence(sequence);
+        size_t candidate = table[h];
+        table[h] = static_cast<uint32_t>(pos);
+
+        if (candidate >= pos || pos - candidate > MAX_DISTANCE || read32(data + candidate) != sequence) {
+            // Skip faster through data that does not compress
+            pos += 1 + (misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+
+        // Extend the match backwards over pending literals
+        while (pos > anchor && candidate > 0 && data[pos - 1] == data[candidate - 1]) {
+            --pos;
+            --candidate;
+        }
+
+        // Extend the match forwards
+        size_t length = MIN_MATCH;
+        while (pos + length < match_limit && data[candidate + length] == data[pos + length]) {
+            ++length;
+        }
+
+        write_sequence(out, data + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+
+        // Index a position inside the match to improve the next search
+        if (pos - 2 <= search_limit) {
+            table[hash_sequence(read32(data + pos - 2))] = static_cast<uint32_t>(pos - 2);
+        }
+    }
+
+    write_last_literals(out, data + anchor, size - anchor);
+    return out;
+}
+
+bool lz4_decompress(const char* data, size_t size, size_t raw_size, std::string& out) {
+    out.clear();
+
+    // A byte of LZ4 input expands to at most 255 bytes; a larger size is a
+    // corrupt header, not a reason to allocate
+    if (raw_size / LZ4_MAX_EXPANSION > size) {
+        return false;
+    }
+    out.resize(raw_size);
+    return lz4_decompress_to(data, size, out.empty() ? nullptr : &out[0], raw_size);
+}
+
+bool lz4_decompress_to(const char* data, size_t size, char* dst, size_t raw_size) {
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* in_end = in + size;
+    size_t written = 0;
+
+    while (in < in_end) {
+        unsigned char token = *in++;
+
+        // Literal run
+        size_t literal_length = token >> 4;
+        if (literal_length == 15) {
+            unsigned char extra;
+            do {
+                if (in >= in_end) return false;
+                extra = *in++;
+                literal_length += extra;
+            } while (extra == 255);
+        }
+        if (literal_length > static_cast<size_t>(in_end - in) || literal_length > raw_size - written) {
+            return false;
+        }
+        if (literal_length > 0) {
+            memcpy(dst + written, in, literal_length);
+        }
+        in += literal_length;
+        written += literal_length;
+
+        // The last sequence carries literals only
+        if (in == in_end) {
+            break;
+        }
+
+        // Match copy
+        if (in_end - in < 2) return false;
+        size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > written) {
+            return false;
+        }
+
+        size_t match_length = token & 0x0F;
+        if (match_length == 15) {
+            unsigned char extra;
+            do {
+                if (in >= in_end) return false;
+                extra = *in++;
+                match_length += extra;
+            } while (extra == 255);
+        }
+        match_length += MIN_MATCH;
+        if (match_length > raw_size - written) {
+            return false;
+        }
+
+        const char* src = dst + written - offset;
+        if (offset >= match_length) {
+            memcpy(dst + written, src, match_length);
+        } else {
+            // Overlapping copy repeats the last offset bytes
+            for (size_t i = 0; i < match_length; ++i) {
+                dst[written + i] = src[i];
+            }
+        }
+        written += match_length;
+    }
+
+    return written == raw_size;
+}
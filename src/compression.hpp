@@ -0,0 +1,26 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <string>
+#include <cstddef>
+
+// Compact LZ4 block codec used for cold clipboard entries and the history file.
+// The output is a raw LZ4 block (no frame header), so the uncompressed size
+// has to be stored next to it by the caller.
+
+// Compress size bytes from data into an LZ4 block
+std::string lz4_compress(const char* data, size_t size);
+
+// Decompress an LZ4 block that expands to exactly raw_size bytes.
+// Returns false if the block is malformed or does not match raw_size.
+bool lz4_decompress(const char* data, size_t size, size_t raw_size, std::string& out);
+
+// Same, writing into a caller buffer of exactly raw_size bytes
+bool lz4_decompress_to(const char* data, size_t size, char* dst, size_t raw_size);
+
+#endif // COMPRESSION_HPP
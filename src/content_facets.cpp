@@ -0,0 +1,615 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "content_facets.hpp"
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+// Bytes the pre-scan looks for; bit i of ByteScan::present is PROBE_BYTES[i]
+static const char PROBE_BYTES[] = {'\n', '@', '/', '\\', ':', '{', '}', '[', ';', '#', '(', '=', ' ', '\t', '.'};
+static const size_t PROBE_COUNT = sizeof(PROBE_BYTES);
+
+enum : uint32_t {
+    HAS_NEWLINE = 1u << 0,
+    HAS_AT = 1u << 1,
+    HAS_SLASH = 1u << 2,
+    HAS_BACKSLASH = 1u << 3,
+    HAS_COLON = 1u << 4,
+    HAS_OPEN_BRACE = 1u << 5,
+    HAS_CLOSE_BRACE = 1u << 6,
+    HAS_OPEN_BRACKET = 1u << 7,
+    HAS_SEMICOLON = 1u << 8,
+    HAS_HASH = 1u << 9,
+    HAS_PAREN = 1u << 10,
+    HAS_EQUALS = 1u << 11,
+    HAS_SPACE = 1u << 12,
+    HAS_TAB = 1u << 13,
+    HAS_DOT = 1u << 14
+};
+
+struct ByteScan {
+    uint32_t present = 0;   // Probe bytes seen
+    size_t newlines = 0;
+};
+
+// A kernel adds the probe bytes of data to scan
+using ScanKernel = void (*)(const char* data, size_t size, ByteScan& scan);
+
+// Probe bits of each byte value
+static const uint32_t* probe_table() {
+    static uint32_t table[256];
+    static const bool filled = [] {
+        for (size_t i = 0; i < PROBE_COUNT; ++i) {
+            table[static_cast<unsigned char>(PROBE_BYTES[i])] |= 1u << i;
+        }
+        return true;
+    }();
+    (void)filled;
+    return table;
+}
+
+static void scan_scalar(const char* data, size_t size, ByteScan& scan) {
+    const uint32_t* table = probe_table();
+    uint32_t present = 0;
+    size_t newlines = 0;
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        present |= table[c];
+        newlines += c == '\n';
+    }
+    scan.present |= present;
+    scan.newlines += newlines;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// Compare each block of 16 (or 32) bytes against every probe byte at once,
+// OR-ing the results per probe; only the newline matches are counted
+__attribute__((target("sse2")))
+static void scan_sse2(const char* data, size_t size, ByteScan& scan) {
+    __m128i seen[PROBE_COUNT];
+    for (size_t p = 0; p < PROBE_COUNT; ++p) {
+        seen[p] = _mm_setzero_si128();
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        for (size_t p = 0; p < PROBE_COUNT; ++p) {
+            seen[p] = _mm_or_si128(seen[p], _mm_cmpeq_epi8(block, _mm_set1_epi8(PROBE_BYTES[p])));
+        }
+        scan.newlines += static_cast<size_t>(__builtin_popcount(
+            static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))))));
+    }
+
+    for (size_t p = 0; p < PROBE_COUNT; ++p) {
+        if (_mm_movemask_epi8(seen[p]) != 0) {
+            scan.present |= 1u << p;
+        }
+    }
+    scan_scalar(data + i, size - i, scan);
+}
+
+__attribute__((target("avx2")))
+static void scan_avx2(const char* data, size_t size, ByteScan& scan) {
+    __m256i seen[PROBE_COUNT];
+    for (size_t p = 0; p < PROBE_COUNT; ++p) {
+        seen[p] = _mm256_setzero_si256();
+    }
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        for (size_t p = 0; p < PROBE_COUNT; ++p) {
+            seen[p] = _mm256_or_si256(seen[p], _mm256_cmpeq_epi8(block, _mm256_set1_epi8(PROBE_BYTES[p])));
+        }
+        scan.newlines += static_cast<size_t>(__builtin_popcount(
+            static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))))));
+    }
+
+    for (size_t p = 0; p < PROBE_COUNT; ++p) {
+        if (_mm256_movemask_epi8(seen[p]) != 0) {
+            scan.present |= 1u << p;
+        }
+    }
+    scan_sse2(data + i, size - i, scan);
+}
+
+#endif // HAVE_X86_KERNELS
+
+// Pick the widest kernel the CPU supports, once
+static ScanKernel choose_kernel() {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return scan_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return scan_sse2;
+    }
+#endif
+    return scan_scalar;
+}
+
+static ScanKernel scan_kernel() {
+    static const ScanKernel kernel = choose_kernel();
+    return kernel;
+}
+
+// --- Character classes ----------------------------------------------------
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool is_alpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static bool is_alnum(char c) {
+    return is_alpha(c) || is_digit(c);
+}
+
+static bool is_hex(char c) {
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static bool is_control(char c) {
+    return static_cast<unsigned char>(c) < 0x20 || c == 0x7f;
+}
+
+static bool in_set(char c, const char* set) {
+    return c != '\0' && strchr(set, c) != nullptr;
+}
+
+static bool starts_with(const char* data, size_t size, const char* prefix) {
+    size_t length = strlen(prefix);
+    return size >= length && memcmp(data, prefix, length) == 0;
+}
+
+static bool starts_with_nocase(const char* data, size_t size, const char* prefix) {
+    size_t length = strlen(prefix);
+    if (size < length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        char c = data[i];
+        if ((c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) != prefix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Checks ---------------------------------------------------------------
+//
+// Each check gets the text without surrounding whitespace and reads it once
+// from left to right.
+
+// scheme://rest or www.host..., as one token
+static bool is_url(const char* s, size_t n) {
+    size_t rest = 0;
+    if (starts_with_nocase(s, n, "www.")) {
+        rest = 4;
+    } else {
+        if (n == 0 || !is_alpha(s[0])) {
+            return false;
+        }
+        size_t i = 1;
+        while (i < n && (is_alnum(s[i]) || s[i] == '+' || s[i] == '-' || s[i] == '.')) {
+            ++i;
+        }
+        if (!starts_with(s + i, n - i, "://")) {
+            return false;
+        }
+        rest = i + 3;
+
+        // Only file URLs may leave the host out
+        if (rest < n && s[rest] == '/' && !(i == 4 && starts_with_nocase(s, n, "file"))) {
+            return false;
+        }
+    }
+    if (rest >= n) {
+        return false;
+    }
+
+    for (size_t i = rest; i < n; ++i) {
+        if (is_control(s[i]) || s[i] == '<' || s[i] == '>' || s[i] == '"') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// local@domain.tld, optionally behind mailto:
+static bool is_email(const char* s, size_t n) {
+    if (starts_with_nocase(s, n, "mailto:")) {
+        s += 7;
+        n -= 7;
+    }
+
+    static const char LOCAL_EXTRA[] = "!#$%&'*+/=?^_`{|}~-.";
+    size_t i = 0;
+    for (; i < n && s[i] != '@'; ++i) {
+        if (!is_alnum(s[i]) && !in_set(s[i], LOCAL_EXTRA)) {
+            return false;
+        }
+        if (s[i] == '.' && (i == 0 || s[i - 1] == '.')) {
+            return false;
+        }
+    }
+    if (i == 0 || i > 64 || i >= n || s[i - 1] == '.') {
+        return false;
+    }
+
+    // Labels of letters, digits and inner hyphens; at least two, ending in
+    // an alphabetic top-level domain
+    size_t labels = 0;
+    size_t label_start = i + 1;
+    size_t label_length = 0;
+    bool label_alpha = true;
+    for (size_t j = i + 1; j <= n; ++j) {
+        if (j == n || s[j] == '.') {
+            label_length = j - label_start;
+            if (label_length == 0 || s[label_start] == '-' || s[j - 1] == '-') {
+                return false;
+            }
+            ++labels;
+            if (j < n) {
+                label_start = j + 1;
+                label_alpha = true;
+            }
+            continue;
+        }
+        if (!is_alnum(s[j]) && s[j] != '-') {
+            return false;
+        }
+        label_alpha = label_alpha && is_alpha(s[j]);
+    }
+    return labels >= 2 && label_alpha && label_length >= 2;
+}
+
+// Absolute, home, relative or Windows path, as one token
+static bool is_path(const char* s, size_t n, uint32_t present) {
+    bool anchored = (n >= 2 && s[0] == '/' && s[1] != '/') ||
+                    starts_with(s, n, "~/") || starts_with(s, n, "./") || starts_with(s, n, "../") ||
+                    starts_with(s, n, "\\\\") ||
+                    (n >= 3 && is_alpha(s[0]) && s[1] == ':' && (s[2] == '\\' || s[2] == '/'));
+
+    size_t slashes = 0;
+    bool only_digits = true;
+    for (size_t i = 0; i < n; ++i) {
+        char c = s[i];
+        if (is_control(c) || c == '<' || c == '>' || c == '"' || c == '|' || c == '*' || c == '?') {
+            return false;
+        }
+        if (c == '/' || c == '\\') {
+            ++slashes;
+        } else if (!is_digit(c)) {
+            only_digits = false;
+        }
+    }
+    if (anchored) {
+        return true;
+    }
+
+    // dir/file.ext or a/b/c, but not and/or nor 1/2/3
+    if (!(present & HAS_SLASH) || (present & HAS_COLON) || only_digits || !(is_alnum(s[0]) || s[0] == '_' || s[0] == '.')) {
+        return false;
+    }
+    const char* last_slash = static_cast<const char*>(memrchr(s, '/', n));
+    const char* last_dot = static_cast<const char*>(memrchr(s, '.', n));
+    bool extension = last_dot && last_dot > last_slash && last_dot + 1 < s + n && is_alnum(last_dot[1]);
+    return slashes >= 2 || extension;
+}
+
+// 42, -3.5, 1,234.56, 1.234,56, 1_000_000, 6.02e23, 15%, 0xff
+static bool is_number(const char* s, size_t n) {
+    size_t i = 0;
+    if (i < n && (s[i] == '+' || s[i] == '-')) {
+        ++i;
+    }
+    if (n - i > 2 && s[i] == '0' && (s[i + 1] == 'x' || s[i + 1] == 'X')) {
+        for (i += 2; i < n; ++i) {
+            if (!is_hex(s[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Digit groups and the separators between them
+    static const size_t MAX_GROUPS = 32;
+    size_t groups[MAX_GROUPS];
+    char separators[MAX_GROUPS];
+    size_t count = 0;
+    size_t length = 0;
+    for (; i < n && !(s[i] == 'e' || s[i] == 'E' || s[i] == '%'); ++i) {
+        char c = s[i];
+        if (is_digit(c)) {
+            ++length;
+        } else if (c == '.' || c == ',' || c == '_' || c == '\'') {
+            if (count + 1 >= MAX_GROUPS || (length == 0 && count > 0)) {
+                return false;
+            }
+            groups[count] = length;
+            separators[count++] = c;
+            length = 0;
+        } else {
+            return false;
+        }
+    }
+    if (length == 0) {
+        return false;
+    }
+    groups[count] = length;
+
+    // Only the last separator may be a decimal point; the others group
+    // thousands
+    for (size_t k = 0; k < count; ++k) {
+        bool decimal = k + 1 == count && (separators[k] == '.' || separators[k] == ',');
+        if (!decimal && groups[k + 1] != 3) {
+            return false;
+        }
+        if (k == 0 && !decimal && (groups[0] == 0 || groups[0] > 3)) {
+            return false;
+        }
+    }
+
+    if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+        ++i;
+        if (i < n && (s[i] == '+' || s[i] == '-')) {
+            ++i;
+        }
+        size_t digits = 0;
+        for (; i < n && is_digit(s[i]); ++i) {
+            ++digits;
+        }
+        if (digits == 0) {
+            return false;
+        }
+    }
+    if (i < n && s[i] == '%') {
+        ++i;
+    }
+    return i == n;
+}
+
+// #rgb, #rgba, #rrggbb, #rrggbbaa, rgb(...), rgba(...), hsl(...), hsla(...)
+static bool is_color(const char* s, size_t n) {
+    if (s[0] == '#') {
+        if (n != 4 && n != 5 && n != 7 && n != 9) {
+            return false;
+        }
+        for (size_t i = 1; i < n; ++i) {
+            if (!is_hex(s[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t i = 0;
+    if (starts_with_nocase(s, n, "rgba(") || starts_with_nocase(s, n, "hsla(")) {
+        i = 5;
+    } else if (starts_with_nocase(s, n, "rgb(") || starts_with_nocase(s, n, "hsl(")) {
+        i = 4;
+    } else {
+        return false;
+    }
+    if (s[n - 1] != ')') {
+        return false;
+    }
+
+    bool digits = false;
+    for (; i + 1 < n; ++i) {
+        char c = s[i];
+        if (is_digit(c)) {
+            digits = true;
+        } else if (!in_set(c, ".,%/ +-deg")) {
+            return false;
+        }
+    }
+    return digits;
+}
+
+// An object or array: balanced brackets outside of strings, and nothing
+// outside of strings but numbers, true, false, null and punctuation
+static bool is_json(const char* s, size_t n) {
+    if (n < 2 || !((s[0] == '{' && s[n - 1] == '}') || (s[0] == '[' && s[n - 1] == ']'))) {
+        return false;
+    }
+
+    std::vector<char> open;
+    bool in_string = false;
+    bool escape = false;
+    for (size_t i = 0; i < n; ++i) {
+        char c = s[i];
+        if (in_string) {
+            if (escape) {
+                escape = false;
+            } else if (c == '\\') {
+                escape = true;
+            } else if (c == '"') {
+                in_string = false;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                return false;
+            }
+            continue;
+        }
+
+        if (c == '"') {
+            in_string = true;
+        } else if (c == '{' || c == '[') {
+            open.push_back(c);
+        } else if (c == '}' || c == ']') {
+            if (open.empty() || open.back() != (c == '}' ? '{' : '[')) {
+                return false;
+            }
+            open.pop_back();
+
+            // The outermost value must end the text
+            if (open.empty() && i + 1 != n) {
+                return false;
+            }
+        } else if (is_alpha(c)) {
+            size_t end = i;
+            while (end < n && is_alpha(s[end])) {
+                ++end;
+            }
+            size_t length = end - i;
+            bool literal = (length == 4 && (memcmp(s + i, "true", 4) == 0 || memcmp(s + i, "null", 4) == 0)) ||
+                           (length == 5 && memcmp(s + i, "false", 5) == 0);
+            bool exponent = length == 1 && (c == 'e' || c == 'E') && i > 0 && is_digit(s[i - 1]);
+            if (!literal && !exponent) {
+                return false;
+            }
+            i = end - 1;
+        } else if (!(is_digit(c) || is_space(c) || c == ',' || c == ':' || c == '-' || c == '+' || c == '.')) {
+            return false;
+        }
+    }
+    return !in_string && open.empty();
+}
+
+// Lines sampled by the code check
+static const size_t CODE_SAMPLE_LINES = 200;
+
+static const char* const CODE_PREFIXES[] = {
+    "#include", "#define", "#!", "import ", "from ", "package ", "using ", "def ", "class ", "struct ",
+    "fn ", "func ", "function", "return", "if (", "for (", "while (", "switch (", "} else", "const ",
+    "let ", "var ", "public ", "private ", "protected ", "static ", "template", "namespace ", "//", "/*",
+};
+
+// Whether a line (without its indentation) reads like a statement
+static bool is_code_line(const char* s, size_t n) {
+    char last = s[n - 1];
+    if (last == ';' || last == '{' || last == '}') {
+        return true;
+    }
+    for (const char* prefix : CODE_PREFIXES) {
+        if (starts_with(s, n, prefix)) {
+            return true;
+        }
+    }
+
+    // Operators that do not show up in prose
+    for (size_t i = 0; i + 1 < n; ++i) {
+        char c = s[i];
+        char next = s[i + 1];
+        if ((c == '=' && (next == '>' || next == '=')) || (c == '-' && next == '>') ||
+            (c == ':' && next == ':') || (c == '&' && next == '&') || (c == '|' && next == '|') ||
+            (c == ' ' && next == '=' && i + 2 < n && s[i + 2] == ' ')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// At least half of the sampled non-empty lines read like statements
+static bool is_code(const char* s, size_t n) {
+    size_t lines = 0;
+    size_t code_lines = 0;
+    size_t start = 0;
+    while (start < n && lines < CODE_SAMPLE_LINES) {
+        const char* newline = static_cast<const char*>(memchr(s + start, '\n', n - start));
+        size_t end = newline ? static_cast<size_t>(newline - s) : n;
+
+        size_t first = start;
+        size_t last = end;
+        while (first < last && is_space(s[first])) {
+            ++first;
+        }
+        while (last > first && is_space(s[last - 1])) {
+            --last;
+        }
+        if (first < last) {
+            ++lines;
+            code_lines += is_code_line(s + first, last - first);
+        }
+        start = end + 1;
+    }
+    return code_lines > 0 && code_lines * 2 >= lines;
+}
+
+// --- Classifier -----------------------------------------------------------
+
+FacetMask classify_content(const char* data, size_t size) {
+    size_t begin = 0;
+    size_t end = size;
+    while (begin < end && is_space(data[begin])) {
+        ++begin;
+    }
+    while (end > begin && is_space(data[end - 1])) {
+        --end;
+    }
+    if (begin == end) {
+        return 0;
+    }
+
+    const char* s = data + begin;
+    size_t n = end - begin;
+    ByteScan scan;
+    scan_kernel()(s, n, scan);
+
+    FacetMask facets = 0;
+    if (scan.newlines > 0) {
+        facets |= facet_bit(Facet::MULTILINE);
+    }
+
+    bool one_token = !(scan.present & (HAS_SPACE | HAS_TAB | HAS_NEWLINE)) &&
+                     !memchr(s, '\r', n) && !memchr(s, '\f', n) && !memchr(s, '\v', n);
+    if (one_token) {
+        if (((scan.present & HAS_COLON && scan.present & HAS_SLASH) || scan.present & HAS_DOT) && is_url(s, n)) {
+            facets |= facet_bit(Facet::URL);
+        } else if (scan.present & HAS_AT && scan.present & HAS_DOT && is_email(s, n)) {
+            facets |= facet_bit(Facet::EMAIL);
+        } else if (scan.present & (HAS_SLASH | HAS_BACKSLASH) && is_path(s, n, scan.present)) {
+            facets |= facet_bit(Facet::PATH);
+        } else if (n <= 64 && is_number(s, n)) {
+            facets |= facet_bit(Facet::NUMBER);
+        }
+    }
+
+    if (!(scan.present & HAS_NEWLINE) && n <= 64 && (scan.present & (HAS_HASH | HAS_PAREN)) && is_color(s, n)) {
+        facets |= facet_bit(Facet::COLOR);
+    }
+
+    if ((scan.present & (HAS_OPEN_BRACE | HAS_OPEN_BRACKET)) && is_json(s, n)) {
+        facets |= facet_bit(Facet::JSON);
+    } else if (!(facets & (facet_bit(Facet::URL) | facet_bit(Facet::PATH))) &&
+               (scan.present & (HAS_SEMICOLON | HAS_OPEN_BRACE | HAS_CLOSE_BRACE | HAS_PAREN | HAS_EQUALS |
+                                HAS_COLON | HAS_SLASH | HAS_HASH)) &&
+               is_code(s, n)) {
+        facets |= facet_bit(Facet::CODE);
+    }
+    return facets;
+}
+
+static const char* const FACET_NAMES[FACET_COUNT] = {
+    "url", "path", "email", "number", "color", "json", "code", "multiline"
+};
+
+const char* facet_name(Facet facet) {
+    return FACET_NAMES[static_cast<size_t>(facet)];
+}
+
+bool facet_from_name(const std::string& name, Facet& facet) {
+    for (size_t i = 0; i < FACET_COUNT; ++i) {
+        if (name == FACET_NAMES[i]) {
+            facet = static_cast<Facet>(i);
+            return true;
+        }
+    }
+    return false;
+}
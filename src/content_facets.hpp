@@ -0,0 +1,48 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef CONTENT_FACETS_HPP
+#define CONTENT_FACETS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Kinds of content an entry is tagged with at ingest, so the history can be
+// filtered by type without scanning the texts again
+enum class Facet {
+    URL,
+    PATH,
+    EMAIL,
+    NUMBER,
+    COLOR,
+    JSON,
+    CODE,
+    MULTILINE
+};
+
+const size_t FACET_COUNT = 8;
+
+// Set of facets, one bit per Facet
+using FacetMask = uint16_t;
+
+inline FacetMask facet_bit(Facet facet) {
+    return static_cast<FacetMask>(1u << static_cast<unsigned>(facet));
+}
+
+// Tag a text. One vectorized pass records which structural bytes occur and
+// counts the lines; only the checks those bytes allow then run, each a single
+// left-to-right pass without backtracking. Surrounding whitespace is ignored.
+FacetMask classify_content(const char* data, size_t size);
+
+inline FacetMask classify_content(const std::string& text) {
+    return classify_content(text.data(), text.size());
+}
+
+// Lowercase name of a facet ("url", "multiline", ...) and the reverse
+const char* facet_name(Facet facet);
+bool facet_from_name(const std::string& name, Facet& facet);
+
+#endif // CONTENT_FACETS_HPP
@@ -0,0 +1,331 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "display_hub.hpp"
+#include "clipboard_manager.hpp"
+#include "x11_selection.hpp"
+#include <glib-unix.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+const int DisplayHub::FETCH_TIMEOUT_MS;
+
+// Most events handled per epoll_wait() call
+static const int MAX_EVENTS = 64;
+
+struct DisplayHub::Session {
+    std::string name;
+    std::unique_ptr<X11Selection> source;
+    std::unique_ptr<ClipboardManager> manager;
+
+    // Last contents seen on this display (capture thread)
+    SeenText seen_clipboard;
+    SeenText seen_primary;
+
+    // Deadline (monotonic us) at which a settled PRIMARY selection is read, 0 if none
+    gint64 primary_deadline = 0;
+
+    // Whether the X connection is still up
+    bool alive = true;
+};
+
+DisplayHub::DisplayHub()
+    : epoll_fd_(-1), wake_fd_(-1), running_(false), filter_(CaptureFilter::from_environment()) {
+}
+
+DisplayHub::~DisplayHub() {
+    stop();
+}
+
+std::string DisplayHub::history_path_for(const std::string& name) {
+    std::string base = ClipboardManager::history_file_path();
+    if (base.empty()) {
+        return base;
+    }
+
+    // ":1" becomes "1" and "host:2.0" becomes "host_2.0"
+    std::string suffix;
+    for (size_t i = (!name.empty() && name[0] == ':') ? 1 : 0; i < name.size(); ++i) {
+        unsigned char c = name[i];
+        suffix += (std::isalnum(c) || c == '.' || c == '-') ? static_cast<char>(c) : '_';
+    }
+    return base + ".display-" + suffix;
+}
+
+bool DisplayHub::add_display(const std::string& name, std::string& error) {
+    std::unique_ptr<Session> session(new Session());
+    session->name = name;
+    session->source = X11Selection::open(name.c_str());
+    if (!session->source) {
+        error = "cannot open display";
+        return false;
+    }
+    if (!session->source->watch_selections()) {
+        error = "no XFixes extension";
+        return false;
+    }
+
+    session->manager.reset(new ClipboardManager(history_path_for(name)));
+    session->manager->start_injected_monitoring();
+    sessions_.push_back(std::move(session));
+    return true;
+}
+
+bool DisplayHub::start() {
+    if (running_) {
+        return true;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::cerr << "Could not set up the display event loop: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    for (auto& session : sessions_) {
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = session.get();
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, session->source->get_fd(), &event) != 0) {
+            std::cerr << "Could not watch display " << session->name << ": " << strerror(errno) << std::endl;
+        }
+    }
+
+    running_ = true;
+    thread_ = std::thread(&DisplayHub::capture_loop, this);
+    return true;
+}
+
+void DisplayHub::stop() {
+    if (running_) {
+        running_ = false;
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            std::cerr << "Could not wake the display thread: " << strerror(errno) << std::endl;
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+}
+
+size_t DisplayHub::get_display_count() const {
+    return sessions_.size();
+}
+
+ClipboardManager& DisplayHub::get_manager(size_t index) {
+    return *sessions_[index]->manager;
+}
+
+const std::string& DisplayHub::get_display_name(size_t index) const {
+    return sessions_[index]->name;
+}
+
+void DisplayHub::capture(Session& session, Selection selection) {
+    // Ask the owner what it holds first; an owner that does not answer
+    // TARGETS is read anyway
+    SelectionMetadata metadata;
+    if (filter_.is_active() && session.source->fetch_metadata(selection, metadata, FETCH_TIMEOUT_MS) &&
+        !filter_.allows(metadata)) {
+        return;
+    }
+
+    std::string content;
+    if (!session.source->fetch_text(selection, content, FETCH_TIMEOUT_MS) || content.empty()) {
+        return;
+    }
+
+    if (selection == Selection::CLIPBOARD) {
+        if (session.seen_clipboard.matches(content)) {
+            return;
+        }
+        ClipboardText text = std::make_shared<const std::string>(std::move(content));
+        session.seen_clipboard.remember(text);
+        session.manager->inject_capture(Selection::CLIPBOARD, std::move(text));
+    } else {
+        // Skip a selection that was also copied to the clipboard
+        if (session.seen_primary.matches(content) || session.seen_clipboard.matches(content)) {
+            return;
+        }
+        ClipboardText text = std::make_shared<const std::string>(std::move(content));
+        session.seen_primary.remember(text);
+        session.manager->inject_capture(Selection::PRIMARY, std::move(text));
+    }
+}
+
+bool DisplayHub::with_display(Session& session, const std::function<void()>& body) {
+    if (!session.alive) {
+        return false;
+    }
+    if (!session.source->with_connection(body)) {
+        drop(session);
+        return false;
+    }
+    return true;
+}
+
+void DisplayHub::drop(Session& session) {
+    std::cerr << "Display " << session.name << " went away; its history stays loaded" << std::endl;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, session.source->get_fd(), nullptr);
+    session.alive = false;
+    session.primary_deadline = 0;
+}
+
+void DisplayHub::capture_loop() {
+    // Pick up whatever each clipboard holds at startup
+    for (auto& session : sessions_) {
+        with_display(*session, [this, &session]() { capture(*session, Selection::CLIPBOARD); });
+    }
+
+    epoll_event events[MAX_EVENTS];
+    bool overflow_pending = false;
+
+    while (running_) {
+        // Sleep until an X event, the next settled PRIMARY selection or, while
+        // a store's ring is full, the next retry
+        int timeout_ms = -1;
+        gint64 now = g_get_monotonic_time();
+        for (const auto& session : sessions_) {
+            if (session->primary_deadline != 0) {
+                int wait_ms = static_cast<int>(std::max<gint64>(0, (session->primary_deadline - now) / 1000));
+                timeout_ms = timeout_ms < 0 ? wait_ms : std::min(timeout_ms, wait_ms);
+            }
+        }
+        if (overflow_pending) {
+            timeout_ms = timeout_ms < 0 ? 50 : std::min(timeout_ms, 50);
+        }
+
+        int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout_ms);
+        if (count < 0 && errno != EINTR) {
+            std::cerr << "Display event loop failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (!running_) {
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            Session* session = static_cast<Session*>(events[i].data.ptr);
+            if (!session || !session->alive) {
+                continue;
+            }
+            if (events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+                drop(*session);
+                continue;
+            }
+
+            // A transfer may queue further owner changes, which no longer
+            // show up on the socket; keep reading until none is left
+            with_display(*session, [this, session]() {
+                std::vector<Selection> changes;
+                while (!(changes = session->source->read_changes()).empty()) {
+                    for (Selection selection : changes) {
+                        if (selection == Selection::CLIPBOARD) {
+                            capture(*session, Selection::CLIPBOARD);
+                        } else if (session->manager->get_primary_tracking()) {
+                            // Each drag step re-announces ownership; only read once it goes quiet
+                            session->primary_deadline = g_get_monotonic_time() +
+                                static_cast<gint64>(ClipboardManager::PRIMARY_DEBOUNCE_MS) * 1000;
+                        }
+                    }
+                }
+            });
+        }
+
+        now = g_get_monotonic_time();
+        overflow_pending = false;
+        for (auto& session : sessions_) {
+            if (session->primary_deadline != 0 && now >= session->primary_deadline) {
+                session->primary_deadline = 0;
+                with_display(*session, [this, &session]() { capture(*session, Selection::PRIMARY); });
+            }
+
+            // Retry an event that did not fit in the store's ring
+            if (!session->manager->flush_injection()) {
+                overflow_pending = true;
+            }
+        }
+    }
+}
+
+bool is_multi_display_command(int argc, char* argv[]) {
+    return argc > 1 && strcmp(argv[1], "--displays") == 0;
+}
+
+int run_multi_display_command(int argc, char* argv[]) {
+    std::vector<std::string> names;
+    for (int i = 2; i < argc; ++i) {
+        if (argv[i][0] == '-' || std::find(names.begin(), names.end(), argv[i]) != names.end()) {
+            names.clear();
+            break;
+        }
+        names.push_back(argv[i]);
+    }
+    if (names.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --displays DISPLAY..." << std::endl;
+        return 2;
+    }
+
+    GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+    int status = 0;
+    {
+        // Destroying the hub stops its thread before the stores save their
+        // histories
+        DisplayHub hub;
+        for (const auto& name : names) {
+            std::string error;
+            if (!hub.add_display(name, error)) {
+                std::cerr << "Skipping display " << name << ": " << error << std::endl;
+                continue;
+            }
+            size_t index = hub.get_display_count() - 1;
+            std::cout << "Watching " << name << " (history " << DisplayHub::history_path_for(name) << ", "
+                      << hub.get_manager(index).get_entry_count() << " entries)" << std::endl;
+        }
+
+        if (hub.get_display_count() == 0 || !hub.start()) {
+            status = 1;
+        } else {
+            auto quit = +[](gpointer user_data) -> gboolean {
+                g_main_loop_quit(static_cast<GMainLoop*>(user_data));
+                return G_SOURCE_CONTINUE;
+            };
+            guint sigint = g_unix_signal_add(SIGINT, quit, loop);
+            guint sigterm = g_unix_signal_add(SIGTERM, quit, loop);
+
+            g_main_loop_run(loop);
+
+            g_source_remove(sigint);
+            g_source_remove(sigterm);
+            hub.stop();
+
+            // Ingest what the stores still have queued
+            while (g_main_context_iteration(nullptr, FALSE)) {
+            }
+        }
+    }
+    g_main_loop_unref(loop);
+    return status;
+}
@@ -0,0 +1,97 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef DISPLAY_HUB_HPP
+#define DISPLAY_HUB_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_event.hpp"
+#include "capture_filter.hpp"
+
+class ClipboardManager;
+class X11Selection;
+
+// Headless monitoring of several X displays from one process:
+//
+//   clipboard_manager --displays :1 :2 ...
+//
+// One thread waits on all the X connections with a single epoll set and
+// feeds each display's captures into that display's own ClipboardManager,
+// whose history is saved to a file of its own (see history_path_for).
+// The stores drain on the GLib main loop of the calling thread, so a session
+// costs an X connection and a history, not a process with a GTK stack and
+// its timers. Selections are only watched through XFixes; there is no xclip
+// polling fallback here.
+class DisplayHub {
+public:
+    // Captures of a stuck selection owner wait at most this long per step,
+    // since every other display waits with them
+    static const int FETCH_TIMEOUT_MS = 250;
+
+    DisplayHub();
+    ~DisplayHub();
+
+    DisplayHub(const DisplayHub&) = delete;
+    DisplayHub& operator=(const DisplayHub&) = delete;
+
+    // Connect to a display and load its history; false (with error set) if
+    // the display is unreachable or lacks XFixes. Only before start().
+    bool add_display(const std::string& name, std::string& error);
+
+    // Start and stop the capture thread
+    bool start();
+    void stop();
+
+    size_t get_display_count() const;
+
+    // History store of the display at index
+    ClipboardManager& get_manager(size_t index);
+    const std::string& get_display_name(size_t index) const;
+
+    // History file of a display: the default history file with the display
+    // name appended, e.g. ~/.clipboard_history.display-1 for :1
+    static std::string history_path_for(const std::string& name);
+
+private:
+    struct Session;
+
+    void capture_loop();
+
+    // Read a selection whose owner changed and publish it if it is new
+    void capture(Session& session, Selection selection);
+
+    // Run body against a session's X connection; if the connection is lost
+    // meanwhile, drop the session and return false. The other displays and
+    // their histories carry on.
+    bool with_display(Session& session, const std::function<void()>& body);
+
+    // Stop watching a display whose connection went away
+    void drop(Session& session);
+
+    std::vector<std::unique_ptr<Session>> sessions_;
+
+    int epoll_fd_;
+    int wake_fd_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+
+    // Rules for selections not worth reading, shared by all displays
+    CaptureFilter filter_;
+};
+
+// Whether argv asks for --displays
+bool is_multi_display_command(int argc, char* argv[]);
+
+// Parse the arguments and monitor the displays until SIGINT or SIGTERM;
+// returns the process exit status
+int run_multi_display_command(int argc, char* argv[]);
+
+#endif // DISPLAY_HUB_HPP
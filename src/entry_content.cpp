@@ -0,0 +1,89 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "entry_content.hpp"
+#include "compression.hpp"
+#include <algorithm>
+
+EntryContent::EntryContent(const ClipboardEntry& entry) : size_(entry.get_size()) {
+    if (entry.is_chunked()) {
+        chunks_ = entry.get_chunks();
+        chunk_starts_.reserve(chunks_.size() + 1);
+        size_t offset = 0;
+        for (const ChunkRef& chunk : chunks_) {
+            chunk_starts_.push_back(offset);
+            offset += chunk->raw_size;
+        }
+        chunk_starts_.push_back(offset);
+        size_ = std::min(size_, offset);
+    } else {
+        text_ = entry.get_text();
+        size_ = text_ ? text_->size() : 0;
+    }
+}
+
+size_t EntryContent::size() const {
+    return size_;
+}
+
+ClipboardText EntryContent::chunk_data(size_t index) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const CachedChunk& cached : cache_) {
+            if (cached.index == index) {
+                return cached.data;
+            }
+        }
+    }
+
+    // Decompress outside the lock so the UI does not wait on the indexer
+    const StoredChunk& chunk = *chunks_[index];
+    auto data = std::make_shared<std::string>();
+    if (chunk.compressed) {
+        if (!lz4_decompress(chunk.data.data(), chunk.data.size(), chunk.raw_size, *data)) {
+            return nullptr;
+        }
+    } else {
+        data->assign(chunk.data, 0, chunk.raw_size);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    CachedChunk& slot = cache_[cache_next_];
+    cache_next_ = (cache_next_ + 1) % CACHED_CHUNKS;
+    slot.index = index;
+    slot.data = data;
+    return slot.data;
+}
+
+size_t EntryContent::read(size_t offset, size_t length, std::string& out) const {
+    out.clear();
+    if (offset >= size_) {
+        return 0;
+    }
+    length = std::min(length, size_ - offset);
+
+    if (text_) {
+        out.assign(*text_, offset, length);
+        return out.size();
+    }
+
+    // Walk the chunks covering [offset, offset + length)
+    out.reserve(length);
+    size_t index = static_cast<size_t>(std::upper_bound(chunk_starts_.begin(), chunk_starts_.end(), offset) -
+                                       chunk_starts_.begin()) - 1;
+    size_t position = offset;
+    while (out.size() < length && index < chunks_.size()) {
+        ClipboardText data = chunk_data(index);
+        if (!data) {
+            out.clear();
+            return 0;
+        }
+        size_t within = position - chunk_starts_[index];
+        size_t take = std::min(length - out.size(), data->size() - within);
+        out.append(*data, within, take);
+        position += take;
+        ++index;
+    }
+    return out.size();
+}
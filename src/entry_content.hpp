@@ -0,0 +1,58 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef ENTRY_CONTENT_HPP
+#define ENTRY_CONTENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "clipboard_entry.hpp"
+
+// Random access to the content of an entry without materializing it: raw
+// payloads are read in place, and chunked ones one pooled chunk at a time,
+// keeping the last few decompressed chunks. Small LZ4 payloads are
+// decompressed whole. Holds its own references, so it stays readable from
+// any thread whatever happens to the entry afterwards.
+class EntryContent {
+public:
+    // Snapshot of the entry's payload (main thread)
+    explicit EntryContent(const ClipboardEntry& entry);
+
+    EntryContent(const EntryContent&) = delete;
+    EntryContent& operator=(const EntryContent&) = delete;
+
+    size_t size() const;
+
+    // Replace out with up to length bytes starting at offset; returns the
+    // number of bytes read (0 past the end or if a chunk is corrupt)
+    size_t read(size_t offset, size_t length, std::string& out) const;
+
+private:
+    // Decompressed chunks kept between reads
+    static const size_t CACHED_CHUNKS = 4;
+
+    struct CachedChunk {
+        size_t index = SIZE_MAX;
+        ClipboardText data;
+    };
+
+    // Raw content of chunk index, from the cache or decompressed
+    ClipboardText chunk_data(size_t index) const;
+
+    size_t size_;
+    ClipboardText text_;                // Whole payload unless chunked
+    ChunkList chunks_;
+    std::vector<size_t> chunk_starts_;  // Offset of each chunk, plus the end
+
+    mutable std::mutex mutex_;
+    mutable CachedChunk cache_[CACHED_CHUNKS];
+    mutable size_t cache_next_ = 0;
+};
+
+#endif // ENTRY_CONTENT_HPP
@@ -0,0 +1,33 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef EXPIRY_POLICY_HPP
+#define EXPIRY_POLICY_HPP
+
+#include <ctime>
+#include <string>
+
+// Time-to-live rules applied to new entries. A TTL of 0 keeps entries until
+// they are evicted or removed by hand, which is the default: nothing expires
+// unless the user asks for it.
+struct ExpiryPolicy {
+    // Lifetime of content that looks like a password, token or key
+    std::time_t secret_ttl = 0;
+
+    // Lifetime of everything else
+    std::time_t default_ttl = 0;
+
+    // Set from VMCASTLE_SECRET_TTL (seconds) and VMCASTLE_HISTORY_TTL_DAYS
+    static ExpiryPolicy from_environment();
+
+    // TTL in seconds for a new entry holding text
+    std::time_t ttl_for(const std::string& text) const;
+};
+
+// Whether text looks like a credential: a known token or key format, or a
+// single short word mixing lowercase, uppercase and digits
+bool looks_like_secret(const std::string& text);
+
+#endif // EXPIRY_POLICY_HPP
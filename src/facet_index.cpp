@@ -0,0 +1,81 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "facet_index.hpp"
+
+void FacetIndex::build(const std::vector<std::shared_ptr<ClipboardEntry>>& entries) {
+    clear();
+    size_ = entries.size();
+
+    size_t words = (size_ + 63) / 64;
+    for (auto& bitmap : bitmaps_) {
+        bitmap.assign(words, 0);
+    }
+
+    for (size_t i = 0; i < size_; ++i) {
+        FacetMask facets = entries[i]->get_facets();
+        while (facets != 0) {
+            unsigned facet = static_cast<unsigned>(__builtin_ctz(facets));
+            bitmaps_[facet][i / 64] |= uint64_t(1) << (i % 64);
+            facets &= static_cast<FacetMask>(facets - 1);
+        }
+    }
+}
+
+void FacetIndex::clear() {
+    size_ = 0;
+    for (auto& bitmap : bitmaps_) {
+        std::vector<uint64_t>().swap(bitmap);
+    }
+}
+
+size_t FacetIndex::size() const {
+    return size_;
+}
+
+std::vector<uint64_t> FacetIndex::combine(FacetMask wanted) const {
+    std::vector<uint64_t> combined((size_ + 63) / 64, ~uint64_t(0));
+    for (size_t facet = 0; facet < FACET_COUNT; ++facet) {
+        if (wanted & (1u << facet)) {
+            const auto& bitmap = bitmaps_[facet];
+            for (size_t w = 0; w < combined.size(); ++w) {
+                combined[w] &= bitmap[w];
+            }
+        }
+    }
+    return combined;
+}
+
+void FacetIndex::filter(FacetMask wanted, std::vector<size_t>& matches) const {
+    if (wanted == 0) {
+        return;
+    }
+
+    std::vector<uint64_t> combined = combine(wanted);
+    size_t kept = 0;
+    for (size_t index : matches) {
+        if (index < size_ && (combined[index / 64] >> (index % 64)) & 1) {
+            matches[kept++] = index;
+        }
+    }
+    matches.resize(kept);
+}
+
+void FacetIndex::select(FacetMask wanted, std::vector<size_t>& matches) const {
+    matches.clear();
+    std::vector<uint64_t> combined = combine(wanted);
+
+    // The last word may have bits past the end when wanted is empty
+    for (size_t w = 0; w < combined.size(); ++w) {
+        uint64_t bits = combined[w];
+        while (bits != 0) {
+            size_t index = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+            if (index >= size_) {
+                break;
+            }
+            matches.push_back(index);
+            bits &= bits - 1;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef FACET_INDEX_HPP
+#define FACET_INDEX_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "clipboard_entry.hpp"
+#include "content_facets.hpp"
+
+// One bitmap per facet over the positions of a history stream, packed from
+// the facets the entries were tagged with at ingest. Filtering by type is a
+// few word ANDs, and narrowing text search matches one bit test each.
+class FacetIndex {
+public:
+    // Pack the facets of entries, in history order
+    void build(const std::vector<std::shared_ptr<ClipboardEntry>>& entries);
+
+    // Release the bitmaps
+    void clear();
+
+    // Keep in matches (ascending indices) only the entries that carry every
+    // facet in wanted; matches is left alone when wanted is empty
+    void filter(FacetMask wanted, std::vector<size_t>& matches) const;
+
+    // Indices of all entries that carry every facet in wanted, ascending
+    void select(FacetMask wanted, std::vector<size_t>& matches) const;
+
+    // Number of packed entries
+    size_t size() const;
+
+private:
+    // AND of the bitmaps of the facets in wanted
+    std::vector<uint64_t> combine(FacetMask wanted) const;
+
+    size_t size_ = 0;
+    std::vector<uint64_t> bitmaps_[FACET_COUNT];
+};
+
+#endif // FACET_INDEX_HPP
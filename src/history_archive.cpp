@@ -0,0 +1,523 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "history_archive.hpp"
+#include "history_file.hpp"
+#include "text_hash.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Entries this large are stored as LZ4 blocks when that pays off, as in the
+// history file
+static const size_t COMPRESS_MIN_SIZE = 256;
+
+// Indexes claiming more entries than this are treated as corruption
+static const size_t MAX_SEGMENT_ENTRIES = 1 << 24;
+
+static const char JOURNAL_NAME[] = "journal";
+static const char SEGMENT_SUFFIX[] = ".seg";
+
+static bool newer(const ArchivedText& a, const ArchivedText& b) {
+    return a.timestamp > b.timestamp;
+}
+
+HistoryArchive::HistoryArchive(std::string directory, Period period, std::time_t retention)
+    : directory_(std::move(directory)), period_(period), retention_(retention) {
+}
+
+HistoryArchive::Period HistoryArchive::period_from_environment() {
+    const char* value = getenv("VMCASTLE_ARCHIVE_PERIOD");
+    return value && strcmp(value, "week") == 0 ? Period::WEEK : Period::DAY;
+}
+
+std::time_t HistoryArchive::period_start(std::time_t time, Period period) {
+    std::tm tm = {};
+    localtime_r(&time, &tm);
+    if (period == Period::WEEK) {
+        // Weeks start on Monday
+        tm.tm_mday -= (tm.tm_wday + 6) % 7;
+    }
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+std::time_t HistoryArchive::period_end(std::time_t start, Period period) {
+    // Calendar arithmetic, so days crossing a DST change still line up
+    std::tm tm = {};
+    localtime_r(&start, &tm);
+    tm.tm_mday += period == Period::WEEK ? 7 : 1;
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+std::string HistoryArchive::path_of(const std::string& name) const {
+    return directory_ + "/" + name;
+}
+
+const std::string& HistoryArchive::get_directory() const {
+    return directory_;
+}
+
+void HistoryArchive::list_segments() {
+    if (listed_) {
+        return;
+    }
+    listed_ = true;
+
+    DIR* dir = opendir(directory_.c_str());
+    if (!dir) {
+        return;
+    }
+    while (dirent* item = readdir(dir)) {
+        int year = 0, month = 0, day = 0;
+        char kind[8] = {};
+        int length = 0;
+        if (sscanf(item->d_name, "%d-%d-%d.%7[a-z]%n", &year, &month, &day, kind, &length) != 4 ||
+            strcmp(item->d_name + length, SEGMENT_SUFFIX) != 0) {
+            continue;
+        }
+
+        Segment segment;
+        if (strcmp(kind, "day") == 0) {
+            segment.period = Period::DAY;
+        } else if (strcmp(kind, "week") == 0) {
+            segment.period = Period::WEEK;
+        } else {
+            continue;
+        }
+        std::tm tm = {};
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_isdst = -1;
+        segment.name = item->d_name;
+        segment.start = mktime(&tm);
+        segment.end = period_end(segment.start, segment.period);
+        segments_.push_back(std::move(segment));
+    }
+    closedir(dir);
+
+    std::sort(segments_.begin(), segments_.end(), [](const Segment& a, const Segment& b) {
+        return a.start > b.start;
+    });
+}
+
+size_t HistoryArchive::get_segment_count() {
+    list_segments();
+    return segments_.size();
+}
+
+size_t HistoryArchive::get_loaded_count() const {
+    return std::count_if(segments_.begin(), segments_.end(), [](const Segment& segment) {
+        return segment.loaded;
+    });
+}
+
+bool HistoryArchive::load_index(Segment& segment) {
+    if (segment.loaded) {
+        return true;
+    }
+
+    FILE* file = fopen(path_of(segment.name).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    bool valid = false;
+    int version = 0;
+    unsigned long long count = 0;
+    char line[128];
+    if (fgets(line, sizeof(line), file) && sscanf(line, "VMCASTLE_SEGMENT %d %llu", &version, &count) == 2 &&
+        version == 1 && count <= MAX_SEGMENT_ENTRIES) {
+        segment.index.clear();
+        segment.index.reserve(count);
+        for (unsigned long long i = 0; i < count; ++i) {
+            long long timestamp = 0;
+            unsigned long long hash = 0, offset = 0, length = 0;
+            if (!fgets(line, sizeof(line), file) ||
+                sscanf(line, "%lld %llx %llu %llu", &timestamp, &hash, &offset, &length) != 4) {
+                break;
+            }
+            segment.index.push_back({static_cast<std::time_t>(timestamp), hash, offset, length});
+        }
+        valid = segment.index.size() == count && fgets(line, sizeof(line), file) &&
+                strcmp(line, "---INDEX_END---\n") == 0;
+        segment.data_offset = static_cast<uint64_t>(ftell(file));
+    }
+    fclose(file);
+
+    if (!valid) {
+        std::cerr << "Skipping corrupt archive segment " << path_of(segment.name) << std::endl;
+        segment.index.clear();
+        return false;
+    }
+    segment.loaded = true;
+    return true;
+}
+
+bool HistoryArchive::read_journal(std::vector<ArchivedText>& entries, size_t max_bytes, size_t* bytes_read,
+                                  bool* truncated) const {
+    entries.clear();
+    if (bytes_read) {
+        *bytes_read = 0;
+    }
+    if (truncated) {
+        *truncated = false;
+    }
+    FILE* file = fopen(path_of(JOURNAL_NAME).c_str(), "rb");
+    if (!file) {
+        return errno == ENOENT;
+    }
+
+    // Entries are appended, so the newest max_bytes are at the end; only
+    // those are kept, and only they are decompressed
+    HistoryFileReader reader(file);
+    std::deque<HistoryRecord> records;
+    size_t bytes = 0;
+    HistoryRecord record;
+    while (reader.next(record)) {
+        bytes += record.data.size();
+        records.push_back(std::move(record));
+        record = HistoryRecord();
+        while (max_bytes != 0 && bytes > max_bytes && !records.empty()) {
+            bytes -= records.front().data.size();
+            records.pop_front();
+            if (truncated) {
+                *truncated = true;
+            }
+        }
+    }
+    fclose(file);
+
+    ArchivedText entry;
+    for (const HistoryRecord& kept : records) {
+        if (!kept.get_text(entry.text)) {
+            continue;
+        }
+        entry.timestamp = kept.timestamp;
+        entry.hash = hash_text(entry.text);
+        entries.push_back(std::move(entry));
+    }
+    if (bytes_read) {
+        *bytes_read = bytes;
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), newer);
+    return true;
+}
+
+bool HistoryArchive::read_segment(Segment& segment, std::vector<ArchivedText>& entries) {
+    entries.clear();
+    if (!load_index(segment)) {
+        return false;
+    }
+    FILE* file = fopen(path_of(segment.name).c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    HistoryFileReader reader(file);
+    HistoryRecord record;
+    for (const IndexEntry& item : segment.index) {
+        ArchivedText entry;
+        if (fseek(file, static_cast<long>(segment.data_offset + item.offset), SEEK_SET) != 0 ||
+            !reader.next(record) || !record.get_text(entry.text)) {
+            continue;
+        }
+        entry.timestamp = item.timestamp;
+        entry.hash = item.hash;
+        entries.push_back(std::move(entry));
+    }
+    fclose(file);
+    return true;
+}
+
+bool HistoryArchive::write_segment(std::time_t start, const std::vector<ArchivedText>& entries) {
+    char date[16];
+    std::tm tm = {};
+    localtime_r(&start, &tm);
+    strftime(date, sizeof(date), "%Y-%m-%d", &tm);
+    std::string name = std::string(date) + (period_ == Period::WEEK ? ".week" : ".day") + SEGMENT_SUFFIX;
+
+    // Lay out the entries first; the index in front needs their offsets
+    char* data = nullptr;
+    size_t data_size = 0;
+    FILE* body = open_memstream(&data, &data_size);
+    if (!body) {
+        return false;
+    }
+    std::vector<IndexEntry> index;
+    index.reserve(entries.size());
+    for (const ArchivedText& entry : entries) {
+        uint64_t offset = static_cast<uint64_t>(ftell(body));
+        write_history_text(body, entry.timestamp, 0, entry.text, COMPRESS_MIN_SIZE);
+        index.push_back({entry.timestamp, entry.hash, offset, static_cast<uint64_t>(ftell(body)) - offset});
+    }
+    fclose(body);
+
+    // Write a new file and move it over the old one, so readers never see
+    // a segment half written
+    std::string path = path_of(name);
+    std::string temp_path = path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    bool written = file != nullptr;
+    if (file) {
+        fprintf(file, "VMCASTLE_SEGMENT 1 %zu\n", index.size());
+        for (const IndexEntry& item : index) {
+            fprintf(file, "%lld %016llx %llu %llu\n", static_cast<long long>(item.timestamp),
+                    static_cast<unsigned long long>(item.hash), static_cast<unsigned long long>(item.offset),
+                    static_cast<unsigned long long>(item.length));
+        }
+        fprintf(file, "---INDEX_END---\n");
+        fwrite(data, 1, data_size, file);
+        written = fflush(file) == 0 && !ferror(file);
+        written = fclose(file) == 0 && written;
+    }
+    free(data);
+    if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "Could not write archive segment " << path << ": " << strerror(errno) << std::endl;
+        unlink(temp_path.c_str());
+        return false;
+    }
+
+    // The replaced segment's index is stale now
+    auto it = std::find_if(segments_.begin(), segments_.end(), [&](const Segment& segment) {
+        return segment.name == name;
+    });
+    if (it == segments_.end()) {
+        Segment segment;
+        segment.name = name;
+        segment.period = period_;
+        segment.start = start;
+        segment.end = period_end(start, period_);
+        it = segments_.insert(std::find_if(segments_.begin(), segments_.end(), [&](const Segment& other) {
+            return other.start < start;
+        }), std::move(segment));
+    }
+    it->loaded = false;
+    it->index.clear();
+    return true;
+}
+
+void HistoryArchive::append(std::time_t timestamp, const std::string& text) {
+    std::time_t now = std::time(nullptr);
+    if (period_start(now, period_) != rolled_period_) {
+        roll(now);
+    }
+
+    if (mkdir(directory_.c_str(), 0700) != 0 && errno != EEXIST) {
+        std::cerr << "Could not create the archive " << directory_ << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    FILE* journal = fopen(path_of(JOURNAL_NAME).c_str(), "ab");
+    if (!journal) {
+        std::cerr << "Could not open the archive journal: " << strerror(errno) << std::endl;
+        return;
+    }
+    write_history_text(journal, timestamp, 0, text, COMPRESS_MIN_SIZE);
+    fclose(journal);
+}
+
+void HistoryArchive::roll(std::time_t now) {
+    rolled_period_ = period_start(now, period_);
+    list_segments();
+
+    // Drop whole segments past retention
+    if (retention_ > 0) {
+        segments_.erase(std::remove_if(segments_.begin(), segments_.end(), [&](const Segment& segment) {
+            if (segment.end + retention_ > now) {
+                return false;
+            }
+            unlink(path_of(segment.name).c_str());
+            return true;
+        }), segments_.end());
+    }
+
+    // Journal entries of finished periods, by period
+    std::vector<ArchivedText> journal;
+    if (!read_journal(journal) || journal.empty()) {
+        return;
+    }
+    std::map<std::time_t, std::vector<ArchivedText>> sealed;
+    std::vector<ArchivedText> open;
+    for (ArchivedText& entry : journal) {
+        std::time_t start = period_start(entry.timestamp, period_);
+        if (start >= rolled_period_) {
+            open.push_back(std::move(entry));
+        } else if (retention_ == 0 || period_end(start, period_) + retention_ > now) {
+            sealed[start].push_back(std::move(entry));
+        }
+    }
+    if (sealed.empty() && open.size() == journal.size()) {
+        return;
+    }
+
+    for (auto& period : sealed) {
+        std::vector<ArchivedText>& entries = period.second;
+
+        // Merge late entries with the period's sealed segment
+        for (Segment& segment : segments_) {
+            if (segment.start == period.first && segment.period == period_) {
+                std::vector<ArchivedText> existing;
+                if (read_segment(segment, existing)) {
+                    std::move(existing.begin(), existing.end(), std::back_inserter(entries));
+                }
+                break;
+            }
+        }
+
+        // Newest first, one copy of each text
+        std::stable_sort(entries.begin(), entries.end(), newer);
+        std::vector<ArchivedText> unique;
+        std::unordered_multimap<uint64_t, size_t> kept;  // Hash to index in unique
+        for (ArchivedText& entry : entries) {
+            auto same_hash = kept.equal_range(entry.hash);
+            bool repeat = std::any_of(same_hash.first, same_hash.second, [&](const std::pair<const uint64_t, size_t>& item) {
+                return unique[item.second].text == entry.text;
+            });
+            if (!repeat) {
+                kept.emplace(entry.hash, unique.size());
+                unique.push_back(std::move(entry));
+            }
+        }
+        if (!write_segment(period.first, unique)) {
+            // Keep the journal as it is; the next roll tries again
+            return;
+        }
+    }
+
+    // Keep only the entries of the current period in the journal
+    std::string journal_path = path_of(JOURNAL_NAME);
+    if (open.empty()) {
+        unlink(journal_path.c_str());
+        return;
+    }
+    std::string temp_path = journal_path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        return;
+    }
+    for (const ArchivedText& entry : open) {
+        write_history_text(file, entry.timestamp, 0, entry.text, COMPRESS_MIN_SIZE);
+    }
+    bool written = fflush(file) == 0 && !ferror(file);
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temp_path.c_str(), journal_path.c_str()) != 0) {
+        unlink(temp_path.c_str());
+    }
+}
+
+bool HistoryArchive::scan(std::time_t since, std::time_t until,
+                          const std::function<bool(uint64_t hash)>& wanted,
+                          const std::function<bool(const ArchivedText& entry)>& visit,
+                          size_t max_bytes) {
+    auto in_range = [&](std::time_t timestamp) {
+        return (since == 0 || timestamp >= since) && (until == 0 || timestamp <= until);
+    };
+
+    list_segments();
+
+    // The journal holds the current period, plus late entries of older ones
+    // that are visited along with their period. It is read first and counts
+    // against max_bytes like the segments.
+    std::vector<ArchivedText> journal;
+    size_t bytes_read = 0;
+    bool journal_truncated = false;
+    read_journal(journal, max_bytes, &bytes_read, &journal_truncated);
+    size_t next_journal = 0;
+    auto visit_journal = [&](std::time_t from) {
+        for (; next_journal < journal.size() && journal[next_journal].timestamp >= from; ++next_journal) {
+            const ArchivedText& entry = journal[next_journal];
+            if (in_range(entry.timestamp) && wanted(entry.hash) && !visit(entry)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (Segment& segment : segments_) {
+        if (!visit_journal(segment.start)) {
+            return true;
+        }
+
+        // Periods are sorted newest first: skip the newer ones out of
+        // range, stop at the first one that ended before it
+        if (until != 0 && segment.start > until) {
+            continue;
+        }
+        if (since != 0 && segment.end <= since) {
+            break;
+        }
+        if (!load_index(segment)) {
+            continue;
+        }
+
+        FILE* file = nullptr;
+        std::unique_ptr<HistoryFileReader> reader;
+        HistoryRecord record;
+        ArchivedText entry;
+        bool stopped = false;
+        for (const IndexEntry& item : segment.index) {
+            if (!in_range(item.timestamp) || !wanted(item.hash)) {
+                continue;
+            }
+            if (max_bytes != 0 && bytes_read + item.length > max_bytes) {
+                if (file) {
+                    fclose(file);
+                }
+                return false;
+            }
+
+            // Open the file only once an entry is actually wanted
+            if (!file) {
+                file = fopen(path_of(segment.name).c_str(), "rb");
+                if (!file) {
+                    break;
+                }
+                reader.reset(new HistoryFileReader(file));
+            }
+            bytes_read += item.length;
+            if (fseek(file, static_cast<long>(segment.data_offset + item.offset), SEEK_SET) != 0 ||
+                !reader->next(record) || !record.get_text(entry.text)) {
+                continue;
+            }
+            entry.timestamp = item.timestamp;
+            entry.hash = item.hash;
+            if (!visit(entry)) {
+                stopped = true;
+                break;
+            }
+        }
+        reader.reset();
+        if (file) {
+            fclose(file);
+        }
+        if (stopped) {
+            return true;
+        }
+    }
+
+    if (!visit_journal(0)) {
+        return true;
+    }
+    return !journal_truncated;
+}
@@ -0,0 +1,125 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef HISTORY_ARCHIVE_HPP
+#define HISTORY_ARCHIVE_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Entries that fell out of the history, kept on disk by creation time so
+// older copies stay searchable without growing the in-memory history.
+//
+// New entries are appended to a journal (in the history file format). Once
+// their day or week is over, the journal is sealed into one immutable
+// segment per period, named after it (2025-06-02.day.seg), so a query skips
+// segments outside its time range without opening them. A segment starts
+// with an index of its entries, newest first:
+//
+//   VMCASTLE_SEGMENT 1 <count>
+//   <timestamp> <hash> <offset> <length>     (count lines; hash in hex)
+//   ---INDEX_END---
+//   entries in the history file format, at offset bytes past the index
+//
+// A query reads only the indexes of the segments in its range, and then
+// only the entries it still wants; the hashes let it skip repeats unread.
+// Late entries of a sealed period are merged into a new copy of its segment.
+
+struct ArchivedText {
+    std::time_t timestamp = 0;
+    uint64_t hash = 0;
+    std::string text;
+};
+
+class HistoryArchive {
+public:
+    enum class Period {
+        DAY,
+        WEEK
+    };
+
+    // Archive kept in directory (created on the first append); segments
+    // that ended more than retention seconds ago are deleted (0 keeps them)
+    HistoryArchive(std::string directory, Period period, std::time_t retention);
+
+    // Period from VMCASTLE_ARCHIVE_PERIOD=day|week (day by default)
+    static Period period_from_environment();
+
+    // Add an entry leaving the history; seals the journal first when a new
+    // period started since the last roll
+    void append(std::time_t timestamp, const std::string& text);
+
+    // Seal journal entries of past periods into segments and delete the
+    // segments past retention
+    void roll(std::time_t now);
+
+    // Visit the entries created in [since, until] (0 = unbounded), newest
+    // period first and newest first within it. wanted(hash) is asked before
+    // an entry is read; visit returns false to stop. Stops early once
+    // max_bytes of entries, journal included, were read (0 = no limit);
+    // returns false then.
+    bool scan(std::time_t since, std::time_t until,
+              const std::function<bool(uint64_t hash)>& wanted,
+              const std::function<bool(const ArchivedText& entry)>& visit,
+              size_t max_bytes = 0);
+
+    // Number of sealed segments, and of those whose index was read
+    size_t get_segment_count();
+    size_t get_loaded_count() const;
+
+    const std::string& get_directory() const;
+
+private:
+    struct IndexEntry {
+        std::time_t timestamp;
+        uint64_t hash;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    struct Segment {
+        std::string name;
+        Period period;
+        std::time_t start;          // First second of the period
+        std::time_t end;            // First second of the next period
+        bool loaded = false;        // Whether index holds the file's index
+        std::vector<IndexEntry> index;
+        uint64_t data_offset = 0;   // Where the entries start in the file
+    };
+
+    // Start of the period holding time, and of the one after it
+    static std::time_t period_start(std::time_t time, Period period);
+    static std::time_t period_end(std::time_t start, Period period);
+
+    // List the segment files once
+    void list_segments();
+
+    // Read a segment's index; false if the file is missing or corrupt
+    bool load_index(Segment& segment);
+
+    // Read the journal, or the entries of a segment, newest first. Only the
+    // newest max_bytes of the journal are kept (0 = all); bytes_read gets
+    // what they took and truncated whether older ones were left out.
+    bool read_journal(std::vector<ArchivedText>& entries, size_t max_bytes = 0, size_t* bytes_read = nullptr,
+                      bool* truncated = nullptr) const;
+    bool read_segment(Segment& segment, std::vector<ArchivedText>& entries);
+
+    // Write entries (newest first) as the segment of a period, replacing it
+    bool write_segment(std::time_t start, const std::vector<ArchivedText>& entries);
+
+    std::string path_of(const std::string& name) const;
+
+    std::string directory_;
+    Period period_;
+    std::time_t retention_;
+    bool listed_ = false;
+    std::vector<Segment> segments_;     // Newest period first
+    std::time_t rolled_period_ = 0;     // Period of the last roll
+};
+
+#endif // HISTORY_ARCHIVE_HPP
@@ -0,0 +1,287 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "history_file.hpp"
+#include "compression.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sys/types.h>
+
+// Whether a line of length bytes starts with prefix
+static bool starts_with(const char* line, size_t length, const char* prefix) {
+    size_t prefix_length = strlen(prefix);
+    return length >= prefix_length && memcmp(line, prefix, prefix_length) == 0;
+}
+
+static bool equals(const char* line, size_t length, const char* marker) {
+    return length == strlen(marker) && memcmp(line, marker, length) == 0;
+}
+
+std::string default_history_path() {
+    // An explicit location wins (replays, one history per display)
+    const char* override_path = getenv("VMCASTLE_HISTORY_FILE");
+    if (override_path && *override_path) {
+        return override_path;
+    }
+
+    // File path in user's home directory
+    const char* home_dir = getenv("HOME");
+    if (!home_dir) {
+        std::cerr << "Could not get HOME directory for history file" << std::endl;
+        return "";
+    }
+
+    return std::string(home_dir) + "/.clipboard_history";
+}
+
+bool HistoryRecord::get_text(std::string& out) const {
+    if (chunked) {
+        out.assign(raw_size, '\0');
+        return chunk_reassemble(chunks, out.empty() ? nullptr : &out[0], raw_size);
+    }
+    if (!compressed) {
+        out = data;
+        return true;
+    }
+    return lz4_decompress(data.data(), data.size(), raw_size, out);
+}
+
+HistoryFileReader::HistoryFileReader(FILE* file) : file_(file) {}
+
+HistoryFileReader::~HistoryFileReader() {
+    free(line_buffer_);
+}
+
+bool HistoryFileReader::next(HistoryRecord& record) {
+    // Sizes are checked against HISTORY_MAX_RECORD_SIZE, but a file can still
+    // ask for more memory than there is; treat that as the end of the file
+    try {
+        return read_record(record);
+    } catch (const std::bad_alloc&) {
+        record = HistoryRecord();
+        return false;
+    }
+}
+
+bool HistoryFileReader::read_record(HistoryRecord& record) {
+    record = HistoryRecord();
+    bool in_entry = false;
+    bool first_line = true;
+    ssize_t line_length;
+
+    // Read entries line by line (getline keeps long lines intact). Lines are
+    // used in place in the reader's buffer and appended straight to the entry.
+    while ((line_length = getline(&line_buffer_, &line_capacity_, file_)) != -1) {
+        const char* line = line_buffer_;
+        size_t length = static_cast<size_t>(line_length);
+
+        // Remove trailing newline
+        if (length > 0 && line_buffer_[length - 1] == '\n') {
+            line_buffer_[--length] = '\0';
+        }
+
+        // Inside a plain entry only its end marker counts; the writer frames
+        // text holding marker-shaped lines by length instead
+        if (in_entry) {
+            if (equals(line, length, "---ENTRY_END---")) {
+                if (!record.data.empty()) {
+                    record.raw_size = record.data.size();
+                    return true;
+                }
+                in_entry = false;
+                continue;
+            }
+
+            // Add line to current entry
+            if (!first_line) {
+                record.data += '\n';
+            }
+            record.data.append(line, length);
+            first_line = false;
+            continue;
+        }
+
+        // Check for entry markers
+        if (starts_with(line, length, "---ENTRY_META ")) {
+            long long timestamp = 0;
+            long long expiry = 0;
+            int pinned = 0;
+            int fields = sscanf(line, "---ENTRY_META %lld %lld %d", &timestamp, &expiry, &pinned);
+            record.has_times = fields >= 2;
+            record.pinned = fields == 3 && pinned != 0;
+            record.timestamp = static_cast<std::time_t>(timestamp);
+            record.expiry = static_cast<std::time_t>(expiry);
+        } else if (equals(line, length, "---ENTRY_START---")) {
+            in_entry = true;
+            first_line = true;
+            record.compressed = false;
+            record.data.clear();
+        } else if (starts_with(line, length, "---ENTRY_LZ4 ")) {
+            // Compressed entry: header with sizes followed by the raw LZ4 block
+            unsigned long long raw_size = 0;
+            unsigned long long compressed_size = 0;
+            if (sscanf(line, "---ENTRY_LZ4 %llu %llu---", &raw_size, &compressed_size) != 2) {
+                continue;
+            }
+
+            // The block follows unframed, so a bad size leaves nothing to resync on
+            if (raw_size > HISTORY_MAX_RECORD_SIZE || compressed_size > HISTORY_MAX_RECORD_SIZE) {
+                return false;
+            }
+
+            record.data.assign(compressed_size, '\0');
+            if (fread(&record.data[0], 1, compressed_size, file_) != compressed_size) {
+                return false;
+            }
+            record.compressed = true;
+            record.raw_size = raw_size;
+            return true;
+        } else if (starts_with(line, length, "---CHUNK ")) {
+            if (!read_chunk(line)) {
+                return false;
+            }
+        } else if (starts_with(line, length, "---ENTRY_CHUNKS ")) {
+            unsigned long long raw_size = 0;
+            unsigned long long count = 0;
+            if (sscanf(line, "---ENTRY_CHUNKS %llu %llu---", &raw_size, &count) != 2) {
+                continue;
+            }
+
+            // Every chunk holds at least one byte
+            if (raw_size > HISTORY_MAX_RECORD_SIZE || count > raw_size) {
+                return false;
+            }
+            if (!read_chunk_ids(count, record.chunks)) {
+                // Unknown chunk ids: skip the entry
+                record.chunks.clear();
+                continue;
+            }
+            record.chunked = true;
+            record.raw_size = raw_size;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool HistoryFileReader::read_chunk(const char* header) {
+    unsigned long long id = 0;
+    unsigned long long raw_size = 0;
+    unsigned long long stored_size = 0;
+    int compressed = 0;
+    if (sscanf(header, "---CHUNK %llu %llu %llu %d---", &id, &raw_size, &stored_size, &compressed) != 4) {
+        return true;
+    }
+    if (raw_size > HISTORY_MAX_RECORD_SIZE || stored_size > HISTORY_MAX_RECORD_SIZE) {
+        return false;
+    }
+
+    std::string stored(stored_size, '\0');
+    if (stored_size > 0 && fread(&stored[0], 1, stored_size, file_) != stored_size) {
+        return false;
+    }
+
+    // Intern the raw bytes so loaded chunks are shared with new entries
+    std::string raw;
+    if (compressed) {
+        if (!lz4_decompress(stored.data(), stored.size(), raw_size, raw)) {
+            return true;
+        }
+    } else {
+        raw.swap(stored);
+    }
+    chunks_[id] = ChunkPool::shared().intern(raw.data(), raw.size());
+    return true;
+}
+
+bool HistoryFileReader::read_chunk_ids(size_t count, ChunkList& chunks) {
+    if (getline(&line_buffer_, &line_capacity_, file_) == -1) {
+        return false;
+    }
+
+    chunks.clear();
+    chunks.reserve(count);
+    const char* cursor = line_buffer_;
+    for (size_t i = 0; i < count; ++i) {
+        char* end = nullptr;
+        unsigned long long id = strtoull(cursor, &end, 10);
+        if (end == cursor) {
+            return false;
+        }
+        cursor = end;
+
+        auto it = chunks_.find(id);
+        if (it == chunks_.end()) {
+            return false;
+        }
+        chunks.push_back(it->second);
+    }
+    return true;
+}
+
+static void write_meta(FILE* file, std::time_t timestamp, std::time_t expiry, bool pinned) {
+    fprintf(file, pinned ? "---ENTRY_META %lld %lld 1---\n" : "---ENTRY_META %lld %lld---\n",
+            static_cast<long long>(timestamp), static_cast<long long>(expiry));
+}
+
+// Whether text has a line the reader could take for a marker. Plain
+// entries are framed by lines, so such text is written as a sized block.
+static bool has_marker_line(const std::string& text) {
+    if (text.compare(0, 3, "---") == 0) {
+        return true;
+    }
+    return text.find("\n---") != std::string::npos;
+}
+
+void write_history_text(FILE* file, std::time_t timestamp, std::time_t expiry,
+                        const std::string& text, size_t compress_min, bool pinned) {
+    bool framed = has_marker_line(text);
+    if (framed || text.size() >= compress_min) {
+        std::string block = lz4_compress(text.data(), text.size());
+        if (framed || block.size() < text.size()) {
+            write_history_block(file, timestamp, expiry, block, text.size(), pinned);
+            return;
+        }
+    }
+
+    write_meta(file, timestamp, expiry, pinned);
+    fprintf(file, "---ENTRY_START---\n");
+    fwrite(text.data(), 1, text.size(), file);
+    fprintf(file, "\n---ENTRY_END---\n");
+}
+
+void write_history_block(FILE* file, std::time_t timestamp, std::time_t expiry,
+                         const std::string& block, size_t raw_size, bool pinned) {
+    write_meta(file, timestamp, expiry, pinned);
+    fprintf(file, "---ENTRY_LZ4 %zu %zu---\n", raw_size, block.size());
+    fwrite(block.data(), 1, block.size(), file);
+    fprintf(file, "\n---ENTRY_END---\n");
+}
+
+void write_history_chunks(FILE* file, std::time_t timestamp, std::time_t expiry,
+                          const ChunkList& chunks, size_t raw_size, WrittenChunks& written,
+                          bool pinned) {
+    // Define chunks on first use so a reader resolves ids in one pass
+    for (const ChunkRef& chunk : chunks) {
+        if (written.count(chunk)) {
+            continue;
+        }
+        size_t id = written.size();
+        written[chunk] = id;
+        fprintf(file, "---CHUNK %zu %zu %zu %d---\n", id, chunk->raw_size, chunk->data.size(),
+                chunk->compressed ? 1 : 0);
+        fwrite(chunk->data.data(), 1, chunk->data.size(), file);
+        fprintf(file, "\n");
+    }
+
+    write_meta(file, timestamp, expiry, pinned);
+    fprintf(file, "---ENTRY_CHUNKS %zu %zu---\n", raw_size, chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        fprintf(file, i ? " %zu" : "%zu", written[chunks[i]]);
+    }
+    fprintf(file, "\n---ENTRY_END---\n");
+}
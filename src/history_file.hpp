@@ -0,0 +1,101 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef HISTORY_FILE_HPP
+#define HISTORY_FILE_HPP
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+
+#include "chunk_store.hpp"
+
+// One entry of the history file (~/.clipboard_history).
+// Plain entries are framed by ---ENTRY_START--- and ---ENTRY_END--- lines;
+// compressed ones by an ---ENTRY_LZ4 <raw> <compressed>--- header followed by
+// the LZ4 block. Chunked ones by an ---ENTRY_CHUNKS <raw> <count>--- header
+// followed by a line of chunk ids; each chunk is written once, before its
+// first use, as a ---CHUNK <id> <raw> <stored> <lz4>--- header and its bytes.
+// An optional ---ENTRY_META <timestamp> <expiry> [<pinned>]--- line in front
+// of an entry carries its times and whether it is pinned. Text holding a line
+// that starts with "---" is always written as an LZ4 block, so no content can
+// be taken for a marker.
+
+// Larger sizes in a record header are taken as corruption
+const size_t HISTORY_MAX_RECORD_SIZE = size_t(1) << 30;
+
+// Entries kept in the history file, and the size from which an entry is
+// written as an LZ4 block (shared by the manager and --import)
+const size_t HISTORY_MAX_ENTRIES = 50;
+const size_t HISTORY_COMPRESS_MIN_SIZE = 256;
+
+// Location of the history file: $VMCASTLE_HISTORY_FILE, or
+// ~/.clipboard_history (empty if HOME is not set)
+std::string default_history_path();
+
+struct HistoryRecord {
+    bool has_times = false;      // Whether a META line preceded the entry
+    std::time_t timestamp = 0;
+    std::time_t expiry = 0;      // 0 = never
+    bool pinned = false;
+    bool compressed = false;     // data holds an LZ4 block of raw_size bytes
+    bool chunked = false;        // chunks hold the raw_size bytes instead of data
+    size_t raw_size = 0;
+    std::string data;
+    ChunkList chunks;
+
+    // The entry text, decompressing if needed; false if the block is corrupt
+    bool get_text(std::string& out) const;
+};
+
+// Reads the history file one entry at a time, so memory use is bounded by
+// the largest entry rather than the size of the file
+class HistoryFileReader {
+public:
+    explicit HistoryFileReader(FILE* file);
+    ~HistoryFileReader();
+
+    HistoryFileReader(const HistoryFileReader&) = delete;
+    HistoryFileReader& operator=(const HistoryFileReader&) = delete;
+
+    // Read the next entry; false at the end of the file, or where the file
+    // is corrupt beyond recovery
+    bool next(HistoryRecord& record);
+
+private:
+    bool read_record(HistoryRecord& record);
+
+    // Read the bytes of a ---CHUNK--- record into the chunk table
+    bool read_chunk(const char* header);
+
+    // Resolve the id line of an ---ENTRY_CHUNKS--- record
+    bool read_chunk_ids(size_t count, ChunkList& chunks);
+
+    FILE* file_;
+    std::unordered_map<size_t, ChunkRef> chunks_;    // Chunks defined so far, by id
+    char* line_buffer_ = nullptr;
+    size_t line_capacity_ = 0;
+};
+
+// Append an entry holding text; text of at least compress_min bytes is
+// stored as an LZ4 block when that makes it smaller
+void write_history_text(FILE* file, std::time_t timestamp, std::time_t expiry,
+                        const std::string& text, size_t compress_min, bool pinned = false);
+
+// Append an entry that is already an LZ4 block of raw_size bytes
+void write_history_block(FILE* file, std::time_t timestamp, std::time_t expiry,
+                         const std::string& block, size_t raw_size, bool pinned = false);
+
+// Ids of the chunks already written to one file (holding them keeps their
+// addresses from being reused while the file is written)
+using WrittenChunks = std::unordered_map<ChunkRef, size_t>;
+
+// Append an entry made of pooled chunks, writing the chunks not yet in the file
+void write_history_chunks(FILE* file, std::time_t timestamp, std::time_t expiry,
+                          const ChunkList& chunks, size_t raw_size, WrittenChunks& written,
+                          bool pinned = false);
+
+#endif // HISTORY_FILE_HPP
@@ -0,0 +1,64 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "history_search.hpp"
+#include "regex_search.hpp"
+#include "case_fold.hpp"
+
+bool search_entries(const std::vector<std::shared_ptr<ClipboardEntry>>& entries,
+                    const std::string& query, SearchMode mode,
+                    std::vector<size_t>& matches, std::string* error,
+                    const SearchCorpus* corpus) {
+    matches.clear();
+
+    if (mode == SearchMode::REGEX) {
+        // Compiled patterns are cached per query string, so typing is cheap
+        auto regex = RegexQuery::compile(query, error);
+        if (!regex) {
+            return false;
+        }
+
+        // With a corpus, literals the pattern needs are looked up in the packed
+        // search texts, and only entries holding them are loaded. Cold texts
+        // go through the entries' small decompression cache, not the corpus.
+        if (corpus && corpus->size() == entries.size()) {
+            for (size_t i = 0; i < entries.size(); ++i) {
+                size_t size = 0;
+                const char* folded = corpus->search_text(i, size);
+                if (entries[i]->is_binary() || !regex->may_match(folded, size)) {
+                    continue;
+                }
+                if (regex->matches(*entries[i]->get_text())) {
+                    matches.push_back(i);
+                }
+            }
+            return true;
+        }
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i]->is_binary()) {
+                continue;
+            }
+            ClipboardText folded = entries[i]->get_search_text();
+            if (regex->matches(*entries[i]->get_text(), folded.get())) {
+                matches.push_back(i);
+            }
+        }
+        return true;
+    }
+
+    // Plain search is case and accent insensitive: compare folded texts
+    std::string folded_query = fold_text(query);
+    if (corpus && corpus->size() == entries.size()) {
+        corpus->find(folded_query, matches);
+        return true;
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i]->get_search_text()->find(folded_query) != std::string::npos) {
+            matches.push_back(i);
+        }
+    }
+    return true;
+}
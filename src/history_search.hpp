@@ -0,0 +1,30 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef HISTORY_SEARCH_HPP
+#define HISTORY_SEARCH_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clipboard_entry.hpp"
+#include "substring_search.hpp"
+
+// How the search text is interpreted
+enum class SearchMode {
+    EXACT,   // Plain substring, case and accent insensitive
+    REGEX    // RE2 regular expression
+};
+
+// Collect the indices of entries matching query, in history order.
+// Returns false and fills error if the query is not a valid pattern.
+// Searches run over corpus when given; it must be packed from entries.
+bool search_entries(const std::vector<std::shared_ptr<ClipboardEntry>>& entries,
+                    const std::string& query, SearchMode mode,
+                    std::vector<size_t>& matches, std::string* error = nullptr,
+                    const SearchCorpus* corpus = nullptr);
+
+#endif // HISTORY_SEARCH_HPP
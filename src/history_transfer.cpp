@@ -0,0 +1,820 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "history_transfer.hpp"
+#include "history_file.hpp"
+#include "history_archive.hpp"
+#include "expiry_policy.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Stream buffer of each open file; memory does not grow with the history
+static const size_t TRANSFER_BUFFER_SIZE = 64 * 1024;
+
+// Magic at the start of a binary export; version in the last byte
+// The last byte is the frame version: 2 added the flags word
+static const char BINARY_MAGIC[8] = {'V', 'M', 'C', 'H', 'I', 'S', 'T', 2};
+
+// Bits of the flags word of a version 2 frame
+static const uint64_t FRAME_PINNED = 1;
+
+// Frames larger than this are treated as corruption
+static const uint64_t MAX_FRAME_SIZE = uint64_t(1) << 32;
+
+// One entry on its way in or out
+struct TransferRecord {
+    std::time_t timestamp = 0;
+    std::time_t expiry = 0;
+    bool pinned = false;
+    std::string text;
+};
+
+static bool passes_filters(const TransferOptions& options, const TransferRecord& record) {
+    if (options.since != 0 && record.timestamp < options.since) {
+        return false;
+    }
+    if (options.until != 0 && record.timestamp > options.until) {
+        return false;
+    }
+    if (record.text.size() < options.min_size) {
+        return false;
+    }
+    if (options.max_size != 0 && record.text.size() > options.max_size) {
+        return false;
+    }
+    return true;
+}
+
+// Buffers of the standard streams, which outlive any TransferStream
+static char stdin_buffer[TRANSFER_BUFFER_SIZE];
+static char stdout_buffer[TRANSFER_BUFFER_SIZE];
+
+// Open path with a fixed stream buffer; "-" or empty maps to stdin/stdout
+class TransferStream {
+public:
+    TransferStream(const std::string& path, bool write) {
+        char* buffer;
+        if (path.empty() || path == "-") {
+            file_ = write ? stdout : stdin;
+            buffer = write ? stdout_buffer : stdin_buffer;
+        } else {
+            file_ = fopen(path.c_str(), write ? "wb" : "rb");
+            owned_ = true;
+            buffer_.resize(TRANSFER_BUFFER_SIZE);
+            buffer = buffer_.data();
+        }
+        if (file_) {
+            setvbuf(file_, buffer, _IOFBF, TRANSFER_BUFFER_SIZE);
+        }
+    }
+
+    ~TransferStream() {
+        close();
+    }
+
+    TransferStream(const TransferStream&) = delete;
+    TransferStream& operator=(const TransferStream&) = delete;
+
+    // Flush and close; false if anything failed to be written
+    bool close() {
+        if (!file_) {
+            return true;
+        }
+        bool ok = fflush(file_) == 0 && !ferror(file_);
+        if (owned_) {
+            ok = fclose(file_) == 0 && ok;
+        }
+        file_ = nullptr;
+        return ok;
+    }
+
+    FILE* get() const {
+        return file_;
+    }
+
+private:
+    std::vector<char> buffer_;
+    FILE* file_ = nullptr;
+    bool owned_ = false;
+};
+
+// --- JSON Lines -----------------------------------------------------------
+
+static void write_json_string(FILE* file, const std::string& text) {
+    fputc('"', file);
+
+    // Copy runs that need no escaping in one call
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        fwrite(text.data() + run_start, 1, i - run_start, file);
+        run_start = i + 1;
+        switch (c) {
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\r': fputs("\\r", file); break;
+            case '\t': fputs("\\t", file); break;
+            default: fprintf(file, "\\u%04x", c); break;
+        }
+    }
+    fwrite(text.data() + run_start, 1, text.size() - run_start, file);
+
+    fputc('"', file);
+}
+
+static void write_jsonl_record(FILE* file, const TransferRecord& record) {
+    fprintf(file, "{\"timestamp\":%lld,\"expiry\":%lld,%s\"text\":",
+            static_cast<long long>(record.timestamp), static_cast<long long>(record.expiry),
+            record.pinned ? "\"pinned\":true," : "");
+    write_json_string(file, record.text);
+    fputs("}\n", file);
+}
+
+static void append_utf8(std::string& out, unsigned long code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+// Minimal parser for the flat objects written by write_jsonl_record
+class JsonLineParser {
+public:
+    JsonLineParser(const char* data, size_t size) : p_(data), end_(data + size) {}
+
+    bool parse(TransferRecord& record) {
+        bool has_text = false;
+        skip_space();
+        if (!consume('{')) {
+            return false;
+        }
+        skip_space();
+        if (consume('}')) {
+            return false;
+        }
+
+        while (true) {
+            std::string key;
+            skip_space();
+            if (!parse_string(key)) {
+                return false;
+            }
+            skip_space();
+            if (!consume(':')) {
+                return false;
+            }
+            skip_space();
+
+            if (key == "text") {
+                if (!parse_string(record.text)) {
+                    return false;
+                }
+                has_text = true;
+            } else if (key == "timestamp" || key == "expiry") {
+                long long value = 0;
+                if (!parse_integer(value)) {
+                    return false;
+                }
+                (key == "timestamp" ? record.timestamp : record.expiry) = static_cast<std::time_t>(value);
+            } else if (key == "pinned") {
+                if (!parse_boolean(record.pinned)) {
+                    return false;
+                }
+            } else if (!skip_value()) {
+                return false;
+            }
+
+            skip_space();
+            if (consume('}')) {
+                return has_text;
+            }
+            if (!consume(',')) {
+                return false;
+            }
+        }
+    }
+
+private:
+    void skip_space() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n')) {
+            ++p_;
+        }
+    }
+
+    bool consume(char c) {
+        if (p_ < end_ && *p_ == c) {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+
+    bool parse_hex4(unsigned long& out) {
+        if (end_ - p_ < 4) {
+            return false;
+        }
+        out = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *p_++;
+            out <<= 4;
+            if (c >= '0' && c <= '9') {
+                out |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                out |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                out |= c - 'A' + 10;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool parse_string(std::string& out) {
+        out.clear();
+        if (!consume('"')) {
+            return false;
+        }
+
+        while (p_ < end_) {
+            // Copy runs without escapes in one go
+            const char* run = p_;
+            while (p_ < end_ && *p_ != '"' && *p_ != '\\') {
+                ++p_;
+            }
+            out.append(run, p_ - run);
+            if (p_ >= end_) {
+                return false;
+            }
+            if (*p_++ == '"') {
+                return true;
+            }
+
+            if (p_ >= end_) {
+                return false;
+            }
+            char escape = *p_++;
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned long code = 0;
+                    if (!parse_hex4(code)) {
+                        return false;
+                    }
+                    // Join surrogate pairs
+                    if (code >= 0xD800 && code < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' && p_[1] == 'u') {
+                        p_ += 2;
+                        unsigned long low = 0;
+                        if (!parse_hex4(low) || low < 0xDC00 || low >= 0xE000) {
+                            return false;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    append_utf8(out, code);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool parse_integer(long long& out) {
+        std::string digits;
+        while (p_ < end_ && (*p_ == '-' || (*p_ >= '0' && *p_ <= '9'))) {
+            digits += *p_++;
+        }
+        if (digits.empty()) {
+            return false;
+        }
+        out = strtoll(digits.c_str(), nullptr, 10);
+        return true;
+    }
+
+    bool parse_boolean(bool& out) {
+        for (bool value : {true, false}) {
+            const char* literal = value ? "true" : "false";
+            size_t length = strlen(literal);
+            if (static_cast<size_t>(end_ - p_) >= length && memcmp(p_, literal, length) == 0) {
+                p_ += length;
+                out = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Skip a value of a key we do not know (strings, numbers and literals)
+    bool skip_value() {
+        if (p_ < end_ && *p_ == '"') {
+            std::string ignored;
+            return parse_string(ignored);
+        }
+        const char* start = p_;
+        while (p_ < end_ && *p_ != ',' && *p_ != '}') {
+            ++p_;
+        }
+        return p_ > start;
+    }
+
+    const char* p_;
+    const char* end_;
+};
+
+// --- Binary frames --------------------------------------------------------
+
+static void put_u64(FILE* file, uint64_t value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+static bool get_u64(FILE* file, uint64_t& value) {
+    unsigned char bytes[8];
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) {
+        return false;
+    }
+    value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return true;
+}
+
+// Frame: little-endian u64 timestamp, u64 expiry, u64 flags (from version
+// 2 on), u64 size, then the text
+static void write_frame(FILE* file, const TransferRecord& record) {
+    put_u64(file, static_cast<uint64_t>(record.timestamp));
+    put_u64(file, static_cast<uint64_t>(record.expiry));
+    put_u64(file, record.pinned ? FRAME_PINNED : 0);
+    put_u64(file, record.text.size());
+    fwrite(record.text.data(), 1, record.text.size(), file);
+}
+
+// --- Readers --------------------------------------------------------------
+
+// Reads records of an export in either format
+class TransferReader {
+public:
+    TransferReader(FILE* file, TransferFormat format) : file_(file), format_(format) {}
+
+    ~TransferReader() {
+        free(line_buffer_);
+    }
+
+    // Read the magic of a binary export; older frame versions are read too
+    bool start() {
+        if (format_ != TransferFormat::BINARY) {
+            return true;
+        }
+        char magic[sizeof(BINARY_MAGIC)];
+        if (fread(magic, 1, sizeof(magic), file_) != sizeof(magic) ||
+            memcmp(magic, BINARY_MAGIC, sizeof(magic) - 1) != 0) {
+            return false;
+        }
+        version_ = magic[sizeof(magic) - 1];
+        return version_ >= 1 && version_ <= BINARY_MAGIC[sizeof(BINARY_MAGIC) - 1];
+    }
+
+    // Next record; false at the end of the input or on a corrupt frame
+    bool next(TransferRecord& record) {
+        record = TransferRecord();
+        if (format_ == TransferFormat::BINARY) {
+            uint64_t timestamp = 0, expiry = 0, flags = 0, size = 0;
+            if (!get_u64(file_, timestamp)) {
+                return false;
+            }
+            if (!get_u64(file_, expiry) || (version_ >= 2 && !get_u64(file_, flags)) ||
+                !get_u64(file_, size) || size > MAX_FRAME_SIZE) {
+                error_ = "truncated or corrupt frame";
+                return false;
+            }
+            record.timestamp = static_cast<std::time_t>(timestamp);
+            record.expiry = static_cast<std::time_t>(expiry);
+            record.pinned = (flags & FRAME_PINNED) != 0;
+            record.text.resize(size);
+            if (size > 0 && fread(&record.text[0], 1, size, file_) != size) {
+                error_ = "truncated frame";
+                return false;
+            }
+            return true;
+        }
+
+        ssize_t length;
+        while ((length = getline(&line_buffer_, &line_capacity_, file_)) != -1) {
+            ++line_number_;
+            if (length <= 1) {
+                continue;
+            }
+            JsonLineParser parser(line_buffer_, static_cast<size_t>(length));
+            if (parser.parse(record)) {
+                return true;
+            }
+            std::cerr << "Skipping malformed line " << line_number_ << std::endl;
+            record = TransferRecord();
+        }
+        return false;
+    }
+
+    const std::string& error() const {
+        return error_;
+    }
+
+private:
+    FILE* file_;
+    TransferFormat format_;
+    char version_ = 0;
+    char* line_buffer_ = nullptr;
+    size_t line_capacity_ = 0;
+    size_t line_number_ = 0;
+    std::string error_;
+};
+
+// --- Export ---------------------------------------------------------------
+
+static int run_export(const TransferOptions& options) {
+    std::string history_path = default_history_path();
+    if (history_path.empty()) {
+        return 1;
+    }
+    FILE* history = fopen(history_path.c_str(), "rb");
+    if (!history) {
+        std::cerr << "Could not open " << history_path << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::vector<char> history_buffer(TRANSFER_BUFFER_SIZE);
+    setvbuf(history, history_buffer.data(), _IOFBF, history_buffer.size());
+
+    TransferStream output(options.path, true);
+    if (!output.get()) {
+        std::cerr << "Could not open " << options.path << ": " << strerror(errno) << std::endl;
+        fclose(history);
+        return 1;
+    }
+    if (options.format == TransferFormat::BINARY) {
+        fwrite(BINARY_MAGIC, 1, sizeof(BINARY_MAGIC), output.get());
+    }
+
+    std::time_t now = std::time(nullptr);
+    size_t exported = 0;
+    HistoryFileReader reader(history);
+    HistoryRecord entry;
+    TransferRecord record;
+    while (reader.next(entry)) {
+        if (!entry.get_text(record.text)) {
+            std::cerr << "Skipping a corrupt compressed entry" << std::endl;
+            continue;
+        }
+        record.timestamp = entry.has_times ? entry.timestamp : now;
+        record.expiry = entry.has_times ? entry.expiry : 0;
+        record.pinned = entry.pinned;
+        if (!passes_filters(options, record)) {
+            continue;
+        }
+
+        if (options.format == TransferFormat::BINARY) {
+            write_frame(output.get(), record);
+        } else {
+            write_jsonl_record(output.get(), record);
+        }
+        ++exported;
+    }
+    fclose(history);
+
+    // Archived entries follow, newest first
+    if (options.archive) {
+        HistoryArchive archive(history_path + ".archive", HistoryArchive::period_from_environment(), 0);
+        archive.scan(options.since, options.until, [](uint64_t) { return true; },
+            [&](const ArchivedText& archived) {
+                record.timestamp = archived.timestamp;
+                record.expiry = 0;
+                record.pinned = false;
+                record.text = archived.text;
+                if (passes_filters(options, record)) {
+                    if (options.format == TransferFormat::BINARY) {
+                        write_frame(output.get(), record);
+                    } else {
+                        write_jsonl_record(output.get(), record);
+                    }
+                    ++exported;
+                }
+                return true;
+            });
+    }
+
+    if (!output.close()) {
+        std::cerr << "Could not write the export: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::cerr << "Exported " << exported << " entries" << std::endl;
+    return 0;
+}
+
+// --- Import ---------------------------------------------------------------
+
+// The newest distinct entries seen so far, at most capacity of them. As in
+// the running manager, pinned entries only give way to newer pinned ones.
+class BoundedHistory {
+public:
+    explicit BoundedHistory(size_t capacity) : capacity_(capacity) {}
+
+    // Returns false if the record was a duplicate or too old to keep
+    bool add(TransferRecord record) {
+        size_t hash = std::hash<std::string>()(record.text);
+
+        for (auto& kept : kept_) {
+            if (kept.hash == hash && kept.record.text == record.text) {
+                // Keep one copy, with the newest times; pinned if either copy was
+                if (record.timestamp > kept.record.timestamp) {
+                    kept.record.timestamp = record.timestamp;
+                    kept.record.expiry = record.expiry;
+                }
+                if (record.pinned) {
+                    kept.record.pinned = true;
+                    kept.record.expiry = 0;
+                }
+                ++duplicates_;
+                return false;
+            }
+        }
+
+        if (kept_.size() < capacity_) {
+            kept_.push_back({hash, std::move(record)});
+            return true;
+        }
+
+        // Full: the oldest unpinned entry goes first, and only for a newer or
+        // pinned one; pinned entries only go when nothing else is left
+        auto oldest = std::min_element(kept_.begin(), kept_.end(), [](const Kept& a, const Kept& b) {
+            if (a.record.pinned != b.record.pinned) {
+                return !a.record.pinned;
+            }
+            return a.record.timestamp < b.record.timestamp;
+        });
+        ++evicted_;
+        if (oldest->record.pinned && !record.pinned) {
+            return false;
+        }
+        if (oldest->record.pinned == record.pinned && record.timestamp <= oldest->record.timestamp) {
+            return false;
+        }
+        *oldest = {hash, std::move(record)};
+        return true;
+    }
+
+    // Entries newest first, as the history file stores them
+    std::vector<TransferRecord> take() {
+        std::stable_sort(kept_.begin(), kept_.end(), [](const Kept& a, const Kept& b) {
+            return a.record.timestamp > b.record.timestamp;
+        });
+        std::vector<TransferRecord> records;
+        records.reserve(kept_.size());
+        for (auto& kept : kept_) {
+            records.push_back(std::move(kept.record));
+        }
+        kept_.clear();
+        return records;
+    }
+
+    size_t duplicates() const {
+        return duplicates_;
+    }
+
+    size_t evicted() const {
+        return evicted_;
+    }
+
+private:
+    struct Kept {
+        size_t hash;
+        TransferRecord record;
+    };
+
+    size_t capacity_;
+    std::vector<Kept> kept_;
+    size_t duplicates_ = 0;
+    size_t evicted_ = 0;
+};
+
+static int run_import(const TransferOptions& options) {
+    std::string history_path = default_history_path();
+    if (history_path.empty()) {
+        return 1;
+    }
+
+    std::time_t now = std::time(nullptr);
+    ExpiryPolicy policy = ExpiryPolicy::from_environment();
+    BoundedHistory merged(HISTORY_MAX_ENTRIES);
+
+    // Start from the current history
+    FILE* history = fopen(history_path.c_str(), "rb");
+    if (history) {
+        HistoryFileReader reader(history);
+        HistoryRecord entry;
+        TransferRecord record;
+        while (reader.next(entry)) {
+            if (!entry.get_text(record.text)) {
+                continue;
+            }
+            record.timestamp = entry.has_times ? entry.timestamp : now;
+            record.expiry = entry.has_times ? entry.expiry : 0;
+            record.pinned = entry.pinned;
+            merged.add(std::move(record));
+        }
+        fclose(history);
+    }
+
+    TransferStream input(options.path, false);
+    if (!input.get()) {
+        std::cerr << "Could not open " << options.path << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    TransferReader reader(input.get(), options.format);
+    if (!reader.start()) {
+        std::cerr << "Input is not a binary history export" << std::endl;
+        return 1;
+    }
+
+    size_t read = 0, skipped = 0;
+    TransferRecord record;
+    while (reader.next(record)) {
+        ++read;
+        if (record.text.empty() || !passes_filters(options, record)) {
+            ++skipped;
+            continue;
+        }
+
+        // Pinned entries never expire; records without an expiry get the
+        // current rules, counted from their creation
+        if (record.pinned) {
+            record.expiry = 0;
+        } else if (record.expiry == 0) {
+            std::time_t ttl = policy.ttl_for(record.text);
+            record.expiry = ttl > 0 ? record.timestamp + ttl : 0;
+        }
+        if (record.expiry != 0 && record.expiry <= now) {
+            ++skipped;
+            continue;
+        }
+        merged.add(std::move(record));
+    }
+    if (!reader.error().empty()) {
+        std::cerr << "Stopped reading: " << reader.error() << std::endl;
+    }
+
+    // Replace the history file atomically
+    std::string temp_path = history_path + ".import";
+    FILE* out = fopen(temp_path.c_str(), "wb");
+    if (!out) {
+        std::cerr << "Could not open " << temp_path << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+    std::vector<char> out_buffer(TRANSFER_BUFFER_SIZE);
+    setvbuf(out, out_buffer.data(), _IOFBF, out_buffer.size());
+
+    std::vector<TransferRecord> records = merged.take();
+    for (const auto& kept : records) {
+        write_history_text(out, kept.timestamp, kept.expiry, kept.text, HISTORY_COMPRESS_MIN_SIZE,
+                           kept.pinned);
+    }
+    bool written = fflush(out) == 0 && !ferror(out);
+    written = fclose(out) == 0 && written;
+    if (!written || rename(temp_path.c_str(), history_path.c_str()) != 0) {
+        std::cerr << "Could not write " << history_path << ": " << strerror(errno) << std::endl;
+        unlink(temp_path.c_str());
+        return 1;
+    }
+
+    std::cerr << "Read " << read << " entries: " << skipped << " filtered or expired, "
+              << merged.duplicates() << " duplicates, " << merged.evicted() << " over capacity; "
+              << "history now holds " << records.size() << std::endl;
+    return 0;
+}
+
+// --- Command line ---------------------------------------------------------
+
+// Unix time or YYYY-MM-DD (local midnight)
+static bool parse_time(const char* value, std::time_t& out) {
+    int year = 0, month = 0, day = 0;
+    char extra = 0;
+    if (sscanf(value, "%d-%d-%d%c", &year, &month, &day, &extra) == 3) {
+        std::tm tm = {};
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        tm.tm_isdst = -1;
+        out = mktime(&tm);
+        return out != static_cast<std::time_t>(-1);
+    }
+
+    char* end = nullptr;
+    long long seconds = strtoll(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || seconds < 0) {
+        return false;
+    }
+    out = static_cast<std::time_t>(seconds);
+    return true;
+}
+
+static bool parse_size(const char* value, size_t& out) {
+    char* end = nullptr;
+    unsigned long long size = strtoull(value, &end, 10);
+    if (*value == '\0' || *end != '\0') {
+        return false;
+    }
+    out = static_cast<size_t>(size);
+    return true;
+}
+
+static bool parse_options(int argc, char* argv[], TransferOptions& options) {
+    options.import = strcmp(argv[1], "--import") == 0;
+
+    for (int i = 2; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = strchr(arg, '=');
+        value = value ? value + 1 : "";
+
+        if (strncmp(arg, "--format=", 9) == 0) {
+            if (strcmp(value, "jsonl") == 0) {
+                options.format = TransferFormat::JSONL;
+            } else if (strcmp(value, "binary") == 0) {
+                options.format = TransferFormat::BINARY;
+            } else {
+                std::cerr << "Unknown format: " << value << std::endl;
+                return false;
+            }
+        } else if (strncmp(arg, "--since=", 8) == 0 || strncmp(arg, "--until=", 8) == 0) {
+            std::time_t& bound = arg[2] == 's' ? options.since : options.until;
+            if (!parse_time(value, bound)) {
+                std::cerr << "Invalid time: " << value << std::endl;
+                return false;
+            }
+        } else if (strncmp(arg, "--min-size=", 11) == 0 || strncmp(arg, "--max-size=", 11) == 0) {
+            size_t& bound = arg[3] == 'i' ? options.min_size : options.max_size;
+            if (!parse_size(value, bound)) {
+                std::cerr << "Invalid size: " << value << std::endl;
+                return false;
+            }
+        } else if (strcmp(arg, "--archive") == 0 && !options.import) {
+            options.archive = true;
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        } else if (options.path.empty()) {
+            options.path = arg;
+        } else {
+            std::cerr << "Only one file can be given" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool is_transfer_command(int argc, char* argv[]) {
+    return argc > 1 && (strcmp(argv[1], "--export") == 0 || strcmp(argv[1], "--import") == 0);
+}
+
+int run_transfer_command(int argc, char* argv[]) {
+    TransferOptions options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " --export|--import [--format=jsonl|binary] "
+                  << "[--since=WHEN] [--until=WHEN] [--min-size=N] [--max-size=N] [--archive] [FILE]" << std::endl;
+        return 2;
+    }
+    return options.import ? run_import(options) : run_export(options);
+}
@@ -0,0 +1,54 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef HISTORY_TRANSFER_HPP
+#define HISTORY_TRANSFER_HPP
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+
+// Command line export and import of the history file:
+//
+//   clipboard_manager --export [options] [FILE]
+//   clipboard_manager --import [options] [FILE]
+//
+// FILE defaults to standard output/input. Options:
+//   --format=jsonl|binary   JSON Lines (default) or length-prefixed frames
+//   --since=WHEN --until=WHEN   Only entries created in [since, until];
+//                           WHEN is a Unix time or a YYYY-MM-DD date
+//   --min-size=N --max-size=N   Only entries of N bytes or more/less
+//   --archive               Export also the archived entries (see
+//                           HistoryArchive); only the segments of the
+//                           --since/--until range are read
+//
+// Both directions stream one entry at a time through fixed-size buffers.
+// Import merges into the history file with the same deduplication and
+// capacity rules as the running manager; stop the manager first, or it will
+// overwrite the file when it exits.
+
+enum class TransferFormat {
+    JSONL,
+    BINARY
+};
+
+struct TransferOptions {
+    bool import = false;
+    TransferFormat format = TransferFormat::JSONL;
+    std::string path;          // Empty or "-" for stdin/stdout
+    std::time_t since = 0;     // 0 = no lower bound
+    std::time_t until = 0;     // 0 = no upper bound
+    size_t min_size = 0;
+    size_t max_size = 0;       // 0 = no upper bound
+    bool archive = false;      // Export the archive after the history
+};
+
+// Whether argv asks for --export or --import
+bool is_transfer_command(int argc, char* argv[]);
+
+// Parse the arguments and run the transfer; returns the process exit status
+int run_transfer_command(int argc, char* argv[]);
+
+#endif // HISTORY_TRANSFER_HPP
@@ -0,0 +1,120 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "line_index.hpp"
+#include "entry_content.hpp"
+#include <cstring>
+
+const size_t LineIndex::MAX_LINE_BYTES;
+const size_t LineIndex::SCAN_BLOCK_SIZE;
+
+static bool is_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+LineIndex::LineIndex(std::shared_ptr<const EntryContent> content)
+    : content_(std::move(content)), starts_{0}, complete_(false), cancelled_(false) {
+}
+
+LineIndex::~LineIndex() {
+    cancelled_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void LineIndex::start() {
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&LineIndex::run, this);
+    }
+}
+
+size_t LineIndex::get_line_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return starts_.size() - 1;
+}
+
+bool LineIndex::is_complete() const {
+    return complete_;
+}
+
+bool LineIndex::get_line(size_t line, std::string& text) const {
+    size_t start;
+    size_t end;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (line + 1 >= starts_.size()) {
+            return false;
+        }
+        start = starts_[line];
+        end = starts_[line + 1];
+    }
+
+    content_->read(start, end - start, text);
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+        text.pop_back();
+    }
+    return true;
+}
+
+void LineIndex::run() {
+    const size_t size = content_->size();
+    std::string block;
+    std::vector<size_t> found;
+    size_t line_start = 0;
+
+    for (size_t offset = 0; offset < size && !cancelled_; offset += block.size()) {
+        if (content_->read(offset, SCAN_BLOCK_SIZE, block) == 0) {
+            break;
+        }
+
+        const char* data = block.data();
+        size_t position = 0;
+        while (position < block.size()) {
+            const char* newline = static_cast<const char*>(memchr(data + position, '\n', block.size() - position));
+            size_t text_end = newline ? offset + static_cast<size_t>(newline - data) : offset + block.size();
+
+            // Cut an overlong line, backing off to the start of a character;
+            // the cut may fall before this block when the line started in an
+            // earlier one, so it is then checked through the content
+            while (text_end - line_start > MAX_LINE_BYTES) {
+                size_t cut = line_start + MAX_LINE_BYTES;
+                std::string around;
+                size_t back = 0;
+                if (cut >= offset + 3) {
+                    while (back < 3 && is_continuation(data[cut - offset - back])) {
+                        ++back;
+                    }
+                } else if (content_->read(cut - 3, 4, around) == 4) {
+                    while (back < 3 && is_continuation(around[3 - back])) {
+                        ++back;
+                    }
+                }
+                line_start = cut - back;
+                found.push_back(line_start);
+            }
+
+            if (!newline) {
+                break;
+            }
+            line_start = text_end + 1;
+            found.push_back(line_start);
+            position = line_start - offset;
+        }
+
+        // Publish the lines of this block
+        std::lock_guard<std::mutex> lock(mutex_);
+        starts_.insert(starts_.end(), found.begin(), found.end());
+        found.clear();
+    }
+
+    // A last line without a line break
+    if (!cancelled_) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (starts_.back() < size) {
+            starts_.push_back(size);
+        }
+    }
+    complete_ = true;
+}
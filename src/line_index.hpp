@@ -0,0 +1,63 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef LINE_INDEX_HPP
+#define LINE_INDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class EntryContent;
+
+// Where the display lines of a text start, found by a worker thread one
+// block at a time so a viewer can show the first lines right away and grow
+// as the rest is indexed. Lines longer than MAX_LINE_BYTES are cut into
+// several display lines at UTF-8 character boundaries, so no line is ever
+// too long to lay out.
+class LineIndex {
+public:
+    static const size_t MAX_LINE_BYTES = 1024;
+
+    // Bytes scanned per step; lines found in a step are published together
+    static const size_t SCAN_BLOCK_SIZE = 1024 * 1024;
+
+    explicit LineIndex(std::shared_ptr<const EntryContent> content);
+
+    // Stops the worker
+    ~LineIndex();
+
+    LineIndex(const LineIndex&) = delete;
+    LineIndex& operator=(const LineIndex&) = delete;
+
+    // Start indexing in the background
+    void start();
+
+    // Lines indexed so far, and whether that is all of them
+    size_t get_line_count() const;
+    bool is_complete() const;
+
+    // Text of an indexed display line, without its line break
+    bool get_line(size_t line, std::string& text) const;
+
+private:
+    void run();
+
+    std::shared_ptr<const EntryContent> content_;
+
+    // Start of every indexed line, plus the start of the next one
+    mutable std::mutex mutex_;
+    std::vector<size_t> starts_;
+
+    std::atomic<bool> complete_;
+    std::atomic<bool> cancelled_;
+    std::thread thread_;
+};
+
+#endif // LINE_INDEX_HPP
@@ -4,6 +4,9 @@
 
 
  #include <gtk/gtk.h>
+ #include <glib-unix.h>
+ #include <csignal>
+ #include <cstring>
  #include <iostream>
  #include <memory>
  
@@ -11,9 +14,68 @@
  #include "clipboard_manager.hpp"
  #include "ui/main_window.hpp"
  #include "ui/shortcuts.hpp"
- // No longer using separate tray icon window
+ #include "history_transfer.hpp"
+ #include "trace_replay.hpp"
+ #include "display_hub.hpp"
+ #include "activation_socket.hpp"
+ #include "ui/tray_icon.hpp"
+ 
+ // Activation socket of this instance (-1 until the window exists)
+ static int activation_fd = -1;
+ 
+ // StatusNotifierItem tray icon (null when disabled)
+ static TrayIcon* tray_icon = NULL;
+ 
+ // Toggle requests from vmcastle-toggle, timed from when the client sent them
+ static gboolean on_activation_request(gint fd, GIOCondition condition G_GNUC_UNUSED, gpointer user_data) {
+     MainWindow* window = MAIN_WINDOW(user_data);
+     ActivationRequest request;
+     while (activation_receive(fd, request)) {
+         if (request.command == "toggle") {
+             gint64 sent_at = request.sent_at_us > 0 ? request.sent_at_us : g_get_monotonic_time();
+             main_window_toggle_visibility_timed(window, sent_at);
+         }
+     }
+     return G_SOURCE_CONTINUE;
+ }
+ 
+ // Listen on every fast activation path once the window exists
+ static void setup_activation(MainWindow* window) {
+     // Older hotkey scripts send SIGUSR1
+     g_unix_signal_add(SIGUSR1, +[](gpointer user_data) -> gboolean {
+         main_window_toggle_visibility(MAIN_WINDOW(user_data));
+         return G_SOURCE_CONTINUE;
+     }, window);
+     
+     activation_fd = activation_listen();
+     if (activation_fd >= 0) {
+         g_unix_fd_add(activation_fd, G_IO_IN, on_activation_request, window);
+     } else {
+         std::cerr << "Activation socket unavailable: " << activation_socket_path() << std::endl;
+     }
+ }
  
  int main(int argc, char* argv[]) {
+     // Export and import run on the history file, without a display
+     if (is_transfer_command(argc, argv)) {
+         return run_transfer_command(argc, argv);
+     }
+     
+     // Capture trace replay, also without a display
+     if (is_replay_command(argc, argv)) {
+         return run_replay_command(argc, argv);
+     }
+     
+     // Several X displays from one headless process
+     if (is_multi_display_command(argc, argv)) {
+         return run_multi_display_command(argc, argv);
+     }
+     
+     // Toggle the running instance without loading a second UI
+     if (argc == 2 && strcmp(argv[1], "--toggle") == 0) {
+         return activation_send("toggle") ? 0 : 1;
+     }
+     
      // Initialize GTK
      gtk_init();
      
@@ -26,7 +88,14 @@
      g_signal_connect(app, "activate", G_CALLBACK(+[](GtkApplication* app, gpointer user_data) {
          auto manager = static_cast<std::shared_ptr<ClipboardManager>*>(user_data);
          
-         // Create main window (we're not using separate tray icon anymore)
+         // Launching again while running toggles the existing window
+         GList* windows = gtk_application_get_windows(app);
+         if (windows) {
+             main_window_toggle_visibility(MAIN_WINDOW(windows->data));
+             return;
+         }
+         
+         // Create main window
          MainWindow* window = main_window_new(app, *manager);
          
          // Add a header bar with app menu
@@ -91,6 +160,15 @@
          // Initialize shortcuts
          shortcuts_init(app, *manager, GTK_WINDOW(window));
          
+         // Hotkey client and signal activation
+         setup_activation(window);
+         
+         // Tray icon for panels implementing StatusNotifierItem; VMCASTLE_TRAY=0 disables it
+         const char* tray = g_getenv("VMCASTLE_TRAY");
+         if (!tray || strcmp(tray, "0") != 0) {
+             tray_icon = tray_icon_new(*manager, GTK_WINDOW(window));
+             tray_icon_show(tray_icon);
+         }
      }), &clipboard_manager);
      
      // Start clipboard monitoring
@@ -100,6 +178,10 @@
      int status = g_application_run(G_APPLICATION(app), argc, argv);
      
      // Cleanup
+     activation_close(activation_fd);
+     if (tray_icon) {
+         g_object_unref(tray_icon);
+     }
      shortcuts_cleanup();
      g_object_unref(app);
      
@@ -0,0 +1,199 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "near_duplicate.hpp"
+#include "clipboard_entry.hpp"
+#include <algorithm>
+
+static const size_t SHINGLE_SIZE = 8;
+
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline bool is_space(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+TextSignature compute_signature(const char* data, size_t size) {
+    TextSignature signature;
+    signature.bins.fill(UINT32_MAX);
+
+    // One-permutation MinHash: the top bits of a shingle hash pick the bin,
+    // the low bits compete for its minimum
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    uint64_t window = 0;
+    size_t normalized = 0;
+    bool pending_space = false;
+    for (size_t i = 0; i < size; ++i) {
+        unsigned char c = bytes[i];
+
+        // Runs of whitespace count as one space; leading and trailing ones vanish
+        if (is_space(c)) {
+            pending_space = normalized > 0;
+            continue;
+        }
+        if (pending_space) {
+            pending_space = false;
+            window = (window << 8) | ' ';
+            if (++normalized >= SHINGLE_SIZE) {
+                uint64_t hash = mix64(window);
+                uint32_t& bin = signature.bins[hash >> (64 - 6)];
+                bin = std::min(bin, static_cast<uint32_t>(hash));
+            }
+        }
+        window = (window << 8) | c;
+        if (++normalized >= SHINGLE_SIZE) {
+            uint64_t hash = mix64(window);
+            uint32_t& bin = signature.bins[hash >> (64 - 6)];
+            bin = std::min(bin, static_cast<uint32_t>(hash));
+        }
+    }
+
+    if (normalized < SIGNATURE_MIN_SIZE) {
+        return TextSignature();
+    }
+
+    // Densify: an empty bin borrows the next filled one, salted by distance,
+    // so that similar texts still agree on it
+    std::array<uint32_t, MINHASH_BINS> filled = signature.bins;
+    for (size_t i = 0; i < MINHASH_BINS; ++i) {
+        if (filled[i] != UINT32_MAX) {
+            continue;
+        }
+        for (size_t distance = 1; distance < MINHASH_BINS; ++distance) {
+            uint32_t donor = filled[(i + distance) % MINHASH_BINS];
+            if (donor != UINT32_MAX) {
+                signature.bins[i] = static_cast<uint32_t>(mix64(donor + distance * 0x9E3779B97F4A7C15ull));
+                break;
+            }
+        }
+    }
+    signature.valid = true;
+    return signature;
+}
+
+double estimate_similarity(const TextSignature& a, const TextSignature& b) {
+    if (!a.valid || !b.valid) {
+        return 0.0;
+    }
+    size_t equal = 0;
+    for (size_t i = 0; i < MINHASH_BINS; ++i) {
+        equal += a.bins[i] == b.bins[i];
+    }
+    return static_cast<double>(equal) / MINHASH_BINS;
+}
+
+static uint64_t band_key(const TextSignature& signature, size_t band) {
+    uint64_t key = mix64(band + 1);
+    for (size_t row = 0; row < MINHASH_BAND_ROWS; ++row) {
+        key = mix64(key ^ signature.bins[band * MINHASH_BAND_ROWS + row]);
+    }
+    return key;
+}
+
+void NearDuplicateIndex::add(const ClipboardEntry* entry) {
+    const TextSignature& signature = entry->get_signature();
+    if (!signature.valid) {
+        return;
+    }
+    for (size_t band = 0; band < MINHASH_BANDS; ++band) {
+        buckets_[band_key(signature, band)].push_back(entry);
+    }
+}
+
+void NearDuplicateIndex::remove(const ClipboardEntry* entry) {
+    const TextSignature& signature = entry->get_signature();
+    if (!signature.valid) {
+        return;
+    }
+    for (size_t band = 0; band < MINHASH_BANDS; ++band) {
+        auto it = buckets_.find(band_key(signature, band));
+        if (it == buckets_.end()) {
+            continue;
+        }
+        auto& bucket = it->second;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), entry), bucket.end());
+        if (bucket.empty()) {
+            buckets_.erase(it);
+        }
+    }
+}
+
+void NearDuplicateIndex::clear() {
+    buckets_.clear();
+}
+
+void NearDuplicateIndex::build(const std::vector<std::shared_ptr<ClipboardEntry>>& entries) {
+    buckets_.clear();
+    for (const auto& entry : entries) {
+        add(entry.get());
+    }
+}
+
+void NearDuplicateIndex::find(const TextSignature& signature, std::vector<const ClipboardEntry*>& out,
+                              double threshold) const {
+    out.clear();
+    if (!signature.valid) {
+        return;
+    }
+
+    // Texts sharing any band are candidates; confirm them on the whole signature
+    for (size_t band = 0; band < MINHASH_BANDS; ++band) {
+        auto it = buckets_.find(band_key(signature, band));
+        if (it == buckets_.end()) {
+            continue;
+        }
+        for (const ClipboardEntry* candidate : it->second) {
+            if (std::find(out.begin(), out.end(), candidate) == out.end() &&
+                estimate_similarity(signature, candidate->get_signature()) >= threshold) {
+                out.push_back(candidate);
+            }
+        }
+    }
+}
+
+std::vector<size_t> cluster_near_duplicates(const std::vector<std::shared_ptr<ClipboardEntry>>& entries) {
+    std::unordered_map<const ClipboardEntry*, size_t> positions;
+    NearDuplicateIndex index;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        positions[entries[i].get()] = i;
+        index.add(entries[i].get());
+    }
+
+    // Union-find keeping the newest entry as the root of each cluster
+    std::vector<size_t> parent(entries.size());
+    for (size_t i = 0; i < parent.size(); ++i) {
+        parent[i] = i;
+    }
+    auto root = [&parent](size_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    std::vector<const ClipboardEntry*> similar;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        index.find(entries[i]->get_signature(), similar);
+        for (const ClipboardEntry* other : similar) {
+            size_t a = root(i);
+            size_t b = root(positions[other]);
+            if (a != b) {
+                parent[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < parent.size(); ++i) {
+        parent[i] = root(i);
+    }
+    return parent;
+}
@@ -0,0 +1,68 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef NEAR_DUPLICATE_HPP
+#define NEAR_DUPLICATE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class ClipboardEntry;
+
+// Near-duplicate detection with MinHash. Each text gets a signature at
+// ingest: the minimum hash of its 8-byte shingles (after collapsing
+// whitespace) in each of 64 bins. The share of equal bins estimates the
+// Jaccard similarity of two texts, and banding the signature into an LSH
+// index finds the candidates without comparing against every entry.
+
+const size_t MINHASH_BINS = 64;
+const size_t MINHASH_BAND_ROWS = 4;
+const size_t MINHASH_BANDS = MINHASH_BINS / MINHASH_BAND_ROWS;
+
+// Texts shorter than this (after collapsing whitespace) get no signature
+const size_t SIGNATURE_MIN_SIZE = 32;
+
+// Estimated similarity at which two texts count as variants of each other
+const double NEAR_DUPLICATE_THRESHOLD = 0.7;
+
+struct TextSignature {
+    bool valid = false;
+    std::array<uint32_t, MINHASH_BINS> bins{};
+};
+
+// Signature of a text (invalid if the text is too short)
+TextSignature compute_signature(const char* data, size_t size);
+
+// Estimated Jaccard similarity of the shingle sets behind two signatures
+double estimate_similarity(const TextSignature& a, const TextSignature& b);
+
+// LSH index over the signatures of one history stream. Entries are keyed by
+// address, so they must be removed before they leave the stream.
+class NearDuplicateIndex {
+public:
+    void add(const ClipboardEntry* entry);
+    void remove(const ClipboardEntry* entry);
+    void clear();
+
+    // Index every entry of a stream
+    void build(const std::vector<std::shared_ptr<ClipboardEntry>>& entries);
+
+    // Indexed entries at least threshold similar to signature
+    void find(const TextSignature& signature, std::vector<const ClipboardEntry*>& out,
+              double threshold = NEAR_DUPLICATE_THRESHOLD) const;
+
+private:
+    std::unordered_map<uint64_t, std::vector<const ClipboardEntry*>> buckets_;
+};
+
+// Group a stream into clusters of variants. Returns for each entry the index
+// of the first (newest) entry of its cluster.
+std::vector<size_t> cluster_near_duplicates(const std::vector<std::shared_ptr<ClipboardEntry>>& entries);
+
+#endif // NEAR_DUPLICATE_HPP
@@ -0,0 +1,512 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "paste_transform.hpp"
+#include "entry_content.hpp"
+#include "utf8_validate.hpp"
+#include "text_hash.hpp"
+#include <glib.h>
+#include <algorithm>
+
+namespace {
+
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool is_line_break(char c) {
+    return c == '\n' || c == '\r';
+}
+
+int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Both the standard and the URL-safe alphabet
+int base64_value(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+' || c == '-') {
+        return 62;
+    }
+    if (c == '/' || c == '_') {
+        return 63;
+    }
+    return -1;
+}
+
+// Whitespace at the start is dropped and whitespace runs are held until a
+// non-blank byte shows they are not the end
+class TrimStage : public TransformStage {
+public:
+    bool push(const char* data, size_t size, std::string& out) override {
+        size_t i = 0;
+        while (i < size) {
+            if (is_blank(data[i])) {
+                size_t start = i;
+                while (i < size && is_blank(data[i])) {
+                    i++;
+                }
+                if (started_) {
+                    blanks_.append(data + start, i - start);
+                }
+                continue;
+            }
+            size_t start = i;
+            while (i < size && !is_blank(data[i])) {
+                i++;
+            }
+            out += blanks_;
+            blanks_.clear();
+            out.append(data + start, i - start);
+            started_ = true;
+        }
+        return true;
+    }
+
+    bool finish(std::string& out) override {
+        (void)out;
+        blanks_.clear();
+        return true;
+    }
+
+private:
+    bool started_ = false;
+    std::string blanks_;
+};
+
+// A whitespace run holding a line break becomes one space; runs at either
+// end that hold one are dropped, other blanks are kept as they are
+class SingleLineStage : public TransformStage {
+public:
+    bool push(const char* data, size_t size, std::string& out) override {
+        size_t i = 0;
+        while (i < size) {
+            char c = data[i];
+            if (is_line_break(c)) {
+                line_break_ = true;
+                blanks_.clear();
+                i++;
+                continue;
+            }
+            if (is_blank(c)) {
+                if (!line_break_) {
+                    blanks_.push_back(c);
+                }
+                i++;
+                continue;
+            }
+            if (line_break_) {
+                if (started_) {
+                    out.push_back(' ');
+                }
+            } else {
+                out += blanks_;
+            }
+            blanks_.clear();
+            line_break_ = false;
+            started_ = true;
+
+            size_t start = i;
+            while (i < size && !is_blank(data[i])) {
+                i++;
+            }
+            out.append(data + start, i - start);
+        }
+        return true;
+    }
+
+    bool finish(std::string& out) override {
+        if (!line_break_) {
+            out += blanks_;
+        }
+        blanks_.clear();
+        return true;
+    }
+
+private:
+    bool started_ = false;
+    bool line_break_ = false;
+    std::string blanks_;
+};
+
+// Re-indents by structure only: whitespace outside strings is dropped and
+// put back after every opening bracket, comma and before every closing one.
+// Empty containers stay on one line. Input that is not JSON comes out
+// reformatted but otherwise intact.
+class JsonPrettyStage : public TransformStage {
+public:
+    bool push(const char* data, size_t size, std::string& out) override {
+        for (size_t i = 0; i < size; i++) {
+            char c = data[i];
+            if (in_string_) {
+                out.push_back(c);
+                if (escaped_) {
+                    escaped_ = false;
+                } else if (c == '\\') {
+                    escaped_ = true;
+                } else if (c == '"') {
+                    in_string_ = false;
+                }
+                continue;
+            }
+            switch (c) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                break;
+            case '{':
+            case '[':
+                open_pending(out);
+                pending_open_ = c;
+                break;
+            case '}':
+            case ']':
+                if (pending_open_) {
+                    out.push_back(pending_open_);
+                    pending_open_ = 0;
+                } else {
+                    depth_ = depth_ > 0 ? depth_ - 1 : 0;
+                    new_line(out);
+                }
+                out.push_back(c);
+                break;
+            case ',':
+                open_pending(out);
+                out.push_back(',');
+                new_line(out);
+                break;
+            case ':':
+                open_pending(out);
+                out += ": ";
+                break;
+            case '"':
+                open_pending(out);
+                out.push_back('"');
+                in_string_ = true;
+                break;
+            default:
+                open_pending(out);
+                out.push_back(c);
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool finish(std::string& out) override {
+        if (pending_open_) {
+            out.push_back(pending_open_);
+            pending_open_ = 0;
+        }
+        return true;
+    }
+
+private:
+    static const size_t INDENT = 2;
+
+    // An opening bracket is held until the next token shows whether the
+    // container is empty
+    void open_pending(std::string& out) {
+        if (pending_open_) {
+            out.push_back(pending_open_);
+            pending_open_ = 0;
+            depth_++;
+            new_line(out);
+        }
+    }
+
+    void new_line(std::string& out) {
+        out.push_back('\n');
+        out.append(depth_ * INDENT, ' ');
+    }
+
+    bool in_string_ = false;
+    bool escaped_ = false;
+    char pending_open_ = 0;
+    size_t depth_ = 0;
+};
+
+// %XX escapes become bytes; a '%' not followed by two hex digits is kept
+class UrlDecodeStage : public TransformStage {
+public:
+    bool push(const char* data, size_t size, std::string& out) override {
+        for (size_t i = 0; i < size; i++) {
+            char c = data[i];
+            if (pending_ == 0) {
+                if (c == '%') {
+                    pending_ = 1;
+                } else {
+                    out.push_back(c);
+                }
+                continue;
+            }
+            int value = hex_value(c);
+            if (value < 0) {
+                // Not an escape: keep what was held and look at c again
+                out.push_back('%');
+                if (pending_ == 2) {
+                    out.push_back(high_char_);
+                }
+                pending_ = 0;
+                i--;
+                continue;
+            }
+            if (pending_ == 1) {
+                high_char_ = c;
+                high_ = value;
+                pending_ = 2;
+            } else {
+                out.push_back(static_cast<char>(high_ * 16 + value));
+                pending_ = 0;
+            }
+        }
+        return true;
+    }
+
+    bool finish(std::string& out) override {
+        if (pending_ > 0) {
+            out.push_back('%');
+        }
+        if (pending_ == 2) {
+            out.push_back(high_char_);
+        }
+        pending_ = 0;
+        return true;
+    }
+
+private:
+    int pending_ = 0;       // Bytes of an escape seen so far
+    char high_char_ = 0;
+    int high_ = 0;
+};
+
+// Four characters at a time; whitespace is skipped, padding ends the data
+class Base64DecodeStage : public TransformStage {
+public:
+    bool push(const char* data, size_t size, std::string& out) override {
+        for (size_t i = 0; i < size; i++) {
+            char c = data[i];
+            if (is_blank(c)) {
+                continue;
+            }
+            if (c == '=') {
+                padded_ = true;
+                continue;
+            }
+            int value = base64_value(c);
+            if (value < 0 || padded_) {
+                return false;
+            }
+            quad_ = (quad_ << 6) | static_cast<uint32_t>(value);
+            if (++count_ == 4) {
+                out.push_back(static_cast<char>(quad_ >> 16));
+                out.push_back(static_cast<char>(quad_ >> 8));
+                out.push_back(static_cast<char>(quad_));
+                quad_ = 0;
+                count_ = 0;
+            }
+        }
+        return true;
+    }
+
+    bool finish(std::string& out) override {
+        // A lone character cannot encode a byte
+        if (count_ == 1) {
+            return false;
+        }
+        if (count_ == 2) {
+            out.push_back(static_cast<char>(quad_ >> 4));
+        } else if (count_ == 3) {
+            out.push_back(static_cast<char>(quad_ >> 10));
+            out.push_back(static_cast<char>(quad_ >> 2));
+        }
+        quad_ = 0;
+        count_ = 0;
+        return true;
+    }
+
+private:
+    uint32_t quad_ = 0;
+    int count_ = 0;
+    bool padded_ = false;
+};
+
+// Unicode case mapping of whole characters: a character split across
+// blocks waits for the rest of it. Invalid bytes are only ASCII-mapped.
+class CaseStage : public TransformStage {
+public:
+    explicit CaseStage(bool upper) : upper_(upper) {}
+
+    bool push(const char* data, size_t size, std::string& out) override {
+        if (!pending_.empty()) {
+            // Complete the held character first, with continuation bytes
+            // only: any other byte starts something new
+            size_t needed = sequence_length(pending_[0]) - pending_.size();
+            size_t taken = 0;
+            while (taken < needed && taken < size && (static_cast<unsigned char>(data[taken]) & 0xC0) == 0x80) {
+                taken++;
+            }
+            pending_.append(data, taken);
+            data += taken;
+            size -= taken;
+            if (taken < needed && size == 0) {
+                return true;
+            }
+            map(pending_.data(), pending_.size(), out);
+            pending_.clear();
+        }
+
+        size_t cut = complete_prefix(data, size);
+        map(data, cut, out);
+        pending_.assign(data + cut, size - cut);
+        return true;
+    }
+
+    bool finish(std::string& out) override {
+        map(pending_.data(), pending_.size(), out);
+        pending_.clear();
+        return true;
+    }
+
+private:
+    static size_t sequence_length(char lead) {
+        unsigned char c = static_cast<unsigned char>(lead);
+        if (c >= 0xF0) {
+            return 4;
+        }
+        if (c >= 0xE0) {
+            return 3;
+        }
+        return c >= 0xC0 ? 2 : 1;
+    }
+
+    // Length of data without a character cut off at its end
+    static size_t complete_prefix(const char* data, size_t size) {
+        for (size_t back = 1; back <= 3 && back <= size; back++) {
+            unsigned char c = static_cast<unsigned char>(data[size - back]);
+            if ((c & 0xC0) != 0x80) {
+                return c >= 0xC0 && sequence_length(static_cast<char>(c)) > back ? size - back : size;
+            }
+        }
+        return size;
+    }
+
+    // Valid runs are case-mapped whole and invalid bytes one by one, so the
+    // output does not depend on where the blocks were cut
+    void map(const char* data, size_t size, std::string& out) const {
+        while (size > 0) {
+            const gchar* end = data + size;
+            if (!utf8_is_valid(data, size)) {
+                g_utf8_validate(data, static_cast<gssize>(size), &end);
+            }
+            size_t valid = static_cast<size_t>(end - data);
+            if (valid > 0) {
+                gchar* mapped = upper_ ? g_utf8_strup(data, static_cast<gssize>(valid))
+                                       : g_utf8_strdown(data, static_cast<gssize>(valid));
+                out += mapped;
+                g_free(mapped);
+            }
+            if (valid == size) {
+                return;
+            }
+            out.push_back(upper_ ? g_ascii_toupper(data[valid]) : g_ascii_tolower(data[valid]));
+            data += valid + 1;
+            size -= valid + 1;
+        }
+    }
+
+    bool upper_;
+    std::string pending_;
+};
+
+} // namespace
+
+std::unique_ptr<TransformStage> make_transform_stage(PasteTransform transform) {
+    switch (transform) {
+    case PasteTransform::TRIM:
+        return std::unique_ptr<TransformStage>(new TrimStage());
+    case PasteTransform::SINGLE_LINE:
+        return std::unique_ptr<TransformStage>(new SingleLineStage());
+    case PasteTransform::JSON_PRETTY:
+        return std::unique_ptr<TransformStage>(new JsonPrettyStage());
+    case PasteTransform::URL_DECODE:
+        return std::unique_ptr<TransformStage>(new UrlDecodeStage());
+    case PasteTransform::BASE64_DECODE:
+        return std::unique_ptr<TransformStage>(new Base64DecodeStage());
+    case PasteTransform::UPPERCASE:
+        return std::unique_ptr<TransformStage>(new CaseStage(true));
+    case PasteTransform::LOWERCASE:
+        return std::unique_ptr<TransformStage>(new CaseStage(false));
+    }
+    return nullptr;
+}
+
+bool run_paste_transforms(const EntryContent& content, const std::vector<PasteTransform>& transforms,
+                          const std::function<bool(const char* data, size_t size)>& sink,
+                          TransformedSize* result) {
+    std::vector<std::unique_ptr<TransformStage>> stages;
+    for (PasteTransform transform : transforms) {
+        stages.push_back(make_transform_stage(transform));
+    }
+
+    uint64_t hash = TEXT_HASH_SEED;
+    size_t total = 0;
+
+    // Each stage's output is the next one's input; the last block also
+    // flushes every stage in order
+    std::string block;
+    std::string next;
+    auto pass = [&](bool last) {
+        for (auto& stage : stages) {
+            next.clear();
+            if (!stage->push(block.data(), block.size(), next) || (last && !stage->finish(next))) {
+                return false;
+            }
+            block.swap(next);
+        }
+        if (block.empty()) {
+            return true;
+        }
+        hash = hash_text(block.data(), block.size(), hash);
+        total += block.size();
+        return sink(block.data(), block.size());
+    };
+
+    size_t offset = 0;
+    while (offset < content.size()) {
+        size_t count = content.read(offset, TRANSFORM_BLOCK_SIZE, block);
+        if (count == 0 || !pass(false)) {
+            return false;
+        }
+        offset += count;
+    }
+    block.clear();
+    if (!pass(true)) {
+        return false;
+    }
+
+    if (result) {
+        result->size = total;
+        result->hash = hash;
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef PASTE_TRANSFORM_HPP
+#define PASTE_TRANSFORM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class EntryContent;
+
+// Variants of an entry that can be pasted instead of its stored bytes
+enum class PasteTransform {
+    TRIM,           // Without leading and trailing whitespace
+    SINGLE_LINE,    // Line breaks (and the blanks around them) become one space
+    JSON_PRETTY,    // JSON re-indented by two spaces
+    URL_DECODE,     // %XX escapes decoded
+    BASE64_DECODE,  // Standard or URL-safe base64, whitespace ignored
+    UPPERCASE,
+    LOWERCASE
+};
+
+const size_t PASTE_TRANSFORM_COUNT = 7;
+
+// One streaming step of a transform. Input arrives in blocks of any size;
+// a stage only keeps what it cannot decide yet (a pending escape, a base64
+// quad, a run of blanks), so memory stays bounded by the block size and not
+// by the payload.
+class TransformStage {
+public:
+    virtual ~TransformStage() = default;
+
+    // Append the output for a block of input to out; false if the input
+    // cannot be transformed (invalid base64)
+    virtual bool push(const char* data, size_t size, std::string& out) = 0;
+
+    // Append whatever was held back once the input ended
+    virtual bool finish(std::string& out) = 0;
+};
+
+std::unique_ptr<TransformStage> make_transform_stage(PasteTransform transform);
+
+// Output of a transform run: its size and FNV-1a hash (the same hash as
+// hash_text in text_hash.hpp), enough to recognize it without keeping it
+struct TransformedSize {
+    size_t size = 0;
+    uint64_t hash = 0;
+};
+
+// Read content in blocks of TRANSFORM_BLOCK_SIZE, pass each through the
+// transforms in order and hand the output to sink as it is produced. Stops
+// with false when a stage rejects the input or sink returns false.
+const size_t TRANSFORM_BLOCK_SIZE = 64 * 1024;
+
+bool run_paste_transforms(const EntryContent& content, const std::vector<PasteTransform>& transforms,
+                          const std::function<bool(const char* data, size_t size)>& sink,
+                          TransformedSize* result = nullptr);
+
+#endif // PASTE_TRANSFORM_HPP
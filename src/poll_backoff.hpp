@@ -0,0 +1,41 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef POLL_BACKOFF_HPP
+#define POLL_BACKOFF_HPP
+
+#include <algorithm>
+
+// Interval of a poller that has no change notifications: short right after a
+// change or user activity, doubling each time nothing changed up to a
+// ceiling, and a separate long interval while the screen is locked.
+class PollBackoff {
+public:
+    PollBackoff(unsigned min_ms, unsigned max_ms, unsigned locked_ms)
+        : min_ms_(min_ms), max_ms_(max_ms), locked_ms_(locked_ms), interval_ms_(min_ms) {}
+
+    // Something changed or the user is active: poll fast again
+    void reset() {
+        interval_ms_ = min_ms_;
+    }
+
+    // Delay before the next poll
+    unsigned next(bool locked) {
+        if (locked) {
+            return locked_ms_;
+        }
+        unsigned delay = interval_ms_;
+        interval_ms_ = std::min(max_ms_, interval_ms_ * 2);
+        return delay;
+    }
+
+private:
+    unsigned min_ms_;
+    unsigned max_ms_;
+    unsigned locked_ms_;
+    unsigned interval_ms_;
+};
+
+#endif // POLL_BACKOFF_HPP
@@ -0,0 +1,155 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "regex_search.hpp"
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <utility>
+
+// Most recently used compiled queries, newest first
+static std::list<std::pair<std::string, std::shared_ptr<const RegexQuery>>> query_cache;
+static std::mutex query_cache_mutex;
+
+static char ascii_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Next occurrence of c at or after from, or npos
+static size_t find_byte(const std::string& text, char c, size_t from, size_t last) {
+    if (from > last) {
+        return std::string::npos;
+    }
+    const void* hit = memchr(text.data() + from, c, last - from + 1);
+    return hit ? static_cast<const char*>(hit) - text.data() : std::string::npos;
+}
+
+// ASCII case-insensitive substring test against a lowercase needle
+static bool contains_lowercase(const std::string& text, const std::string& needle) {
+    if (needle.size() > text.size()) {
+        return false;
+    }
+
+    const char first = needle[0];
+    const char first_upper = (first >= 'a' && first <= 'z') ? static_cast<char>(first - 'a' + 'A') : first;
+    const size_t last = text.size() - needle.size();
+
+    // Walk the candidates for both cases of the first byte with memchr
+    size_t next_lower = find_byte(text, first, 0, last);
+    size_t next_upper = first_upper != first ? find_byte(text, first_upper, 0, last) : std::string::npos;
+
+    while (true) {
+        size_t i = std::min(next_lower, next_upper);
+        if (i == std::string::npos) {
+            return false;
+        }
+
+        size_t j = 1;
+        while (j < needle.size() && ascii_lower(text[i + j]) == needle[j]) {
+            ++j;
+        }
+        if (j == needle.size()) {
+            return true;
+        }
+
+        if (i == next_lower) {
+            next_lower = find_byte(text, first, i + 1, last);
+        } else {
+            next_upper = find_byte(text, first_upper, i + 1, last);
+        }
+    }
+}
+
+static bool is_ascii(const std::string& text) {
+    for (char c : text) {
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+RegexQuery::RegexQuery() : filter_(MIN_ATOM_LENGTH) {
+}
+
+std::shared_ptr<const RegexQuery> RegexQuery::compile(const std::string& pattern, std::string* error) {
+    std::lock_guard<std::mutex> lock(query_cache_mutex);
+
+    // Reuse a cached query and move it to the front
+    for (auto it = query_cache.begin(); it != query_cache.end(); ++it) {
+        if (it->first == pattern) {
+            query_cache.splice(query_cache.begin(), query_cache, it);
+            return it->second;
+        }
+    }
+
+    std::shared_ptr<RegexQuery> query(new RegexQuery());
+
+    RE2::Options options;
+    options.set_log_errors(false);
+    int id = 0;
+    RE2::ErrorCode code = query->filter_.Add(pattern, options, &id);
+    if (code != RE2::NoError) {
+        if (error) {
+            RE2 failed(pattern, options);
+            *error = failed.error();
+        }
+        return nullptr;
+    }
+    query->filter_.Compile(&query->atoms_);
+
+    query_cache.emplace_front(pattern, query);
+    if (query_cache.size() > CACHE_SIZE) {
+        query_cache.pop_back();
+    }
+    return query;
+}
+
+bool RegexQuery::matches(const std::string& text, const std::string* folded) const {
+    // Collect the required literals present in the text
+    std::vector<int> found;
+    for (size_t i = 0; i < atoms_.size(); ++i) {
+        const std::string& atom = atoms_[i];
+
+        // Non-ASCII literals are lowercased with Unicode rules we do not
+        // replicate here, so never let them reject a candidate. ASCII runs
+        // survive folding, so the folded text can be searched directly.
+        bool present;
+        if (!is_ascii(atom)) {
+            present = true;
+        } else if (folded) {
+            present = folded->find(atom) != std::string::npos;
+        } else {
+            present = contains_lowercase(text, atom);
+        }
+
+        if (present) {
+            found.push_back(static_cast<int>(i));
+        }
+    }
+
+    // A filtered pattern needs at least one of its literals
+    if (!atoms_.empty() && found.empty()) {
+        return false;
+    }
+
+    // Runs the automaton only if the literal requirements are met
+    return filter_.FirstMatch(text, found) >= 0;
+}
+
+bool RegexQuery::may_match(const char* folded, size_t size) const {
+    if (atoms_.empty()) {
+        return true;
+    }
+
+    const char* end = folded + size;
+    for (const std::string& atom : atoms_) {
+        // Same rules as matches(): non-ASCII literals never reject
+        if (!is_ascii(atom) || std::search(folded, end, atom.begin(), atom.end()) != end) {
+            return true;
+        }
+    }
+    return false;
+}
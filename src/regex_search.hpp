@@ -0,0 +1,47 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef REGEX_SEARCH_HPP
+#define REGEX_SEARCH_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <re2/filtered_re2.h>
+
+// Regular expression compiled with RE2 (linear-time automaton matching).
+// Literals the pattern requires are extracted at compile time and checked
+// with a plain substring scan before the automaton runs.
+class RegexQuery {
+public:
+    // Compile a pattern, reusing a cached query for the same string.
+    // Returns nullptr and fills error if the pattern is invalid.
+    static std::shared_ptr<const RegexQuery> compile(const std::string& pattern, std::string* error = nullptr);
+
+    // Whether the pattern matches anywhere in text.
+    // folded, if given, is the entry's search text and speeds up the prefilter.
+    bool matches(const std::string& text, const std::string* folded = nullptr) const;
+
+    // Whether a text with this search text can match at all. Only checks
+    // the required literals, so callers can skip loading texts that fail.
+    bool may_match(const char* folded, size_t size) const;
+
+    RegexQuery(const RegexQuery&) = delete;
+    RegexQuery& operator=(const RegexQuery&) = delete;
+
+private:
+    // Number of compiled queries kept for reuse
+    static const size_t CACHE_SIZE = 16;
+
+    // Shortest literal worth prefiltering on
+    static const int MIN_ATOM_LENGTH = 3;
+
+    RegexQuery();
+
+    re2::FilteredRE2 filter_;
+    std::vector<std::string> atoms_;   // Lowercased required literals
+};
+
+#endif // REGEX_SEARCH_HPP
@@ -0,0 +1,71 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "screen_lock.hpp"
+
+static const char* const SCREEN_SAVER_INTERFACES[] = {
+    "org.freedesktop.ScreenSaver",
+    "org.gnome.ScreenSaver",
+};
+
+ScreenLockWatch::~ScreenLockWatch() {
+    stop();
+}
+
+bool ScreenLockWatch::start(std::function<void(bool locked)> on_changed) {
+    stop();
+
+    connection_ = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+    if (!connection_) {
+        return false;
+    }
+    on_changed_ = std::move(on_changed);
+
+    for (size_t i = 0; i < G_N_ELEMENTS(SCREEN_SAVER_INTERFACES); ++i) {
+        subscriptions_[i] = g_dbus_connection_signal_subscribe(
+            connection_, nullptr, SCREEN_SAVER_INTERFACES[i], "ActiveChanged", nullptr, nullptr,
+            G_DBUS_SIGNAL_FLAGS_NONE, on_active_changed, this, nullptr);
+    }
+    return true;
+}
+
+void ScreenLockWatch::stop() {
+    if (!connection_) {
+        return;
+    }
+    for (guint& subscription : subscriptions_) {
+        if (subscription != 0) {
+            g_dbus_connection_signal_unsubscribe(connection_, subscription);
+            subscription = 0;
+        }
+    }
+    g_object_unref(connection_);
+    connection_ = nullptr;
+    on_changed_ = nullptr;
+    locked_ = false;
+}
+
+bool ScreenLockWatch::is_locked() const {
+    return locked_;
+}
+
+void ScreenLockWatch::on_active_changed(GDBusConnection* connection G_GNUC_UNUSED, const gchar* sender G_GNUC_UNUSED,
+                                        const gchar* path G_GNUC_UNUSED, const gchar* interface G_GNUC_UNUSED,
+                                        const gchar* signal G_GNUC_UNUSED, GVariant* parameters,
+                                        gpointer user_data) {
+    ScreenLockWatch* self = static_cast<ScreenLockWatch*>(user_data);
+    if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE("(b)"))) {
+        return;
+    }
+
+    gboolean active = FALSE;
+    g_variant_get(parameters, "(b)", &active);
+    if (static_cast<bool>(active) == self->locked_) {
+        return;
+    }
+    self->locked_ = active;
+    if (self->on_changed_) {
+        self->on_changed_(self->locked_);
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef SCREEN_LOCK_HPP
+#define SCREEN_LOCK_HPP
+
+#include <gio/gio.h>
+#include <functional>
+
+// Follows the screen locker through the ActiveChanged signal of
+// org.freedesktop.ScreenSaver (KDE, Xfce, ...) and org.gnome.ScreenSaver on
+// the session bus. Nothing is called on the bus, so a desktop without a
+// screen saver service costs only the subscription.
+class ScreenLockWatch {
+public:
+    ScreenLockWatch() = default;
+    ~ScreenLockWatch();
+
+    ScreenLockWatch(const ScreenLockWatch&) = delete;
+    ScreenLockWatch& operator=(const ScreenLockWatch&) = delete;
+
+    // Subscribe; on_changed runs on the main context of the calling thread.
+    // False if there is no session bus.
+    bool start(std::function<void(bool locked)> on_changed);
+    void stop();
+
+    // Last state announced (unlocked until the first signal)
+    bool is_locked() const;
+
+private:
+    static void on_active_changed(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                  const gchar* interface, const gchar* signal, GVariant* parameters,
+                                  gpointer user_data);
+
+    GDBusConnection* connection_ = nullptr;
+    guint subscriptions_[2] = {0, 0};
+    bool locked_ = false;
+    std::function<void(bool locked)> on_changed_;
+};
+
+#endif // SCREEN_LOCK_HPP
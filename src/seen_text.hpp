@@ -0,0 +1,65 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef SEEN_TEXT_HPP
+#define SEEN_TEXT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "text_hash.hpp"
+
+// The last text of a selection, kept only to tell whether the next one is
+// the same. Small texts are shared with the entry holding them; of large
+// ones only the size and hash are kept, so their buffer is freed as soon as
+// the entry compresses it.
+class SeenText {
+public:
+    // Texts this large are remembered by hash (the size from which the front
+    // entry is kept compressed)
+    static const size_t HASH_MIN_SIZE = 64 * 1024;
+
+    void remember(const std::shared_ptr<const std::string>& text) {
+        reset();
+        if (!text) {
+            return;
+        }
+        if (text->size() < HASH_MIN_SIZE) {
+            text_ = text;
+            return;
+        }
+        hashed_ = true;
+        size_ = text->size();
+        hash_ = hash_text(*text);
+    }
+
+    void reset() {
+        text_.reset();
+        hashed_ = false;
+        size_ = 0;
+        hash_ = 0;
+    }
+
+    bool matches(const std::string& text) const {
+        if (hashed_) {
+            return text.size() == size_ && hash_text(text) == hash_;
+        }
+        return text_ && *text_ == text;
+    }
+
+    bool matches(const std::shared_ptr<const std::string>& text) const {
+        return text && (text == text_ || matches(*text));
+    }
+
+private:
+    std::shared_ptr<const std::string> text_;
+    bool hashed_ = false;
+    size_t size_ = 0;
+    uint64_t hash_ = 0;
+};
+
+#endif // SEEN_TEXT_HPP
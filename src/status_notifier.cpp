@@ -0,0 +1,551 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "status_notifier.hpp"
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+static const char* const ITEM_PATH = "/StatusNotifierItem";
+static const char* const MENU_PATH = "/MenuBar";
+static const char* const ITEM_INTERFACE = "org.kde.StatusNotifierItem";
+static const char* const MENU_INTERFACE = "com.canonical.dbusmenu";
+static const char* const WATCHER_NAME = "org.kde.StatusNotifierWatcher";
+
+static const char* const INTROSPECTION_XML =
+    "<node>"
+    "  <interface name='org.kde.StatusNotifierItem'>"
+    "    <property name='Category' type='s' access='read'/>"
+    "    <property name='Id' type='s' access='read'/>"
+    "    <property name='Title' type='s' access='read'/>"
+    "    <property name='Status' type='s' access='read'/>"
+    "    <property name='WindowId' type='i' access='read'/>"
+    "    <property name='IconName' type='s' access='read'/>"
+    "    <property name='IconThemePath' type='s' access='read'/>"
+    "    <property name='OverlayIconName' type='s' access='read'/>"
+    "    <property name='AttentionIconName' type='s' access='read'/>"
+    "    <property name='ToolTip' type='(sa(iiay)ss)' access='read'/>"
+    "    <property name='ItemIsMenu' type='b' access='read'/>"
+    "    <property name='Menu' type='o' access='read'/>"
+    "    <method name='ContextMenu'><arg name='x' type='i' direction='in'/><arg name='y' type='i' direction='in'/></method>"
+    "    <method name='Activate'><arg name='x' type='i' direction='in'/><arg name='y' type='i' direction='in'/></method>"
+    "    <method name='SecondaryActivate'><arg name='x' type='i' direction='in'/><arg name='y' type='i' direction='in'/></method>"
+    "    <method name='Scroll'><arg name='delta' type='i' direction='in'/><arg name='orientation' type='s' direction='in'/></method>"
+    "    <signal name='NewTitle'/>"
+    "    <signal name='NewIcon'/>"
+    "    <signal name='NewToolTip'/>"
+    "    <signal name='NewStatus'><arg name='status' type='s'/></signal>"
+    "  </interface>"
+    "  <interface name='com.canonical.dbusmenu'>"
+    "    <property name='Version' type='u' access='read'/>"
+    "    <property name='TextDirection' type='s' access='read'/>"
+    "    <property name='Status' type='s' access='read'/>"
+    "    <property name='IconThemePath' type='as' access='read'/>"
+    "    <method name='GetLayout'>"
+    "      <arg name='parentId' type='i' direction='in'/>"
+    "      <arg name='recursionDepth' type='i' direction='in'/>"
+    "      <arg name='propertyNames' type='as' direction='in'/>"
+    "      <arg name='revision' type='u' direction='out'/>"
+    "      <arg name='layout' type='(ia{sv}av)' direction='out'/>"
+    "    </method>"
+    "    <method name='GetGroupProperties'>"
+    "      <arg name='ids' type='ai' direction='in'/>"
+    "      <arg name='propertyNames' type='as' direction='in'/>"
+    "      <arg name='properties' type='a(ia{sv})' direction='out'/>"
+    "    </method>"
+    "    <method name='GetProperty'>"
+    "      <arg name='id' type='i' direction='in'/>"
+    "      <arg name='name' type='s' direction='in'/>"
+    "      <arg name='value' type='v' direction='out'/>"
+    "    </method>"
+    "    <method name='Event'>"
+    "      <arg name='id' type='i' direction='in'/>"
+    "      <arg name='eventId' type='s' direction='in'/>"
+    "      <arg name='data' type='v' direction='in'/>"
+    "      <arg name='timestamp' type='u' direction='in'/>"
+    "    </method>"
+    "    <method name='EventGroup'>"
+    "      <arg name='events' type='a(isvu)' direction='in'/>"
+    "      <arg name='idErrors' type='ai' direction='out'/>"
+    "    </method>"
+    "    <method name='AboutToShow'>"
+    "      <arg name='id' type='i' direction='in'/>"
+    "      <arg name='needUpdate' type='b' direction='out'/>"
+    "    </method>"
+    "    <method name='AboutToShowGroup'>"
+    "      <arg name='ids' type='ai' direction='in'/>"
+    "      <arg name='updatesNeeded' type='ai' direction='out'/>"
+    "      <arg name='idErrors' type='ai' direction='out'/>"
+    "    </method>"
+    "    <signal name='ItemsPropertiesUpdated'>"
+    "      <arg name='updatedProps' type='a(ia{sv})'/>"
+    "      <arg name='removedProps' type='a(ias)'/>"
+    "    </signal>"
+    "    <signal name='LayoutUpdated'>"
+    "      <arg name='revision' type='u'/>"
+    "      <arg name='parent' type='i'/>"
+    "    </signal>"
+    "    <signal name='ItemActivationRequested'>"
+    "      <arg name='id' type='i'/>"
+    "      <arg name='timestamp' type='u'/>"
+    "    </signal>"
+    "  </interface>"
+    "</node>";
+
+// dbusmenu properties of an item; a property at its default value is left out
+static const char* const ITEM_PROPERTIES[] = {"type", "label", "icon-name", "enabled"};
+
+static GVariant* item_property(const TrayMenuItem& item, const char* name) {
+    if (strcmp(name, "type") == 0) {
+        return item.separator ? g_variant_new_string("separator") : nullptr;
+    }
+    if (item.separator) {
+        return nullptr;
+    }
+    if (strcmp(name, "label") == 0) {
+        return g_variant_new_string(item.label.c_str());
+    }
+    if (strcmp(name, "icon-name") == 0) {
+        return item.icon_name.empty() ? nullptr : g_variant_new_string(item.icon_name.c_str());
+    }
+    if (strcmp(name, "enabled") == 0) {
+        return item.enabled ? nullptr : g_variant_new_boolean(FALSE);
+    }
+    return nullptr;
+}
+
+// Whether a property was asked for (an empty list asks for all of them)
+static bool property_wanted(GVariant* names, const char* name) {
+    if (!names || g_variant_n_children(names) == 0) {
+        return true;
+    }
+    for (gsize i = 0; i < g_variant_n_children(names); ++i) {
+        const char* wanted = nullptr;
+        g_variant_get_child(names, i, "&s", &wanted);
+        if (strcmp(wanted, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void add_item_properties(GVariantBuilder* builder, const TrayMenuItem& item, GVariant* names) {
+    for (const char* name : ITEM_PROPERTIES) {
+        if (!property_wanted(names, name)) {
+            continue;
+        }
+        if (GVariant* value = item_property(item, name)) {
+            g_variant_builder_add(builder, "{sv}", name, value);
+        }
+    }
+}
+
+static GVariant* item_layout(const TrayMenuItem& item, GVariant* names) {
+    GVariantBuilder properties;
+    g_variant_builder_init(&properties, G_VARIANT_TYPE("a{sv}"));
+    add_item_properties(&properties, item, names);
+
+    GVariantBuilder children;
+    g_variant_builder_init(&children, G_VARIANT_TYPE("av"));
+    return g_variant_new("(ia{sv}av)", item.id, &properties, &children);
+}
+
+StatusNotifier::StatusNotifier(std::string id, std::string title, std::string icon_name)
+    : id_(std::move(id)), title_(std::move(title)), icon_name_(std::move(icon_name)) {
+}
+
+StatusNotifier::~StatusNotifier() {
+    stop();
+}
+
+bool StatusNotifier::start() {
+    if (connection_) {
+        return true;
+    }
+
+    GError* error = nullptr;
+    connection_ = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, &error);
+    if (!connection_) {
+        std::cerr << "Tray: no session bus: " << error->message << std::endl;
+        g_error_free(error);
+        return false;
+    }
+
+    node_info_ = g_dbus_node_info_new_for_xml(INTROSPECTION_XML, nullptr);
+
+    static const GDBusInterfaceVTable item_vtable = {on_item_method, on_item_property, nullptr, {nullptr}};
+    static const GDBusInterfaceVTable menu_vtable = {on_menu_method, on_menu_property, nullptr, {nullptr}};
+    item_registration_ = g_dbus_connection_register_object(
+        connection_, ITEM_PATH, g_dbus_node_info_lookup_interface(node_info_, ITEM_INTERFACE),
+        &item_vtable, this, nullptr, &error);
+    if (item_registration_ != 0) {
+        menu_registration_ = g_dbus_connection_register_object(
+            connection_, MENU_PATH, g_dbus_node_info_lookup_interface(node_info_, MENU_INTERFACE),
+            &menu_vtable, this, nullptr, &error);
+    }
+    if (menu_registration_ == 0) {
+        std::cerr << "Tray: cannot export objects: " << error->message << std::endl;
+        g_error_free(error);
+        stop();
+        return false;
+    }
+
+    // One item per process, named the way watchers expect
+    bus_name_ = "org.kde.StatusNotifierItem-" + std::to_string(getpid()) + "-1";
+    name_owner_ = g_bus_own_name_on_connection(connection_, bus_name_.c_str(), G_BUS_NAME_OWNER_FLAGS_NONE,
+                                               nullptr, nullptr, nullptr, nullptr);
+
+    // Register now if a panel is running, and again each time one starts
+    watcher_watch_ = g_bus_watch_name_on_connection(connection_, WATCHER_NAME, G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                    on_watcher_appeared, nullptr, this, nullptr);
+    return true;
+}
+
+void StatusNotifier::stop() {
+    if (watcher_watch_ != 0) {
+        g_bus_unwatch_name(watcher_watch_);
+        watcher_watch_ = 0;
+    }
+    if (name_owner_ != 0) {
+        g_bus_unown_name(name_owner_);
+        name_owner_ = 0;
+    }
+    if (menu_registration_ != 0) {
+        g_dbus_connection_unregister_object(connection_, menu_registration_);
+        menu_registration_ = 0;
+    }
+    if (item_registration_ != 0) {
+        g_dbus_connection_unregister_object(connection_, item_registration_);
+        item_registration_ = 0;
+    }
+    if (node_info_) {
+        g_dbus_node_info_unref(node_info_);
+        node_info_ = nullptr;
+    }
+    if (connection_) {
+        g_object_unref(connection_);
+        connection_ = nullptr;
+    }
+    bus_name_.clear();
+}
+
+void StatusNotifier::set_items(std::vector<TrayMenuItem> items) {
+    bool layout_changed = items.size() != items_.size();
+    for (size_t i = 0; i < items.size() && !layout_changed; ++i) {
+        layout_changed = items[i].id != items_[i].id;
+    }
+
+    // Items came, went or moved: the host fetches the layout again
+    if (layout_changed) {
+        items_ = std::move(items);
+        revision_++;
+        if (connection_) {
+            g_dbus_connection_emit_signal(connection_, nullptr, MENU_PATH, MENU_INTERFACE, "LayoutUpdated",
+                                          g_variant_new("(ui)", revision_, 0), nullptr);
+        }
+        return;
+    }
+
+    // Same items: send only the properties that changed
+    GVariantBuilder updated;
+    GVariantBuilder removed;
+    g_variant_builder_init(&updated, G_VARIANT_TYPE("a(ia{sv})"));
+    g_variant_builder_init(&removed, G_VARIANT_TYPE("a(ias)"));
+    bool changed = false;
+    for (size_t i = 0; i < items.size(); ++i) {
+        GVariantBuilder item_updated;
+        GVariantBuilder item_removed;
+        g_variant_builder_init(&item_updated, G_VARIANT_TYPE("a{sv}"));
+        g_variant_builder_init(&item_removed, G_VARIANT_TYPE("as"));
+        size_t updated_count = 0;
+        size_t removed_count = 0;
+
+        for (const char* name : ITEM_PROPERTIES) {
+            GVariant* before = item_property(items_[i], name);
+            GVariant* after = item_property(items[i], name);
+            if (before) {
+                g_variant_ref_sink(before);
+            }
+            if (after) {
+                g_variant_ref_sink(after);
+            }
+
+            if (after && (!before || !g_variant_equal(before, after))) {
+                g_variant_builder_add(&item_updated, "{sv}", name, after);
+                updated_count++;
+            } else if (before && !after) {
+                g_variant_builder_add(&item_removed, "s", name);
+                removed_count++;
+            }
+
+            if (before) {
+                g_variant_unref(before);
+            }
+            if (after) {
+                g_variant_unref(after);
+            }
+        }
+
+        if (updated_count > 0) {
+            g_variant_builder_add(&updated, "(ia{sv})", items[i].id, &item_updated);
+        } else {
+            g_variant_builder_clear(&item_updated);
+        }
+        if (removed_count > 0) {
+            g_variant_builder_add(&removed, "(ias)", items[i].id, &item_removed);
+        } else {
+            g_variant_builder_clear(&item_removed);
+        }
+        changed = changed || updated_count > 0 || removed_count > 0;
+    }
+
+    items_ = std::move(items);
+    if (changed && connection_) {
+        g_dbus_connection_emit_signal(connection_, nullptr, MENU_PATH, MENU_INTERFACE, "ItemsPropertiesUpdated",
+                                      g_variant_new("(a(ia{sv})a(ias))", &updated, &removed), nullptr);
+    } else {
+        g_variant_builder_clear(&updated);
+        g_variant_builder_clear(&removed);
+    }
+}
+
+uint32_t StatusNotifier::get_revision() const {
+    return revision_;
+}
+
+const std::string& StatusNotifier::get_bus_name() const {
+    return bus_name_;
+}
+
+const TrayMenuItem* StatusNotifier::find_item(int32_t id) const {
+    for (const TrayMenuItem& item : items_) {
+        if (item.id == id) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
+
+GVariant* StatusNotifier::build_layout(int32_t parent_id, GVariant* property_names) const {
+    if (parent_id != 0) {
+        const TrayMenuItem* item = find_item(parent_id);
+        return item ? g_variant_new("(u@(ia{sv}av))", revision_, item_layout(*item, property_names)) : nullptr;
+    }
+
+    GVariantBuilder properties;
+    g_variant_builder_init(&properties, G_VARIANT_TYPE("a{sv}"));
+    if (property_wanted(property_names, "children-display")) {
+        g_variant_builder_add(&properties, "{sv}", "children-display", g_variant_new_string("submenu"));
+    }
+
+    GVariantBuilder children;
+    g_variant_builder_init(&children, G_VARIANT_TYPE("av"));
+    for (const TrayMenuItem& item : items_) {
+        g_variant_builder_add(&children, "v", item_layout(item, property_names));
+    }
+    return g_variant_new("(u(ia{sv}av))", revision_, 0, &properties, &children);
+}
+
+bool StatusNotifier::dispatch_event(int32_t id, const char* event_id) {
+    const TrayMenuItem* item = find_item(id);
+    if (!item) {
+        return false;
+    }
+    if (strcmp(event_id, "clicked") == 0 && item->enabled && !item->separator && on_item_clicked) {
+        on_item_clicked(id);
+    }
+    return true;
+}
+
+void StatusNotifier::on_item_method(GDBusConnection* connection G_GNUC_UNUSED, const gchar* sender G_GNUC_UNUSED,
+                                    const gchar* path G_GNUC_UNUSED, const gchar* interface G_GNUC_UNUSED,
+                                    const gchar* method, GVariant* parameters G_GNUC_UNUSED,
+                                    GDBusMethodInvocation* invocation, gpointer user_data) {
+    StatusNotifier* self = static_cast<StatusNotifier*>(user_data);
+
+    // ContextMenu and Scroll need nothing here; hosts show the exported menu
+    if ((strcmp(method, "Activate") == 0 || strcmp(method, "SecondaryActivate") == 0) && self->on_activate) {
+        self->on_activate();
+    }
+    g_dbus_method_invocation_return_value(invocation, nullptr);
+}
+
+GVariant* StatusNotifier::on_item_property(GDBusConnection* connection G_GNUC_UNUSED, const gchar* sender G_GNUC_UNUSED,
+                                           const gchar* path G_GNUC_UNUSED, const gchar* interface G_GNUC_UNUSED,
+                                           const gchar* property, GError** error G_GNUC_UNUSED, gpointer user_data) {
+    StatusNotifier* self = static_cast<StatusNotifier*>(user_data);
+
+    if (strcmp(property, "Category") == 0) {
+        return g_variant_new_string("ApplicationStatus");
+    }
+    if (strcmp(property, "Id") == 0) {
+        return g_variant_new_string(self->id_.c_str());
+    }
+    if (strcmp(property, "Title") == 0) {
+        return g_variant_new_string(self->title_.c_str());
+    }
+    if (strcmp(property, "Status") == 0) {
+        return g_variant_new_string("Active");
+    }
+    if (strcmp(property, "WindowId") == 0) {
+        return g_variant_new_int32(0);
+    }
+    if (strcmp(property, "IconName") == 0) {
+        return g_variant_new_string(self->icon_name_.c_str());
+    }
+    if (strcmp(property, "ToolTip") == 0) {
+        GVariantBuilder pixmaps;
+        g_variant_builder_init(&pixmaps, G_VARIANT_TYPE("a(iiay)"));
+        return g_variant_new("(sa(iiay)ss)", self->icon_name_.c_str(), &pixmaps, self->title_.c_str(), "");
+    }
+    if (strcmp(property, "ItemIsMenu") == 0) {
+        return g_variant_new_boolean(FALSE);
+    }
+    if (strcmp(property, "Menu") == 0) {
+        return g_variant_new_object_path(MENU_PATH);
+    }
+
+    // IconThemePath, OverlayIconName, AttentionIconName
+    return g_variant_new_string("");
+}
+
+void StatusNotifier::on_menu_method(GDBusConnection* connection G_GNUC_UNUSED, const gchar* sender G_GNUC_UNUSED,
+                                    const gchar* path G_GNUC_UNUSED, const gchar* interface G_GNUC_UNUSED,
+                                    const gchar* method, GVariant* parameters,
+                                    GDBusMethodInvocation* invocation, gpointer user_data) {
+    StatusNotifier* self = static_cast<StatusNotifier*>(user_data);
+
+    if (strcmp(method, "GetLayout") == 0) {
+        gint32 parent_id = 0;
+        gint32 depth = 0;
+        GVariant* names = nullptr;
+        g_variant_get(parameters, "(ii@as)", &parent_id, &depth, &names);
+        GVariant* layout = self->build_layout(parent_id, names);
+        g_variant_unref(names);
+        if (layout) {
+            g_dbus_method_invocation_return_value(invocation, layout);
+        } else {
+            g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                                                  "Unknown menu item %d", parent_id);
+        }
+    } else if (strcmp(method, "GetGroupProperties") == 0) {
+        GVariant* ids = nullptr;
+        GVariant* names = nullptr;
+        g_variant_get(parameters, "(@ai@as)", &ids, &names);
+
+        // An empty id list asks for every item
+        GVariantBuilder result;
+        g_variant_builder_init(&result, G_VARIANT_TYPE("a(ia{sv})"));
+        for (const TrayMenuItem& item : self->items_) {
+            bool wanted = g_variant_n_children(ids) == 0;
+            for (gsize i = 0; i < g_variant_n_children(ids) && !wanted; ++i) {
+                gint32 id = 0;
+                g_variant_get_child(ids, i, "i", &id);
+                wanted = id == item.id;
+            }
+            if (wanted) {
+                GVariantBuilder properties;
+                g_variant_builder_init(&properties, G_VARIANT_TYPE("a{sv}"));
+                add_item_properties(&properties, item, names);
+                g_variant_builder_add(&result, "(ia{sv})", item.id, &properties);
+            }
+        }
+        g_variant_unref(ids);
+        g_variant_unref(names);
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(a(ia{sv}))", &result));
+    } else if (strcmp(method, "GetProperty") == 0) {
+        gint32 id = 0;
+        const char* name = nullptr;
+        g_variant_get(parameters, "(i&s)", &id, &name);
+        const TrayMenuItem* item = self->find_item(id);
+        GVariant* value = item ? item_property(*item, name) : nullptr;
+        if (value) {
+            g_dbus_method_invocation_return_value(invocation, g_variant_new("(v)", value));
+        } else {
+            g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                                                  "No property %s on menu item %d", name, id);
+        }
+    } else if (strcmp(method, "Event") == 0) {
+        gint32 id = 0;
+        const char* event_id = nullptr;
+        GVariant* data = nullptr;
+        guint32 timestamp = 0;
+        g_variant_get(parameters, "(i&svu)", &id, &event_id, &data, &timestamp);
+        bool known = self->dispatch_event(id, event_id);
+        g_variant_unref(data);
+        if (known) {
+            g_dbus_method_invocation_return_value(invocation, nullptr);
+        } else {
+            g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                                                  "Unknown menu item %d", id);
+        }
+    } else if (strcmp(method, "EventGroup") == 0) {
+        GVariantIter* events = nullptr;
+        g_variant_get(parameters, "(a(isvu))", &events);
+
+        GVariantBuilder id_errors;
+        g_variant_builder_init(&id_errors, G_VARIANT_TYPE("ai"));
+        gint32 id = 0;
+        const char* event_id = nullptr;
+        GVariant* data = nullptr;
+        guint32 timestamp = 0;
+        while (g_variant_iter_loop(events, "(i&svu)", &id, &event_id, &data, &timestamp)) {
+            if (!self->dispatch_event(id, event_id)) {
+                g_variant_builder_add(&id_errors, "i", id);
+            }
+        }
+        g_variant_iter_free(events);
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(ai)", &id_errors));
+    } else if (strcmp(method, "AboutToShow") == 0) {
+        // The menu is always up to date
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(b)", FALSE));
+    } else if (strcmp(method, "AboutToShowGroup") == 0) {
+        GVariantBuilder updates;
+        GVariantBuilder id_errors;
+        g_variant_builder_init(&updates, G_VARIANT_TYPE("ai"));
+        g_variant_builder_init(&id_errors, G_VARIANT_TYPE("ai"));
+        g_dbus_method_invocation_return_value(invocation, g_variant_new("(aiai)", &updates, &id_errors));
+    } else {
+        g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+                                              "Unknown method %s", method);
+    }
+}
+
+GVariant* StatusNotifier::on_menu_property(GDBusConnection* connection G_GNUC_UNUSED, const gchar* sender G_GNUC_UNUSED,
+                                           const gchar* path G_GNUC_UNUSED, const gchar* interface G_GNUC_UNUSED,
+                                           const gchar* property, GError** error G_GNUC_UNUSED,
+                                           gpointer user_data G_GNUC_UNUSED) {
+    if (strcmp(property, "Version") == 0) {
+        return g_variant_new_uint32(3);
+    }
+    if (strcmp(property, "TextDirection") == 0) {
+        return g_variant_new_string("ltr");
+    }
+    if (strcmp(property, "Status") == 0) {
+        return g_variant_new_string("normal");
+    }
+
+    // IconThemePath
+    return g_variant_new_strv(nullptr, 0);
+}
+
+void StatusNotifier::on_watcher_appeared(GDBusConnection* connection, const gchar* name G_GNUC_UNUSED,
+                                         const gchar* owner G_GNUC_UNUSED, gpointer user_data) {
+    StatusNotifier* self = static_cast<StatusNotifier*>(user_data);
+
+    g_dbus_connection_call(connection, WATCHER_NAME, "/StatusNotifierWatcher", WATCHER_NAME,
+                           "RegisterStatusNotifierItem", g_variant_new("(s)", self->bus_name_.c_str()),
+                           nullptr, G_DBUS_CALL_FLAGS_NONE, -1, nullptr,
+                           +[](GObject* source, GAsyncResult* result, gpointer user_data G_GNUC_UNUSED) {
+                               GError* error = nullptr;
+                               GVariant* reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source),
+                                                                               result, &error);
+                               if (reply) {
+                                   g_variant_unref(reply);
+                               } else {
+                                   std::cerr << "Tray: registration failed: " << error->message << std::endl;
+                                   g_error_free(error);
+                               }
+                           }, nullptr);
+}
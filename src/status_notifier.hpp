@@ -0,0 +1,96 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef STATUS_NOTIFIER_HPP
+#define STATUS_NOTIFIER_HPP
+
+#include <gio/gio.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Tray icon over D-Bus: an org.kde.StatusNotifierItem with its menu exported
+// as com.canonical.dbusmenu. The menu is a flat list of items below the root.
+// set_items() compares the new list with the current one and only sends the
+// difference: LayoutUpdated when items are added, removed or reordered, and
+// ItemsPropertiesUpdated with just the changed properties of the items that
+// stay. The host fetches the layout again only in the first case.
+
+struct TrayMenuItem {
+    int32_t id = 0;           // Stable id (> 0) chosen by the caller
+    std::string label;
+    std::string icon_name;    // Empty for none
+    bool enabled = true;
+    bool separator = false;
+};
+
+class StatusNotifier {
+public:
+    StatusNotifier(std::string id, std::string title, std::string icon_name);
+    ~StatusNotifier();
+
+    StatusNotifier(const StatusNotifier&) = delete;
+    StatusNotifier& operator=(const StatusNotifier&) = delete;
+
+    // Export the item and its menu on the session bus and register with the
+    // StatusNotifierWatcher, again whenever a new watcher (panel) appears
+    bool start();
+    void stop();
+
+    // Replace the menu items, notifying the host of the difference
+    void set_items(std::vector<TrayMenuItem> items);
+
+    // Called on a click on the icon and on a chosen menu item
+    std::function<void()> on_activate;
+    std::function<void(int32_t id)> on_item_clicked;
+
+    // Layout revision, bumped on every LayoutUpdated
+    uint32_t get_revision() const;
+
+    // Well-known bus name of the item (empty until started)
+    const std::string& get_bus_name() const;
+
+private:
+    static void on_item_method(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                               const gchar* interface, const gchar* method, GVariant* parameters,
+                               GDBusMethodInvocation* invocation, gpointer user_data);
+    static GVariant* on_item_property(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                      const gchar* interface, const gchar* property, GError** error,
+                                      gpointer user_data);
+    static void on_menu_method(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                               const gchar* interface, const gchar* method, GVariant* parameters,
+                               GDBusMethodInvocation* invocation, gpointer user_data);
+    static GVariant* on_menu_property(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                                      const gchar* interface, const gchar* property, GError** error,
+                                      gpointer user_data);
+    static void on_watcher_appeared(GDBusConnection* connection, const gchar* name, const gchar* owner,
+                                    gpointer user_data);
+
+    // Layout of the root menu or of one item, as GetLayout returns it
+    GVariant* build_layout(int32_t parent_id, GVariant* property_names) const;
+
+    // Send an item event; false if no item has that id
+    bool dispatch_event(int32_t id, const char* event_id);
+
+    const TrayMenuItem* find_item(int32_t id) const;
+
+    std::string id_;
+    std::string title_;
+    std::string icon_name_;
+    std::string bus_name_;
+
+    std::vector<TrayMenuItem> items_;
+    uint32_t revision_ = 1;
+
+    GDBusConnection* connection_ = nullptr;
+    GDBusNodeInfo* node_info_ = nullptr;
+    guint item_registration_ = 0;
+    guint menu_registration_ = 0;
+    guint name_owner_ = 0;
+    guint watcher_watch_ = 0;
+};
+
+#endif // STATUS_NOTIFIER_HPP
@@ -0,0 +1,185 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "substring_search.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+// A kernel returns the position of the first occurrence of needle in
+// haystack at or after from, or size if there is none
+using SubstringKernel = size_t (*)(const char* haystack, size_t size, size_t from,
+                                   const char* needle, size_t length);
+
+// Confirm a candidate whose first and last bytes already matched
+static bool middle_matches(const char* candidate, const char* needle, size_t length) {
+    return length <= 2 || memcmp(candidate + 1, needle + 1, length - 2) == 0;
+}
+
+static size_t find_scalar(const char* haystack, size_t size, size_t from,
+                          const char* needle, size_t length) {
+    for (size_t i = from; i + length <= size; ++i) {
+        if (haystack[i] == needle[0] && haystack[i + length - 1] == needle[length - 1] &&
+            middle_matches(haystack + i, needle, length)) {
+            return i;
+        }
+    }
+    return size;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// Compare 16 (or 32) candidate positions at once against the first and the
+// last byte of the needle; only positions passing both get a memcmp.
+__attribute__((target("sse2")))
+static size_t find_sse2(const char* haystack, size_t size, size_t from,
+                        const char* needle, size_t length) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[length - 1]);
+    size_t i = from;
+
+    for (; i + length - 1 + 16 <= size; i += 16) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + length - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last))));
+
+        while (mask != 0) {
+            size_t bit = static_cast<size_t>(__builtin_ctz(mask));
+            if (middle_matches(haystack + i + bit, needle, length)) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return find_scalar(haystack, size, i, needle, length);
+}
+
+__attribute__((target("avx2")))
+static size_t find_avx2(const char* haystack, size_t size, size_t from,
+                        const char* needle, size_t length) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+    size_t i = from;
+
+    for (; i + length - 1 + 32 <= size; i += 32) {
+        __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+        __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + length - 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(block_first, first), _mm256_cmpeq_epi8(block_last, last))));
+
+        while (mask != 0) {
+            size_t bit = static_cast<size_t>(__builtin_ctz(mask));
+            if (middle_matches(haystack + i + bit, needle, length)) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return find_sse2(haystack, size, i, needle, length);
+}
+
+#endif // HAVE_X86_KERNELS
+
+struct KernelChoice {
+    SubstringKernel kernel;
+    const char* name;
+};
+
+// Pick the widest kernel the CPU supports, once
+static KernelChoice choose_kernel() {
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {find_avx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {find_sse2, "sse2"};
+    }
+#endif
+    return {find_scalar, "scalar"};
+}
+
+static const KernelChoice& kernel_choice() {
+    static const KernelChoice choice = choose_kernel();
+    return choice;
+}
+
+const char* substring_kernel_name() {
+    return kernel_choice().name;
+}
+
+void SearchCorpus::build(const std::vector<std::shared_ptr<ClipboardEntry>>& entries) {
+    clear();
+
+    std::vector<ClipboardText> texts;
+    texts.reserve(entries.size());
+    size_t total = 0;
+    for (const auto& entry : entries) {
+        texts.push_back(entry->get_search_text());
+        total += texts.back()->size() + 1;
+    }
+
+    buffer_.reserve(total);
+    offsets_.reserve(entries.size() + 1);
+    for (const auto& text : texts) {
+        offsets_.push_back(buffer_.size());
+        buffer_.append(*text);
+        buffer_.push_back('\0');
+    }
+    offsets_.push_back(buffer_.size());
+}
+
+void SearchCorpus::clear() {
+    std::string().swap(buffer_);
+    std::vector<size_t>().swap(offsets_);
+}
+
+size_t SearchCorpus::size() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+const char* SearchCorpus::search_text(size_t index, size_t& size) const {
+    size = offsets_[index + 1] - offsets_[index] - 1;
+    return buffer_.data() + offsets_[index];
+}
+
+void SearchCorpus::find(const std::string& needle, std::vector<size_t>& matches) const {
+    matches.clear();
+    if (offsets_.empty()) {
+        return;
+    }
+
+    // An empty query matches everything
+    if (needle.empty()) {
+        for (size_t i = 0; i < size(); ++i) {
+            matches.push_back(i);
+        }
+        return;
+    }
+
+    SubstringKernel kernel = kernel_choice().kernel;
+    const size_t total = buffer_.size();
+    size_t pos = 0;
+
+    while (pos < total) {
+        size_t hit = kernel(buffer_.data(), total, pos, needle.data(), needle.size());
+        if (hit >= total) {
+            break;
+        }
+
+        // Map the hit back to its entry and continue with the next entry;
+        // the separator never occurs in a query, so hits cannot straddle entries
+        auto next = std::upper_bound(offsets_.begin(), offsets_.end(), hit);
+        size_t index = static_cast<size_t>(next - offsets_.begin()) - 1;
+        matches.push_back(index);
+        pos = *next;
+    }
+}
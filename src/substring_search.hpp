@@ -0,0 +1,42 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef SUBSTRING_SEARCH_HPP
+#define SUBSTRING_SEARCH_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clipboard_entry.hpp"
+
+// Search texts of a history stream packed back to back in one buffer, so a
+// query is a single pass of the substring kernel over the whole history.
+class SearchCorpus {
+public:
+    // Pack the search texts of entries, in history order
+    void build(const std::vector<std::shared_ptr<ClipboardEntry>>& entries);
+
+    // Release the packed buffer
+    void clear();
+
+    // Indices of the entries whose search text contains needle, ascending
+    void find(const std::string& needle, std::vector<size_t>& matches) const;
+
+    // Number of packed entries
+    size_t size() const;
+
+    // Search text of the entry at index, as packed
+    const char* search_text(size_t index, size_t& size) const;
+
+private:
+    std::string buffer_;            // Texts separated by a NUL byte
+    std::vector<size_t> offsets_;   // Start of each text, plus the end of the last one
+};
+
+// Name of the kernel picked for this CPU ("avx2", "sse2" or "scalar")
+const char* substring_kernel_name();
+
+#endif // SUBSTRING_SEARCH_HPP
@@ -0,0 +1,30 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef TEXT_HASH_HPP
+#define TEXT_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// FNV-1a of a text, stable across builds so it can be stored in the archive
+// index. A text read in blocks hashes the same as a whole: pass the hash of
+// the blocks so far to continue from it.
+const uint64_t TEXT_HASH_SEED = 0xCBF29CE484222325ull;
+
+inline uint64_t hash_text(const char* data, size_t size, uint64_t hash = TEXT_HASH_SEED) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+inline uint64_t hash_text(const std::string& text) {
+    return hash_text(text.data(), text.size());
+}
+
+#endif // TEXT_HASH_HPP
@@ -0,0 +1,144 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Hierarchical timer wheel with one-tick resolution.
+// Four levels of 64 slots cover 64^4 ticks directly; later deadlines park in
+// the top level and are placed again each time their slot cascades. Scheduling is
+// O(1) and every timer is moved at most once per level before it fires.
+// Timers cannot be cancelled; owners check on expiry whether they still apply.
+template <typename T>
+class TimerWheel {
+public:
+    static const unsigned SLOT_BITS = 6;
+    static const size_t SLOTS = size_t(1) << SLOT_BITS;
+    static const size_t LEVELS = 4;
+
+    explicit TimerWheel(uint64_t now) : now_(now) {}
+
+    // Fire item at deadline (at the next tick if it already passed)
+    void schedule(T item, uint64_t deadline) {
+        if (deadline <= now_) {
+            deadline = now_ + 1;
+        }
+        place(Timer{std::move(item), deadline});
+        ++count_;
+    }
+
+    // Move the wheel to now, calling expire(item) for every timer that fired
+    template <typename F>
+    void advance(uint64_t now, F expire) {
+        while (now_ < now) {
+            // Jump over ticks where no slot comes up, e.g. after a suspend
+            uint64_t delay = next_delay();
+            if (delay == 0) {
+                now_ = now;
+                break;
+            }
+            now_ += std::min(delay - 1, now - now_);
+            if (now_ == now) {
+                break;
+            }
+
+            ++now_;
+
+            // Refill the lower levels whenever a level wraps around
+            for (size_t level = 1; level < LEVELS && digit(now_, level - 1) == 0; ++level) {
+                std::vector<Timer> cascading;
+                cascading.swap(slots_[level][digit(now_, level)]);
+                for (auto& timer : cascading) {
+                    place(std::move(timer));
+                }
+            }
+
+            std::vector<Timer> due;
+            due.swap(slots_[0][digit(now_, 0)]);
+            for (auto& timer : due) {
+                --count_;
+                expire(timer.item);
+            }
+        }
+    }
+
+    // Ticks until the next non-empty slot comes up; 0 if the wheel is empty.
+    // A slot above level 0 only cascades, so this is a lower bound for the
+    // next expiry and advance() needs to be called again at that point.
+    uint64_t next_delay() const {
+        if (count_ == 0) {
+            return 0;
+        }
+
+        uint64_t best = 0;
+        for (size_t level = 0; level < LEVELS; ++level) {
+            unsigned shift = SLOT_BITS * level;
+            size_t current = digit(now_, level);
+            uint64_t elapsed = now_ & ((uint64_t(1) << shift) - 1);
+
+            for (size_t offset = 1; offset < SLOTS; ++offset) {
+                if (!slots_[level][(current + offset) & (SLOTS - 1)].empty()) {
+                    uint64_t delay = (uint64_t(offset) << shift) - elapsed;
+                    if (best == 0 || delay < best) {
+                        best = delay;
+                    }
+                    break;
+                }
+            }
+        }
+        return best;
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    bool empty() const {
+        return count_ == 0;
+    }
+
+private:
+    struct Timer {
+        T item;
+        uint64_t deadline;
+    };
+
+    static size_t digit(uint64_t tick, size_t level) {
+        return static_cast<size_t>(tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+    }
+
+    // File a timer in the lowest level where its deadline shares all higher
+    // digits with the current tick; its slot then comes up before it is due.
+    // The top level is a ring, so it only needs the deadline within one turn.
+    void place(Timer timer) {
+        for (size_t level = 0; level + 1 < LEVELS; ++level) {
+            unsigned shift = SLOT_BITS * (level + 1);
+            if ((timer.deadline >> shift) == (now_ >> shift)) {
+                slots_[level][digit(timer.deadline, level)].push_back(std::move(timer));
+                return;
+            }
+        }
+
+        const unsigned top_shift = SLOT_BITS * (LEVELS - 1);
+        size_t slot = digit(timer.deadline, LEVELS - 1);
+        if ((timer.deadline >> top_shift) - (now_ >> top_shift) >= SLOTS) {
+            // Beyond the wheel: park in the last top slot to come up this turn
+            slot = (digit(now_, LEVELS - 1) + SLOTS - 1) & (SLOTS - 1);
+        }
+        slots_[LEVELS - 1][slot].push_back(std::move(timer));
+    }
+
+    std::vector<Timer> slots_[LEVELS][SLOTS];
+    uint64_t now_;
+    size_t count_ = 0;
+};
+
+#endif // TIMER_WHEEL_HPP
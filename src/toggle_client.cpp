@@ -0,0 +1,13 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+// vmcastle-toggle: bound to the global hotkey. Asks the running clipboard
+// manager to toggle its window and exits with 1 if none is running, so the
+// calling script can start one.
+
+#include "activation_socket.hpp"
+
+int main() {
+    return activation_send("toggle") ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "trace_replay.hpp"
+#include "capture_trace.hpp"
+#include "clipboard_manager.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+// Resident and peak resident set size in KiB, from /proc/self/status
+static void read_memory(long& resident_kib, long& peak_kib) {
+    resident_kib = 0;
+    peak_kib = 0;
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), status)) {
+        if (strncmp(line, "VmRSS:", 6) == 0) {
+            resident_kib = strtol(line + 6, nullptr, 10);
+        } else if (strncmp(line, "VmHWM:", 6) == 0) {
+            peak_kib = strtol(line + 6, nullptr, 10);
+        }
+    }
+    fclose(status);
+}
+
+// Upper bound of the latency below which a share p of the events fell
+static uint64_t latency_percentile_us(const CaptureStats& stats, double p) {
+    uint64_t total = 0;
+    for (uint64_t count : stats.latency_buckets) {
+        total += count;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += stats.latency_buckets[i];
+        if (total > 0 && seen >= p * total) {
+            return std::min(uint64_t(1) << i, stats.latency_max_us);
+        }
+    }
+    return stats.latency_max_us;
+}
+
+bool is_replay_command(int argc, char* argv[]) {
+    return argc > 1 && strcmp(argv[1], "--replay") == 0;
+}
+
+int run_replay_command(int argc, char* argv[]) {
+    std::string path;
+    double speed = 1.0;    // 0 = as fast as possible
+    bool valid = true;
+    for (int i = 2; i < argc && valid; ++i) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--speed=", 8) == 0) {
+            char* end = nullptr;
+            speed = strcmp(arg + 8, "max") == 0 ? 0.0 : strtod(arg + 8, &end);
+            valid = speed == 0.0 ? strcmp(arg + 8, "max") == 0 : (*end == '\0' && speed > 0.0);
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            valid = false;
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --replay [--speed=N|max] TRACE" << std::endl;
+        return 2;
+    }
+
+    CaptureTraceReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Cannot read " << path << ": " << reader.get_error() << std::endl;
+        return 1;
+    }
+
+    // Keep the replayed history away from the user's
+    char history_path[] = "/tmp/vmcastle-replay-XXXXXX";
+    int history_fd = mkstemp(history_path);
+    if (history_fd < 0) {
+        std::cerr << "Cannot create a temporary history file: " << strerror(errno) << std::endl;
+        return 1;
+    }
+    close(history_fd);
+
+    // The archive would outlive the temporary history
+    setenv("VMCASTLE_ARCHIVE_DAYS", "0", 1);
+
+    long resident_before = 0;
+    long peak_before = 0;
+    read_memory(resident_before, peak_before);
+
+    uint64_t events = 0;
+    uint64_t bytes = 0;
+    uint64_t synthesized = 0;
+    std::string error;
+    int status = 0;
+    {
+        ClipboardManager manager(history_path);
+        GMainLoop* loop = g_main_loop_new(nullptr, FALSE);
+        gint64 started = g_get_monotonic_time();
+
+        // The trace is fed from its own thread, like the capture thread; the
+        // main loop drains the ring and stores the batches
+        std::thread producer([&]() {
+            TraceRecord record;
+            while (reader.next(record)) {
+                if (speed > 0.0) {
+                    gint64 due = started + static_cast<gint64>(record.offset_us / speed);
+                    gint64 now = g_get_monotonic_time();
+                    if (due > now) {
+                        usleep(static_cast<useconds_t>(due - now));
+                    }
+                }
+
+                ClipboardText text;
+                if (record.has_payload) {
+                    text = std::make_shared<const std::string>(std::move(record.payload));
+                } else {
+                    text = std::make_shared<const std::string>(synthesize_payload(record.hash, record.size));
+                    synthesized++;
+                }
+                manager.inject_capture(record.selection, std::move(text));
+                events++;
+                bytes += record.size;
+            }
+            error = reader.get_error();
+            manager.finish_injection();
+
+            // Below the drain's priority, so it runs once the ring is empty
+            g_idle_add_full(G_PRIORITY_LOW, +[](gpointer user_data) -> gboolean {
+                g_main_loop_quit(static_cast<GMainLoop*>(user_data));
+                return G_SOURCE_REMOVE;
+            }, loop, nullptr);
+        });
+        g_main_loop_run(loop);
+        producer.join();
+        g_main_loop_unref(loop);
+
+        double seconds = (g_get_monotonic_time() - started) / 1e6;
+        CaptureStats stats = manager.get_capture_stats();
+        long resident_after = 0;
+        long peak_after = 0;
+        read_memory(resident_after, peak_after);
+
+        if (!error.empty()) {
+            std::cerr << "Trace ends early: " << error << std::endl;
+            status = 1;
+        }
+
+        char speed_text[32];
+        snprintf(speed_text, sizeof(speed_text), speed > 0.0 ? "%gx speed" : "max speed", speed);
+        printf("Replayed %llu events (%.1f MiB, %llu synthesized) in %.2f s at %s\n",
+               static_cast<unsigned long long>(events), bytes / (1024.0 * 1024.0),
+               static_cast<unsigned long long>(synthesized), seconds, speed_text);
+        printf("  ingest: %llu captured, %llu dropped, %llu coalesced, %llu batches\n",
+               static_cast<unsigned long long>(stats.captured), static_cast<unsigned long long>(stats.dropped),
+               static_cast<unsigned long long>(stats.coalesced), static_cast<unsigned long long>(stats.batches));
+        printf("  latency: p50 <= %llu us, p99 <= %llu us, max %llu us\n",
+               static_cast<unsigned long long>(latency_percentile_us(stats, 0.50)),
+               static_cast<unsigned long long>(latency_percentile_us(stats, 0.99)),
+               static_cast<unsigned long long>(stats.latency_max_us));
+        printf("  history: %zu clipboard, %zu primary entries\n",
+               manager.get_entry_count(Selection::CLIPBOARD), manager.get_entry_count(Selection::PRIMARY));
+        printf("  memory: RSS %ld KiB (%+ld KiB), peak %ld KiB\n",
+               resident_after, resident_after - resident_before, peak_after);
+    }
+
+    unlink(history_path);
+    return status;
+}
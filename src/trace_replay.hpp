@@ -0,0 +1,26 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef TRACE_REPLAY_HPP
+#define TRACE_REPLAY_HPP
+
+// Replay of a capture trace as a benchmark:
+//
+//   clipboard_manager --replay [--speed=N|max] TRACE
+//
+// Record a trace with VMCASTLE_RECORD_TRACE=FILE (and
+// VMCASTLE_RECORD_PAYLOADS=1 to keep the content). The events go through the
+// same ring, batching and store as live captures, at N times the recorded
+// pace (default 1) or as fast as possible. The history lives in a temporary
+// file, so the user's history is untouched. At the end the command reports
+// ingest latency, ring drops and memory use.
+
+// Whether argv asks for --replay
+bool is_replay_command(int argc, char* argv[]);
+
+// Parse the arguments and run the replay; returns the process exit status
+int run_replay_command(int argc, char* argv[]);
+
+#endif // TRACE_REPLAY_HPP
@@ -0,0 +1,205 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+ #include "entry_viewer.hpp"
+ #include "../entry_content.hpp"
+ #include "../line_index.hpp"
+ #include <algorithm>
+ #include <string>
+ 
+ // How often the line count is refreshed while the entry is being indexed
+ static const guint INDEX_POLL_MS = 100;
+ 
+ // List model over the display lines of an entry. Items are only created for
+ // the rows the list view asks for, so just the visible lines are read and laid out.
+ #define VIEWER_LINES_TYPE (viewer_lines_get_type())
+ G_DECLARE_FINAL_TYPE(ViewerLines, viewer_lines, VIEWER, LINES, GObject)
+ 
+ struct _ViewerLines {
+     GObject parent_instance;
+     
+     // Lines of the entry, indexed in the background
+     LineIndex* index;
+     size_t size;
+     
+     // Lines announced to the view so far
+     guint n_items;
+     
+     // Progress poll and the label it updates
+     guint poll_source;
+     GtkWidget* status_label;
+ };
+ 
+ static void viewer_lines_list_model_init(GListModelInterface* iface);
+ 
+ G_DEFINE_TYPE_WITH_CODE(ViewerLines, viewer_lines, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL, viewer_lines_list_model_init))
+ 
+ static void viewer_lines_finalize(GObject* object) {
+     ViewerLines* lines = VIEWER_LINES(object);
+     
+     if (lines->poll_source) {
+         g_source_remove(lines->poll_source);
+         lines->poll_source = 0;
+     }
+     
+     // Stops the indexer
+     delete lines->index;
+     lines->index = nullptr;
+     
+     // Chain up to parent
+     G_OBJECT_CLASS(viewer_lines_parent_class)->finalize(object);
+ }
+ 
+ static void viewer_lines_class_init(ViewerLinesClass* klass) {
+     GObjectClass* object_class = G_OBJECT_CLASS(klass);
+     object_class->finalize = viewer_lines_finalize;
+ }
+ 
+ static void viewer_lines_init(ViewerLines* lines) {
+     lines->index = nullptr;
+     lines->size = 0;
+     lines->n_items = 0;
+     lines->poll_source = 0;
+     lines->status_label = nullptr;
+ }
+ 
+ static GType viewer_lines_get_item_type(GListModel* model G_GNUC_UNUSED) {
+     return GTK_TYPE_STRING_OBJECT;
+ }
+ 
+ static guint viewer_lines_get_n_items(GListModel* model) {
+     return VIEWER_LINES(model)->n_items;
+ }
+ 
+ static gpointer viewer_lines_get_item(GListModel* model, guint position) {
+     ViewerLines* lines = VIEWER_LINES(model);
+     
+     std::string text;
+     if (position >= lines->n_items || !lines->index->get_line(position, text)) {
+         return nullptr;
+     }
+     return gtk_string_object_new(text.c_str());
+ }
+ 
+ static void viewer_lines_list_model_init(GListModelInterface* iface) {
+     iface->get_item_type = viewer_lines_get_item_type;
+     iface->get_n_items = viewer_lines_get_n_items;
+     iface->get_item = viewer_lines_get_item;
+ }
+ 
+ // Announce the lines indexed since the last call and update the status
+ static gboolean on_index_progress(gpointer user_data) {
+     ViewerLines* lines = VIEWER_LINES(user_data);
+     
+     // Read before the count, so the last lines are announced before stopping
+     bool complete = lines->index->is_complete();
+     guint count = (guint) std::min<size_t>(lines->index->get_line_count(), G_MAXUINT);
+     
+     if (count > lines->n_items) {
+         guint added = count - lines->n_items;
+         guint position = lines->n_items;
+         lines->n_items = count;
+         g_list_model_items_changed(G_LIST_MODEL(lines), position, 0, added);
+     }
+     
+     if (lines->status_label) {
+         gchar* size = g_format_size(lines->size);
+         std::string status = std::string(size) + (complete ? ", " : ", indexing… ") +
+                              std::to_string(count) + (complete ? " lines" : " lines so far");
+         gtk_label_set_text(GTK_LABEL(lines->status_label), status.c_str());
+         g_free(size);
+     }
+     
+     if (complete) {
+         lines->poll_source = 0;
+         return G_SOURCE_REMOVE;
+     }
+     return G_SOURCE_CONTINUE;
+ }
+ 
+ static void on_viewer_destroy(GtkWidget* widget G_GNUC_UNUSED, gpointer user_data) {
+     ViewerLines* lines = VIEWER_LINES(user_data);
+     
+     // The status label goes away with the window; the model may outlive it
+     if (lines->poll_source) {
+         g_source_remove(lines->poll_source);
+         lines->poll_source = 0;
+     }
+     lines->status_label = nullptr;
+ }
+ 
+ static void on_setup_line(GtkSignalListItemFactory* factory G_GNUC_UNUSED, GtkListItem* item,
+                           gpointer user_data G_GNUC_UNUSED) {
+     GtkWidget* label = gtk_label_new(nullptr);
+     gtk_label_set_xalign(GTK_LABEL(label), 0.0f);
+     gtk_label_set_single_line_mode(GTK_LABEL(label), TRUE);
+     gtk_list_item_set_child(item, label);
+ }
+ 
+ static void on_bind_line(GtkSignalListItemFactory* factory G_GNUC_UNUSED, GtkListItem* item,
+                          gpointer user_data G_GNUC_UNUSED) {
+     GtkWidget* label = gtk_list_item_get_child(item);
+     GtkStringObject* line = GTK_STRING_OBJECT(gtk_list_item_get_item(item));
+     gtk_label_set_text(GTK_LABEL(label), gtk_string_object_get_string(line));
+ }
+ 
+ void entry_viewer_open(GtkWindow* parent, std::shared_ptr<ClipboardEntry> entry) {
+     GtkWidget* window = gtk_window_new();
+     gtk_window_set_title(GTK_WINDOW(window), "Clipboard entry");
+     gtk_window_set_default_size(GTK_WINDOW(window), 800, 600);
+     gtk_window_set_transient_for(GTK_WINDOW(window), parent);
+     gtk_window_set_destroy_with_parent(GTK_WINDOW(window), TRUE);
+     
+     GtkWidget* box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+     gtk_widget_set_margin_start(box, 12);
+     gtk_widget_set_margin_end(box, 12);
+     gtk_widget_set_margin_top(box, 12);
+     gtk_widget_set_margin_bottom(box, 12);
+     gtk_window_set_child(GTK_WINDOW(window), box);
+     
+     GtkWidget* status_label = gtk_label_new(nullptr);
+     gtk_widget_set_halign(status_label, GTK_ALIGN_START);
+     gtk_widget_add_css_class(status_label, "dim-label");
+     gtk_box_append(GTK_BOX(box), status_label);
+     
+     // Binary payloads have no lines to show
+     if (entry->is_binary()) {
+         gchar* size = g_format_size(entry->get_size());
+         std::string status = std::string(size) + " of binary data";
+         gtk_label_set_text(GTK_LABEL(status_label), status.c_str());
+         g_free(size);
+         gtk_window_present(GTK_WINDOW(window));
+         return;
+     }
+     
+     // Index the lines in the background, reading the payload in place
+     ViewerLines* lines = VIEWER_LINES(g_object_new(VIEWER_LINES_TYPE, nullptr));
+     lines->index = new LineIndex(std::make_shared<const EntryContent>(*entry));
+     lines->size = entry->get_size();
+     lines->status_label = status_label;
+     lines->index->start();
+     if (on_index_progress(lines) == G_SOURCE_CONTINUE) {
+         lines->poll_source = g_timeout_add(INDEX_POLL_MS, on_index_progress, lines);
+     }
+     g_signal_connect(window, "destroy", G_CALLBACK(on_viewer_destroy), lines);
+     
+     // The list view only creates rows for the visible lines
+     GtkListItemFactory* factory = gtk_signal_list_item_factory_new();
+     g_signal_connect(factory, "setup", G_CALLBACK(on_setup_line), nullptr);
+     g_signal_connect(factory, "bind", G_CALLBACK(on_bind_line), nullptr);
+     
+     GtkNoSelection* selection = gtk_no_selection_new(G_LIST_MODEL(lines));
+     GtkWidget* list_view = gtk_list_view_new(GTK_SELECTION_MODEL(selection), factory);
+     gtk_widget_add_css_class(list_view, "monospace");
+     
+     GtkWidget* scrolled = gtk_scrolled_window_new();
+     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+     gtk_widget_set_vexpand(scrolled, TRUE);
+     gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(scrolled), list_view);
+     gtk_box_append(GTK_BOX(box), scrolled);
+     
+     gtk_window_present(GTK_WINDOW(window));
+ }
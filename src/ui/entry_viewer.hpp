@@ -0,0 +1,19 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef ENTRY_VIEWER_HPP
+#define ENTRY_VIEWER_HPP
+
+#include <gtk/gtk.h>
+#include <memory>
+#include "../clipboard_entry.hpp"
+
+// Open a window showing the whole content of an entry. Lines are indexed in
+// the background and only the visible ones are read and laid out, so even
+// entries of hundreds of megabytes open at once; the line count grows as
+// indexing proceeds.
+void entry_viewer_open(GtkWindow* parent, std::shared_ptr<ClipboardEntry> entry);
+
+#endif // ENTRY_VIEWER_HPP
@@ -4,8 +4,41 @@
 
 
  #include "main_window.hpp"
+ #include "entry_viewer.hpp"
  #include "../clipboard_manager.hpp"
+ #include "../history_search.hpp"
+ #include "../near_duplicate.hpp"
+ #include <cstdlib>
+ #include <cstdio>
+ #include <cstring>
  #include <iostream>
+ #include <malloc.h>
+ #include <unistd.h>
+ 
+ // Hotkey-to-first-frame budget (one frame at 60 Hz)
+ static const gint64 ACTIVATION_BUDGET_US = 16000;
+ 
+ // In low-memory mode, the widget tree is released after staying hidden this long
+ static const guint IDLE_RELEASE_DELAY_S = 30;
+ 
+ // Archived matches listed below the history matches of a search
+ static const size_t ARCHIVE_RESULTS = 20;
+ 
+ // A search with fewer history matches than this also searches the archive
+ // unasked; otherwise the archive is only searched on request
+ static const size_t ARCHIVE_AUTO_BELOW = 5;
+ 
+ // One archive search, run in a GTask thread
+ struct ArchiveSearch {
+     std::shared_ptr<ClipboardManager> manager;
+     guint generation;
+     std::string query;
+     SearchMode mode;
+     FacetMask facets;
+     ClipboardManager::HistorySnapshot history;
+     std::vector<std::shared_ptr<ClipboardEntry>> results;
+     bool complete = true;
+ };
  
  struct _MainWindow {
      GtkApplicationWindow parent_instance;
@@ -14,9 +47,49 @@
      GtkWidget* list_box;
      GtkWidget* search_entry;
      GtkWidget* clear_button;
+     GtkWidget* view_selector;
+     GtkWidget* type_selector;
+     GtkWidget* paste_selector;
+     GtkWidget* regex_toggle;
+     GtkWidget* group_toggle;
      
      // Data
      std::shared_ptr<ClipboardManager> clipboard_manager;
+     
+     // Registrations of the change callbacks of both streams
+     ClipboardManager::CallbackId changed_callbacks[2];
+     
+     // History stream currently shown
+     Selection selection;
+     
+     // Activation latency: request time of the pending show and its stats
+     gint64 show_requested_at;
+     gulong after_paint_handler;
+     guint activation_count;
+     guint activation_over_budget;
+     gint64 activation_max_us;
+     
+     // Idle mode: skip list rebuilds while hidden, and in low-memory mode
+     // release the widget tree until the next show
+     gboolean low_memory;
+     gboolean list_stale;
+     guint refresh_source;
+     guint release_source;
+     
+     // Search and filter controls while the widgets are released
+     gchar* saved_search;
+     guint saved_type;
+     gboolean saved_regex;
+     gboolean saved_group;
+     
+     // Archive search: one runs at a time, and the newest request waits
+     // behind it. Results for an older build of the list are dropped.
+     guint list_generation;
+     gboolean archive_running;
+     ArchiveSearch* archive_queued;
+     
+     // Search the user asked to extend into the archive
+     gchar* archive_requested;
  };
  
  G_DEFINE_TYPE(MainWindow, main_window, GTK_TYPE_APPLICATION_WINDOW)
@@ -28,14 +101,56 @@
  static void on_row_activated(GtkListBox* list_box, GtkListBoxRow* row, gpointer user_data);
  static void on_clear_clicked(GtkButton* button, gpointer user_data);
  static void on_search_changed(GtkSearchEntry* entry, gpointer user_data);
+ static FacetMask selected_facets(MainWindow* window);
+ static bool paste_entry(MainWindow* window, EntryId id);
  static void on_delete_entry(GtkButton* button, gpointer user_data);
+ static void on_pin_entry(GtkButton* button, gpointer user_data);
+ static void on_view_entry(GtkButton* button, gpointer user_data);
+ static void on_view_changed(GObject* selector, GParamSpec* pspec, gpointer user_data);
+ static void on_show(GtkWidget* widget, gpointer user_data);
+ static void on_hide(GtkWidget* widget, gpointer user_data);
+ static void start_archive_search(MainWindow* window, ArchiveSearch* search);
+ static void on_archive_search_done(GObject* source, GAsyncResult* result, gpointer user_data);
+ static void append_archive_rows(MainWindow* window, const ArchiveSearch& search);
  
  static void main_window_dispose(GObject* object) {
      MainWindow* window = MAIN_WINDOW(object);
      
+     // The manager may outlive us: stop its callbacks before we go
+     if (window->clipboard_manager) {
+         for (ClipboardManager::CallbackId id : window->changed_callbacks) {
+             window->clipboard_manager->unregister_callback(id);
+         }
+     }
+     
      // Clear clipboard manager reference
      window->clipboard_manager = nullptr;
      
+     // Stop timing a show that never painted
+     GdkFrameClock* clock = gtk_widget_get_frame_clock(GTK_WIDGET(window));
+     if (clock && window->after_paint_handler) {
+         g_signal_handler_disconnect(clock, window->after_paint_handler);
+     }
+     window->after_paint_handler = 0;
+     
+     // Drop pending idle work
+     if (window->refresh_source) {
+         g_source_remove(window->refresh_source);
+         window->refresh_source = 0;
+     }
+     if (window->release_source) {
+         g_source_remove(window->release_source);
+         window->release_source = 0;
+     }
+     
+     // A running archive search holds a reference to us and finds no manager
+     delete window->archive_queued;
+     window->archive_queued = nullptr;
+     g_free(window->archive_requested);
+     window->archive_requested = nullptr;
+     g_free(window->saved_search);
+     window->saved_search = nullptr;
+     
      // Chain up to parent
      G_OBJECT_CLASS(main_window_parent_class)->dispose(object);
  }
@@ -60,6 +175,10 @@
          gtk_widget_set_visible(GTK_WIDGET(window), FALSE);
          return TRUE;
      }), NULL);
+     
+     // Idle mode transitions
+     g_signal_connect(window, "show", G_CALLBACK(on_show), NULL);
+     g_signal_connect(window, "hide", G_CALLBACK(on_hide), NULL);
  }
  
  MainWindow* main_window_new(GtkApplication* app, std::shared_ptr<ClipboardManager> manager) {
@@ -69,6 +188,11 @@
      
      // Store clipboard manager
      window->clipboard_manager = manager;
+     window->selection = Selection::CLIPBOARD;
+     
+     // VMCASTLE_LOW_MEMORY=1 releases the widgets while the window is hidden
+     const char* low_memory = g_getenv("VMCASTLE_LOW_MEMORY");
+     window->low_memory = low_memory && strcmp(low_memory, "0") != 0;
      
      // Create UI
      create_ui(window);
@@ -79,13 +203,31 @@
      // Populate list
      populate_list(window);
      
-     // Register for clipboard changes
-     manager->register_callback([window]() {
-         g_idle_add(+[](gpointer user_data) -> gboolean {
-             main_window_refresh(MAIN_WINDOW(user_data));
-             return G_SOURCE_REMOVE;
-         }, window);
-     });
+     // Prewarm: create the surface and lay out the list while hidden, so the
+     // first show only has to map and paint
+     gtk_widget_realize(GTK_WIDGET(window));
+     
+     // Register for changes of both streams, rebuilding only for the one shown
+     for (Selection selection : {Selection::CLIPBOARD, Selection::PRIMARY}) {
+         ClipboardManager::CallbackId& callback = window->changed_callbacks[selection == Selection::PRIMARY];
+         callback = manager->register_callback([window, selection]() {
+             if (window->selection != selection || window->refresh_source) {
+                 return;
+             }
+             window->refresh_source = g_idle_add(+[](gpointer user_data) -> gboolean {
+                 MainWindow* window = MAIN_WINDOW(user_data);
+                 window->refresh_source = 0;
+                 
+                 // A hidden window is rebuilt when it is shown again
+                 if (!gtk_widget_get_visible(GTK_WIDGET(window))) {
+                     window->list_stale = TRUE;
+                 } else {
+                     main_window_refresh(window);
+                 }
+                 return G_SOURCE_REMOVE;
+             }, window);
+         }, selection);
+     }
      
      return window;
  }
@@ -94,12 +236,160 @@
      populate_list(window);
  }
  
+ void main_window_set_low_memory(MainWindow* window, gboolean enabled) {
+     window->low_memory = enabled;
+ }
+ 
+ // Resident set size in KiB, for the idle mode trace
+ static long resident_kib() {
+     long size = 0;
+     long pages = 0;
+     FILE* statm = fopen("/proc/self/statm", "r");
+     if (statm) {
+         if (fscanf(statm, "%ld %ld", &size, &pages) != 2) {
+             pages = 0;
+         }
+         fclose(statm);
+     }
+     return pages * (sysconf(_SC_PAGESIZE) / 1024);
+ }
+ 
+ static gboolean release_widgets(gpointer user_data) {
+     MainWindow* window = MAIN_WINDOW(user_data);
+     window->release_source = 0;
+     if (gtk_widget_get_visible(GTK_WIDGET(window)) || !window->list_box) {
+         return G_SOURCE_REMOVE;
+     }
+     
+     long before = resident_kib();
+     
+     // Keep what the controls show; the rebuilt ones start from it
+     g_free(window->saved_search);
+     window->saved_search = g_strdup(gtk_editable_get_text(GTK_EDITABLE(window->search_entry)));
+     window->saved_type = gtk_drop_down_get_selected(GTK_DROP_DOWN(window->type_selector));
+     window->saved_regex = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(window->regex_toggle));
+     window->saved_group = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(window->group_toggle));
+     
+     // Destroy the content; the window and its surface stay for a fast show
+     gtk_window_set_child(GTK_WINDOW(window), NULL);
+     window->list_box = NULL;
+     window->search_entry = NULL;
+     window->clear_button = NULL;
+     window->view_selector = NULL;
+     window->type_selector = NULL;
+     window->paste_selector = NULL;
+     window->regex_toggle = NULL;
+     window->group_toggle = NULL;
+     g_object_set_data(G_OBJECT(window), "recent-box", NULL);
+     
+     // Drop caches rebuilt on demand and hand freed pages back to the system
+     window->clipboard_manager->release_caches();
+     malloc_trim(0);
+     
+     if (g_getenv("VMCASTLE_TRACE_MEMORY")) {
+         std::cerr << "idle: released widgets, RSS " << before << " KiB -> " << resident_kib() << " KiB" << std::endl;
+     }
+     return G_SOURCE_REMOVE;
+ }
+ 
+ // Put the state saved by release_widgets back into fresh controls, before
+ // their signals are connected; the paste variant is a one-off and starts
+ // as is anyway
+ static void restore_controls(MainWindow* window) {
+     gtk_drop_down_set_selected(GTK_DROP_DOWN(window->view_selector), window->selection == Selection::PRIMARY ? 1 : 0);
+     gtk_drop_down_set_selected(GTK_DROP_DOWN(window->type_selector), window->saved_type);
+     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(window->regex_toggle), window->saved_regex);
+     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(window->group_toggle), window->saved_group);
+     if (window->saved_search) {
+         gtk_editable_set_text(GTK_EDITABLE(window->search_entry), window->saved_search);
+         g_free(window->saved_search);
+         window->saved_search = nullptr;
+     }
+ }
+ 
+ static void on_show(GtkWidget* widget, gpointer user_data G_GNUC_UNUSED) {
+     MainWindow* window = MAIN_WINDOW(widget);
+     if (window->release_source) {
+         g_source_remove(window->release_source);
+         window->release_source = 0;
+     }
+     if (!window->clipboard_manager) {
+         return;
+     }
+     
+     // Someone is about to copy or paste: let a polling capture catch up
+     window->clipboard_manager->note_user_activity();
+     
+     // Rebuild before the first frame: the whole tree if it was released,
+     // the list if entries changed while hidden
+     if (!window->list_box) {
+         gint64 started = g_get_monotonic_time();
+         create_ui(window);
+         restore_controls(window);
+         setup_signals(window);
+         populate_list(window);
+         window->list_stale = FALSE;
+         
+         if (g_getenv("VMCASTLE_TRACE_MEMORY")) {
+             std::cerr << "idle: rebuilt widgets in " << (g_get_monotonic_time() - started) / 1000.0
+                       << " ms, RSS " << resident_kib() << " KiB" << std::endl;
+         }
+     } else if (window->list_stale) {
+         populate_list(window);
+         window->list_stale = FALSE;
+     }
+ }
+ 
+ static void on_hide(GtkWidget* widget, gpointer user_data G_GNUC_UNUSED) {
+     MainWindow* window = MAIN_WINDOW(widget);
+     if (window->clipboard_manager) {
+         window->clipboard_manager->release_search_corpora();
+     }
+     if (window->low_memory && !window->release_source) {
+         window->release_source = g_timeout_add_seconds(IDLE_RELEASE_DELAY_S, release_widgets, window);
+     }
+ }
+ 
  void main_window_toggle_visibility(MainWindow* window) {
+     main_window_toggle_visibility_timed(window, g_get_monotonic_time());
+ }
+ 
+ static void on_after_paint(GdkFrameClock* clock, gpointer user_data) {
+     MainWindow* window = MAIN_WINDOW(user_data);
+     g_signal_handler_disconnect(clock, window->after_paint_handler);
+     window->after_paint_handler = 0;
+     
+     gint64 latency = g_get_monotonic_time() - window->show_requested_at;
+     window->activation_count++;
+     if (latency > ACTIVATION_BUDGET_US) {
+         window->activation_over_budget++;
+     }
+     if (latency > window->activation_max_us) {
+         window->activation_max_us = latency;
+     }
+     
+     if (g_getenv("VMCASTLE_TRACE_LATENCY")) {
+         std::cerr << "activation: " << latency / 1000.0 << " ms to first frame (max "
+                   << window->activation_max_us / 1000.0 << " ms, "
+                   << window->activation_over_budget << "/" << window->activation_count
+                   << " over budget)" << std::endl;
+     }
+ }
+ 
+ void main_window_toggle_visibility_timed(MainWindow* window, gint64 requested_at) {
      gboolean visible = gtk_widget_get_visible(GTK_WIDGET(window));
      gtk_widget_set_visible(GTK_WIDGET(window), !visible);
      
-     if (!visible) {
-         gtk_window_present(GTK_WINDOW(window));
+     if (visible) {
+         return;
+     }
+     gtk_window_present(GTK_WINDOW(window));
+     
+     // Time the show up to the end of the first frame painted after it
+     window->show_requested_at = requested_at;
+     GdkFrameClock* clock = gtk_widget_get_frame_clock(GTK_WIDGET(window));
+     if (clock && !window->after_paint_handler) {
+         window->after_paint_handler = g_signal_connect(clock, "after-paint", G_CALLBACK(on_after_paint), window);
      }
  }
  
@@ -117,7 +407,39 @@
      gtk_widget_set_hexpand(window->search_entry, TRUE);
      window->clear_button = gtk_button_new_with_label("Clear All");
      
+     // Selector between the clipboard and PRIMARY selection histories
+     const char* views[] = {"Clipboard", "Selection", NULL};
+     window->view_selector = gtk_drop_down_new_from_strings(views);
+     gtk_widget_set_tooltip_text(window->view_selector, "History to show");
+     
+     // Filter by the kind of content, alone or together with the search;
+     // item i > 0 is Facet i - 1
+     const char* types[] = {"All types", "URLs", "Paths", "Emails", "Numbers", "Colors", "JSON", "Code",
+                            "Multi-line", NULL};
+     window->type_selector = gtk_drop_down_new_from_strings(types);
+     gtk_widget_set_tooltip_text(window->type_selector, "Kind of content to show");
+     
+     // Paste a variant of the chosen entry instead of its stored text;
+     // item i > 0 is PasteTransform i - 1
+     const char* pastes[] = {"Paste as is", "Trimmed", "Single line", "Pretty JSON", "URL-decoded",
+                             "Base64-decoded", "UPPERCASE", "lowercase", NULL};
+     window->paste_selector = gtk_drop_down_new_from_strings(pastes);
+     gtk_widget_set_tooltip_text(window->paste_selector, "How to paste the chosen entry");
+     
+     // Toggle between plain and regular expression search
+     window->regex_toggle = gtk_toggle_button_new_with_label(".*");
+     gtk_widget_set_tooltip_text(window->regex_toggle, "Regular expression search");
+     
+     // Collapse variants of the same text into one row
+     window->group_toggle = gtk_toggle_button_new_with_label("≈");
+     gtk_widget_set_tooltip_text(window->group_toggle, "Group similar entries");
+     
      gtk_box_append(GTK_BOX(header_box), window->search_entry);
+     gtk_box_append(GTK_BOX(header_box), window->regex_toggle);
+     gtk_box_append(GTK_BOX(header_box), window->group_toggle);
+     gtk_box_append(GTK_BOX(header_box), window->type_selector);
+     gtk_box_append(GTK_BOX(header_box), window->view_selector);
+     gtk_box_append(GTK_BOX(header_box), window->paste_selector);
      gtk_box_append(GTK_BOX(header_box), window->clear_button);
      
      // Add quick access section with label
@@ -189,22 +511,88 @@
      // Search entry
      g_signal_connect(window->search_entry, "search-changed", 
                      G_CALLBACK(on_search_changed), window);
+     
+     // Search mode toggle
+     g_signal_connect(window->regex_toggle, "toggled",
+                     G_CALLBACK(+[](GtkToggleButton* toggle G_GNUC_UNUSED, gpointer user_data) {
+                         populate_list(MAIN_WINDOW(user_data));
+                     }), window);
+     
+     // Grouping of similar entries
+     g_signal_connect(window->group_toggle, "toggled",
+                     G_CALLBACK(+[](GtkToggleButton* toggle G_GNUC_UNUSED, gpointer user_data) {
+                         populate_list(MAIN_WINDOW(user_data));
+                     }), window);
+     
+     // History view selector
+     g_signal_connect(window->view_selector, "notify::selected",
+                     G_CALLBACK(on_view_changed), window);
+     
+     // Content type filter
+     g_signal_connect(window->type_selector, "notify::selected",
+                     G_CALLBACK(+[](GObject* selector G_GNUC_UNUSED, GParamSpec* pspec G_GNUC_UNUSED, gpointer user_data) {
+                         populate_list(MAIN_WINDOW(user_data));
+                     }), window);
+ }
+ 
+ static FacetMask selected_facets(MainWindow* window) {
+     guint selected = gtk_drop_down_get_selected(GTK_DROP_DOWN(window->type_selector));
+     if (selected == 0 || selected == GTK_INVALID_LIST_POSITION || selected > FACET_COUNT) {
+         return 0;
+     }
+     return facet_bit(static_cast<Facet>(selected - 1));
+ }
+ 
+ static bool paste_entry(MainWindow* window, EntryId id) {
+     guint selected = window->paste_selector ? gtk_drop_down_get_selected(GTK_DROP_DOWN(window->paste_selector)) : 0;
+     if (selected == 0 || selected == GTK_INVALID_LIST_POSITION || selected > PASTE_TRANSFORM_COUNT) {
+         return window->clipboard_manager->copy_to_clipboard(id);
+     }
+     
+     // A variant is a one-off; the next paste is as is again
+     if (!window->clipboard_manager->paste_transformed(id, {static_cast<PasteTransform>(selected - 1)})) {
+         return false;
+     }
+     gtk_drop_down_set_selected(GTK_DROP_DOWN(window->paste_selector), 0);
+     return true;
  }
  
  static void populate_list(MainWindow* window) {
-     // Remove existing rows
+     // Nothing to fill while the widgets are released
+     if (!window->list_box) {
+         window->list_stale = TRUE;
+         return;
+     }
+     
+     // Remove existing rows; archive results still on their way are for them
      GtkWidget* child;
      while ((child = gtk_widget_get_first_child(window->list_box)) != NULL) {
          gtk_list_box_remove(GTK_LIST_BOX(window->list_box), child);
      }
-     
-     // Get entries
-     auto entries = window->clipboard_manager->get_entries();
+     window->list_generation++;
      
      // Get search text
      const char* search_text = gtk_editable_get_text(GTK_EDITABLE(window->search_entry));
      std::string filter = search_text ? search_text : "";
      
+     // Get entries, and the ones matching the search text among them
+     std::vector<std::shared_ptr<ClipboardEntry>> entries;
+     std::vector<size_t> matches;
+     std::string error;
+     bool valid_filter = true;
+     SearchMode mode = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(window->regex_toggle))
+         ? SearchMode::REGEX : SearchMode::EXACT;
+     FacetMask facets = selected_facets(window);
+     if (!filter.empty() || facets != 0) {
+         valid_filter = window->clipboard_manager->search(filter, mode, window->selection, entries, matches, &error,
+                                                          facets);
+     } else {
+         entries = window->clipboard_manager->get_entries(window->selection);
+         for (size_t i = 0; i < entries.size(); ++i) {
+             matches.push_back(i);
+         }
+     }
+     
      // Update quick access buttons first
      GtkWidget* recent_box = GTK_WIDGET(g_object_get_data(G_OBJECT(window), "recent-box"));
      if (recent_box) {
@@ -235,13 +623,13 @@
                  
                  // Connect or update click handler
                  g_signal_handlers_disconnect_by_data(child_widget, window);
-                 g_object_set_data(G_OBJECT(child_widget), "entry-index", GINT_TO_POINTER(button_index));
+                 g_object_set_data(G_OBJECT(child_widget), "entry-id", GSIZE_TO_POINTER(entry->get_id()));
                  g_signal_connect(child_widget, "clicked", G_CALLBACK(+[](GtkButton* button, gpointer user_data) {
                      MainWindow* window = MAIN_WINDOW(user_data);
-                     gint index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(button), "entry-index"));
+                     EntryId id = GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(button), "entry-id"));
                      
                      // Copy to clipboard
-                     if (window->clipboard_manager->copy_to_clipboard(index)) {
+                     if (paste_entry(window, id)) {
                          // Hide window after copying
                          gtk_widget_set_visible(GTK_WIDGET(window), FALSE);
                      }
@@ -259,16 +647,44 @@
          }
      }
      
-     // Add entries to main list
-     for (size_t i = 0; i < entries.size(); ++i) {
-         const auto& entry = entries[i];
-         
-         // Apply filter if search text is present
-         if (!filter.empty()) {
-             if (entry->get_text().find(filter) == std::string::npos) {
-                 continue;
+     // With a filter, the clear button removes only what it matches
+     gtk_button_set_label(GTK_BUTTON(window->clear_button),
+                          filter.empty() && facets == 0 ? "Clear All" : "Delete Matches");
+     gtk_widget_set_sensitive(window->clear_button, valid_filter);
+     
+     // Flag invalid patterns on the search entry instead of showing everything
+     if (valid_filter) {
+         gtk_widget_remove_css_class(window->search_entry, "error");
+         gtk_widget_set_tooltip_text(window->search_entry, NULL);
+     } else {
+         gtk_widget_add_css_class(window->search_entry, "error");
+         gtk_widget_set_tooltip_text(window->search_entry, error.c_str());
+     }
+     
+     // When grouping, show the newest matching variant of each cluster with
+     // the number of variants it stands for
+     std::vector<size_t> variant_counts;
+     if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(window->group_toggle))) {
+         std::vector<size_t> clusters = cluster_near_duplicates(entries);
+         std::vector<size_t> shown_for(entries.size(), SIZE_MAX);
+         std::vector<size_t> grouped;
+         variant_counts.assign(entries.size(), 0);
+         for (size_t i : matches) {
+             size_t& shown = shown_for[clusters[i]];
+             if (shown == SIZE_MAX) {
+                 shown = i;
+                 grouped.push_back(i);
+             } else {
+                 variant_counts[shown]++;
              }
          }
+         matches.swap(grouped);
+     }
+     
+     // Add entries to main list
+     int row_index = 0;
+     for (size_t i : matches) {
+         const auto& entry = entries[i];
          
          // Create row
          GtkWidget* row_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
@@ -288,34 +704,187 @@
          GtkWidget* time_label = gtk_label_new(time_str.c_str());
          gtk_widget_add_css_class(time_label, "dim-label");
          
+         // Pin button; pinned entries survive eviction, expiry and bulk deletes
+         GtkWidget* pin_button = gtk_button_new_from_icon_name("view-pin-symbolic");
+         gtk_button_set_has_frame(GTK_BUTTON(pin_button), FALSE);
+         gtk_widget_set_tooltip_text(pin_button, entry->is_pinned() ? "Unpin" : "Pin");
+         if (!entry->is_pinned()) {
+             gtk_widget_add_css_class(pin_button, "dim-label");
+         }
+         g_object_set_data(G_OBJECT(pin_button), "entry-id", GSIZE_TO_POINTER(entry->get_id()));
+         g_signal_connect(pin_button, "clicked", G_CALLBACK(on_pin_entry), window);
+         
+         // View button; shows the whole entry, however large
+         GtkWidget* view_button = gtk_button_new_from_icon_name("view-reveal-symbolic");
+         gtk_button_set_has_frame(GTK_BUTTON(view_button), FALSE);
+         gtk_widget_set_tooltip_text(view_button, "Show whole entry");
+         g_object_set_data(G_OBJECT(view_button), "entry-id", GSIZE_TO_POINTER(entry->get_id()));
+         g_signal_connect(view_button, "clicked", G_CALLBACK(on_view_entry), window);
+         
          // Delete button
          GtkWidget* delete_button = gtk_button_new_from_icon_name("edit-delete-symbolic");
          gtk_button_set_has_frame(GTK_BUTTON(delete_button), FALSE);
-         g_object_set_data(G_OBJECT(delete_button), "entry-index", GINT_TO_POINTER(i));
+         g_object_set_data(G_OBJECT(delete_button), "entry-id", GSIZE_TO_POINTER(entry->get_id()));
          g_signal_connect(delete_button, "clicked", G_CALLBACK(on_delete_entry), window);
          
          // Add widgets to row
          gtk_box_append(GTK_BOX(row_box), label);
+         if (!variant_counts.empty() && variant_counts[i] > 0) {
+             std::string variants = "+" + std::to_string(variant_counts[i]) + " similar";
+             GtkWidget* variants_label = gtk_label_new(variants.c_str());
+             gtk_widget_add_css_class(variants_label, "dim-label");
+             gtk_box_append(GTK_BOX(row_box), variants_label);
+         }
          gtk_box_append(GTK_BOX(row_box), time_label);
+         gtk_box_append(GTK_BOX(row_box), view_button);
+         gtk_box_append(GTK_BOX(row_box), pin_button);
          gtk_box_append(GTK_BOX(row_box), delete_button);
          
          // Add row to list
          gtk_list_box_insert(GTK_LIST_BOX(window->list_box), row_box, -1);
          
-         // Store entry index
-         GtkListBoxRow* list_row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(window->list_box), i);
-         g_object_set_data(G_OBJECT(list_row), "entry-index", GINT_TO_POINTER(i));
+         // Store entry id; unlike its position it stays valid while new entries arrive
+         GtkListBoxRow* list_row = gtk_list_box_get_row_at_index(GTK_LIST_BOX(window->list_box), row_index++);
+         g_object_set_data(G_OBJECT(list_row), "entry-id", GSIZE_TO_POINTER(entry->get_id()));
+     }
+     
+     // A search also reaches into the archive of entries that left the
+     // history: at once when the history has few matches, otherwise when
+     // asked to. It runs off the UI thread and adds its rows when done.
+     if ((filter.empty() && facets == 0) || !valid_filter || window->selection != Selection::CLIPBOARD) {
+         return;
+     }
+     std::string request = std::to_string(static_cast<int>(mode)) + ":" + std::to_string(facets) + ":" + filter;
+     bool requested = window->archive_requested && request == window->archive_requested;
+     if (matches.size() >= ARCHIVE_AUTO_BELOW && !requested) {
+         GtkWidget* more_label = gtk_label_new("Search the archive");
+         gtk_widget_add_css_class(more_label, "dim-label");
+         gtk_widget_set_halign(more_label, GTK_ALIGN_START);
+         gtk_widget_set_margin_start(more_label, 6);
+         gtk_widget_set_margin_top(more_label, 6);
+         gtk_widget_set_margin_bottom(more_label, 6);
+         GtkWidget* more_row = gtk_list_box_row_new();
+         gtk_list_box_row_set_child(GTK_LIST_BOX_ROW(more_row), more_label);
+         gtk_list_box_row_set_selectable(GTK_LIST_BOX_ROW(more_row), FALSE);
+         g_object_set_data_full(G_OBJECT(more_row), "archive-request", g_strdup(request.c_str()), g_free);
+         gtk_list_box_append(GTK_LIST_BOX(window->list_box), more_row);
+         return;
+     }
+     
+     ArchiveSearch* search = new ArchiveSearch();
+     search->manager = window->clipboard_manager;
+     search->generation = window->list_generation;
+     search->query = filter;
+     search->mode = mode;
+     search->facets = facets;
+     
+     // The worker compares hits with this, never with the live entries
+     search->history = window->clipboard_manager->snapshot_history();
+     start_archive_search(window, search);
+ }
+ 
+ static void start_archive_search(MainWindow* window, ArchiveSearch* search) {
+     // The newest request replaces the one waiting
+     if (window->archive_running) {
+         delete window->archive_queued;
+         window->archive_queued = search;
+         return;
+     }
+     window->archive_running = TRUE;
+     
+     GTask* task = g_task_new(window, NULL, on_archive_search_done, NULL);
+     g_task_set_task_data(task, search, +[](gpointer data) {
+         delete static_cast<ArchiveSearch*>(data);
+     });
+     g_task_run_in_thread(task, +[](GTask* task, gpointer source_object G_GNUC_UNUSED, gpointer task_data,
+                                    GCancellable* cancellable G_GNUC_UNUSED) {
+         ArchiveSearch* search = static_cast<ArchiveSearch*>(task_data);
+         search->manager->search_archive(search->query, search->mode, 0, 0, ARCHIVE_RESULTS, search->history,
+                                         search->results, &search->complete, nullptr, search->facets);
+         g_task_return_boolean(task, TRUE);
+     });
+     g_object_unref(task);
+ }
+ 
+ static void on_archive_search_done(GObject* source, GAsyncResult* result, gpointer user_data G_GNUC_UNUSED) {
+     MainWindow* window = MAIN_WINDOW(source);
+     const ArchiveSearch* search = static_cast<const ArchiveSearch*>(g_task_get_task_data(G_TASK(result)));
+     window->archive_running = FALSE;
+     
+     if (window->clipboard_manager && window->list_box && search->generation == window->list_generation) {
+         append_archive_rows(window, *search);
+     }
+     
+     ArchiveSearch* queued = window->archive_queued;
+     window->archive_queued = nullptr;
+     if (queued) {
+         start_archive_search(window, queued);
+     }
+ }
+ 
+ static void append_archive_rows(MainWindow* window, const ArchiveSearch& search) {
+     if (search.results.empty()) {
+         return;
+     }
+     
+     GtkWidget* archive_label = gtk_label_new(search.complete ? "Archive" : "Archive (most recent part)");
+     gtk_widget_add_css_class(archive_label, "heading");
+     gtk_widget_set_halign(archive_label, GTK_ALIGN_START);
+     gtk_widget_set_margin_start(archive_label, 6);
+     gtk_widget_set_margin_top(archive_label, 12);
+     GtkWidget* heading_row = gtk_list_box_row_new();
+     gtk_list_box_row_set_child(GTK_LIST_BOX_ROW(heading_row), archive_label);
+     gtk_list_box_row_set_activatable(GTK_LIST_BOX_ROW(heading_row), FALSE);
+     gtk_list_box_row_set_selectable(GTK_LIST_BOX_ROW(heading_row), FALSE);
+     gtk_list_box_append(GTK_LIST_BOX(window->list_box), heading_row);
+     
+     // Archived entries are copied back into the history when activated
+     for (const auto& entry : search.results) {
+         GtkWidget* row_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 6);
+         gtk_widget_set_margin_start(row_box, 6);
+         gtk_widget_set_margin_end(row_box, 6);
+         gtk_widget_set_margin_top(row_box, 6);
+         gtk_widget_set_margin_bottom(row_box, 6);
+         
+         GtkWidget* label = gtk_label_new(entry->get_preview().c_str());
+         gtk_label_set_ellipsize(GTK_LABEL(label), PANGO_ELLIPSIZE_END);
+         gtk_widget_set_hexpand(label, TRUE);
+         gtk_widget_set_halign(label, GTK_ALIGN_START);
+         
+         // Older entries show their date as well
+         char date[32];
+         std::time_t timestamp = entry->get_timestamp();
+         strftime(date, sizeof(date), "%Y-%m-%d %H:%M", localtime(&timestamp));
+         GtkWidget* date_label = gtk_label_new(date);
+         gtk_widget_add_css_class(date_label, "dim-label");
+         
+         gtk_box_append(GTK_BOX(row_box), label);
+         gtk_box_append(GTK_BOX(row_box), date_label);
+         
+         GtkWidget* list_row = gtk_list_box_row_new();
+         gtk_list_box_row_set_child(GTK_LIST_BOX_ROW(list_row), row_box);
+         g_object_set_data(G_OBJECT(list_row), "entry-id", GSIZE_TO_POINTER(entry->get_id()));
+         gtk_list_box_append(GTK_LIST_BOX(window->list_box), list_row);
      }
  }
  
  static void on_row_activated(GtkListBox* list_box G_GNUC_UNUSED, GtkListBoxRow* row, gpointer user_data) {
      MainWindow* window = MAIN_WINDOW(user_data);
      
-     // Get entry index
-     gint index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "entry-index"));
+     // Extend the current search into the archive, also across refreshes
+     const gchar* request = static_cast<const gchar*>(g_object_get_data(G_OBJECT(row), "archive-request"));
+     if (request) {
+         g_free(window->archive_requested);
+         window->archive_requested = g_strdup(request);
+         populate_list(window);
+         return;
+     }
+     
+     // Get entry id
+     EntryId id = GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(row), "entry-id"));
      
      // Copy to clipboard
-     if (window->clipboard_manager->copy_to_clipboard(index)) {
+     if (paste_entry(window, id)) {
          // Hide window after copying
          gtk_widget_set_visible(GTK_WIDGET(window), FALSE);
      }
@@ -324,6 +893,10 @@
  static void on_clear_clicked(GtkButton* button G_GNUC_UNUSED, gpointer user_data) {
      MainWindow* window = MAIN_WINDOW(user_data);
      
+     // A non-empty search or a type filter narrows the clear to the matching entries
+     const char* search_text = gtk_editable_get_text(GTK_EDITABLE(window->search_entry));
+     bool matches_only = (search_text && *search_text) || selected_facets(window) != 0;
+     
      // Create a dialog using newer GTK4 approach
      GtkWidget* dialog = gtk_dialog_new_with_buttons("Confirm Clear",
                                         GTK_WINDOW(window),
@@ -334,7 +907,9 @@
      
      // Create content for the dialog
      GtkWidget* content_area = gtk_dialog_get_content_area(GTK_DIALOG(dialog));
-     GtkWidget* label = gtk_label_new("Clear all clipboard entries?");
+     GtkWidget* label = gtk_label_new(matches_only
+         ? "Delete all unpinned entries matching the search?"
+         : "Clear all clipboard entries?");
      gtk_widget_set_margin_start(label, 12);
      gtk_widget_set_margin_end(label, 12);
      gtk_widget_set_margin_top(label, 12);
@@ -349,8 +924,18 @@
          MainWindow* window = MAIN_WINDOW(user_data);
          
          if (response == GTK_RESPONSE_YES) {
-             // Clear entries
-             window->clipboard_manager->clear_entries();
+             const char* search_text = gtk_editable_get_text(GTK_EDITABLE(window->search_entry));
+             FacetMask facets = selected_facets(window);
+             if ((search_text && *search_text) || facets != 0) {
+                 // Delete the matching entries in one batch
+                 SearchMode mode = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(window->regex_toggle))
+                     ? SearchMode::REGEX : SearchMode::EXACT;
+                 window->clipboard_manager->remove_matches(search_text ? search_text : "", mode, window->selection,
+                                                           nullptr, facets);
+             } else {
+                 // Clear entries
+                 window->clipboard_manager->clear_entries(window->selection);
+             }
              populate_list(window);
          }
          
@@ -367,18 +952,62 @@
      
      // Refresh list to apply filter
      populate_list(window);
+     
+     // A cleared search box needs no corpus until the next search
+     if (!*gtk_editable_get_text(GTK_EDITABLE(window->search_entry))) {
+         window->clipboard_manager->release_search_corpora();
+     }
  }
  
  static void on_delete_entry(GtkButton* button, gpointer user_data) {
      MainWindow* window = MAIN_WINDOW(user_data);
      
-     // Get entry index
-     gint index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(button), "entry-index"));
+     // Get entry id
+     EntryId id = GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(button), "entry-id"));
      
      // Remove entry
-     window->clipboard_manager->remove_entry(index);
+     window->clipboard_manager->remove_entry(id);
+     
+     // Refresh list
+     populate_list(window);
+ }
+ 
+ static void on_pin_entry(GtkButton* button, gpointer user_data) {
+     MainWindow* window = MAIN_WINDOW(user_data);
+     
+     // Get entry id
+     EntryId id = GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(button), "entry-id"));
+     
+     // Toggle the pin
+     auto entry = window->clipboard_manager->find_entry(id);
+     if (entry) {
+         window->clipboard_manager->set_entries_pinned({id}, !entry->is_pinned());
+     }
+     
+     // Refresh list
+     populate_list(window);
+ }
+ 
+ static void on_view_entry(GtkButton* button, gpointer user_data) {
+     MainWindow* window = MAIN_WINDOW(user_data);
+     
+     // Get entry id
+     EntryId id = GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(button), "entry-id"));
+     
+     // Open the viewer; the entry may have been evicted meanwhile
+     auto entry = window->clipboard_manager->find_entry(id);
+     if (entry) {
+         entry_viewer_open(GTK_WINDOW(window), entry);
+     }
+ }
+ 
+ static void on_view_changed(GObject* selector, GParamSpec* pspec G_GNUC_UNUSED, gpointer user_data) {
+     MainWindow* window = MAIN_WINDOW(user_data);
+     
+     // Switch the shown history stream
+     guint selected = gtk_drop_down_get_selected(GTK_DROP_DOWN(selector));
+     window->selection = selected == 1 ? Selection::PRIMARY : Selection::CLIPBOARD;
      
      // Refresh list
      populate_list(window);
  }
- 
\ No newline at end of file
@@ -21,9 +21,16 @@ MainWindow* main_window_new(GtkApplication* app, std::shared_ptr<ClipboardManage
 // Refresh the clipboard entries display
 void main_window_refresh(MainWindow* window);
 
+// Release the widget tree while hidden (also set by VMCASTLE_LOW_MEMORY=1)
+void main_window_set_low_memory(MainWindow* window, gboolean enabled);
+
 // Show or hide the main window
 void main_window_toggle_visibility(MainWindow* window);
 
+// Same, for a request made at requested_at (g_get_monotonic_time clock);
+// the delay to the first painted frame is logged with VMCASTLE_TRACE_LATENCY
+void main_window_toggle_visibility_timed(MainWindow* window, gint64 requested_at);
+
 G_END_DECLS
 
 #endif // MAIN_WINDOW_HPP
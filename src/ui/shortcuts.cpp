@@ -58,8 +58,9 @@
  static void on_paste_recent_shortcut(GSimpleAction* action, GVariant* parameter, gpointer user_data) {
      if (clipboard_manager_instance) {
          // Get the most recent entry (index 0) and copy it to clipboard
-         if (clipboard_manager_instance->get_entry_count() > 0) {
-             clipboard_manager_instance->copy_to_clipboard(0);
+         auto entry = clipboard_manager_instance->get_entry(0);
+         if (entry) {
+             clipboard_manager_instance->copy_to_clipboard(entry->get_id());
          }
      }
  }
@@ -6,28 +6,49 @@
  #include "tray_icon.hpp"
  #include "main_window.hpp"
  #include "../clipboard_manager.hpp"
- #include <iostream>
+ #include "../status_notifier.hpp"
+ #include <climits>
+ #include <unordered_map>
+ 
+ // Recent entries listed in the tray menu
+ static const size_t MAX_RECENT = 10;
+ 
+ // Menu ids of the fixed items; entries are listed from FIRST_ENTRY_ID up
+ enum : int32_t {
+     MENU_SHOW = 1,
+     MENU_QUIT,
+     MENU_SEPARATOR,
+     MENU_EMPTY,
+     FIRST_ENTRY_ID = 100
+ };
+ 
+ // An entry's menu item follows from its id, so it keeps the item for as
+ // long as it lives, wherever it moves in the list and however often it
+ // leaves and comes back
+ static int32_t menu_id_for(EntryId id) {
+     return FIRST_ENTRY_ID + static_cast<int32_t>(id % (INT32_MAX - FIRST_ENTRY_ID));
+ }
  
  struct _TrayIcon {
      GObject parent_instance;
      
-     // Icon window (acts as the tray icon)
-     GtkWidget* window;
-     GtkWidget* button;
-     
-     // Popover menu
-     GtkWidget* menu;
-     GtkWidget* popover;
-     
-     // Menu items
-     GtkWidget* recent_items_box;
-     GtkWidget* show_item;
-     GtkWidget* quit_item;
+     // StatusNotifierItem and its exported menu
+     StatusNotifier* notifier;
      
      // Data
      std::shared_ptr<ClipboardManager> clipboard_manager;
      GtkWindow* main_window;
      
+     // Entry behind each listed menu item
+     std::unordered_map<int32_t, EntryId>* listed;
+     
+     // Registration of the clipboard change callback
+     ClipboardManager::CallbackId changed_callback;
+     
+     // Coalesced menu refresh and the window visibility handler
+     guint refresh_source;
+     gulong visibility_handler;
+     
      // State
      gboolean visible;
  };
@@ -35,22 +56,34 @@
  G_DEFINE_TYPE(TrayIcon, tray_icon, G_TYPE_OBJECT)
  
  // Forward declarations
- static void create_menu(TrayIcon* tray);
- static void on_show_clicked(GtkButton* button, gpointer user_data);
- static void on_quit_clicked(GtkButton* button, gpointer user_data);
- static void on_button_clicked(GtkButton* button, gpointer user_data);
- static void update_recent_items_menu(TrayIcon* tray);
- static void on_recent_item_clicked(GtkButton* button, gpointer user_data);
- static void position_window_on_screen(TrayIcon* tray);
+ static void update_menu(TrayIcon* tray);
+ static void schedule_menu_update(TrayIcon* tray);
+ static void on_menu_item_clicked(TrayIcon* tray, int32_t id);
  
  static void tray_icon_dispose(GObject* object) {
      TrayIcon* tray = TRAY_ICON(object);
      
+     if (tray->refresh_source) {
+         g_source_remove(tray->refresh_source);
+         tray->refresh_source = 0;
+     }
+     
+     // Leave the bus
+     if (tray->notifier) {
+         tray->notifier->stop();
+     }
+     
+     // The manager may outlive us: stop its callback before we go
+     if (tray->clipboard_manager) {
+         tray->clipboard_manager->unregister_callback(tray->changed_callback);
+     }
+     
      // Clear clipboard manager reference
      tray->clipboard_manager = nullptr;
      
      // Unreference main window
      if (tray->main_window) {
+         g_signal_handler_disconnect(tray->main_window, tray->visibility_handler);
          g_object_unref(tray->main_window);
          tray->main_window = nullptr;
      }
@@ -62,10 +95,8 @@
  static void tray_icon_finalize(GObject* object) {
      TrayIcon* tray = TRAY_ICON(object);
      
-     // Destroy window
-     if (tray->window) {
-         gtk_window_destroy(GTK_WINDOW(tray->window));
-     }
+     delete tray->notifier;
+     delete tray->listed;
      
      // Chain up to parent
      G_OBJECT_CLASS(tray_icon_parent_class)->finalize(object);
@@ -79,25 +110,16 @@
  
  static void tray_icon_init(TrayIcon* tray) {
      tray->visible = FALSE;
-     
-     // Create floating window to act as a tray icon
-     tray->window = gtk_window_new();
-     gtk_window_set_title(GTK_WINDOW(tray->window), "Clipboard Manager");
-     gtk_window_set_decorated(GTK_WINDOW(tray->window), FALSE);  // No window decorations
-     // Note: In GTK4, we use GtkWindow properties instead of set_skip_taskbar_hint
-     g_object_set(G_OBJECT(tray->window), "deletable", FALSE, NULL);  // Not closable by window manager
-     gtk_window_set_default_size(GTK_WINDOW(tray->window), 32, 32);  // Small size
-     
-     // Create icon button
-     tray->button = gtk_button_new_from_icon_name("edit-paste");  // Clipboard icon
-     gtk_button_set_has_frame(GTK_BUTTON(tray->button), FALSE);  // No button frame
-     gtk_widget_set_tooltip_text(tray->button, "Clipboard Manager");
-     
-     // Connect button signal
-     g_signal_connect(tray->button, "clicked", G_CALLBACK(on_button_clicked), tray);
-     
-     // Add button to window
-     gtk_window_set_child(GTK_WINDOW(tray->window), tray->button);
+     tray->listed = new std::unordered_map<int32_t, EntryId>();
+     tray->changed_callback = 0;
+     
+     tray->notifier = new StatusNotifier("vmcastle", "VmCastle", "edit-paste");
+     tray->notifier->on_activate = [tray]() {
+         main_window_toggle_visibility(MAIN_WINDOW(tray->main_window));
+     };
+     tray->notifier->on_item_clicked = [tray](int32_t id) {
+         on_menu_item_clicked(tray, id);
+     };
  }
  
  TrayIcon* tray_icon_new(std::shared_ptr<ClipboardManager> manager, GtkWindow* main_window) {
@@ -106,189 +128,114 @@
      // Store clipboard manager
      tray->clipboard_manager = manager;
      
-     // Store main window
+     // Store main window; its visibility decides the Show/Hide label
      tray->main_window = GTK_WINDOW(g_object_ref(main_window));
+     tray->visibility_handler = g_signal_connect_swapped(main_window, "notify::visible",
+                                                         G_CALLBACK(schedule_menu_update), tray);
      
-     // Create menu and popover
-     create_menu(tray);
-     
-     // Position window on screen
-     position_window_on_screen(tray);
-     
-     // Register for clipboard changes
-     manager->register_callback([tray]() {
-         g_idle_add(+[](gpointer user_data) -> gboolean {
-             update_recent_items_menu(TRAY_ICON(user_data));
-             return G_SOURCE_REMOVE;
-         }, tray);
+     // Register for clipboard changes until dispose
+     tray->changed_callback = manager->register_callback([tray]() {
+         schedule_menu_update(tray);
      });
      
+     // Build the first menu
+     update_menu(tray);
+     
      return tray;
  }
  
  void tray_icon_show(TrayIcon* tray) {
-     tray->visible = TRUE;
-     gtk_widget_set_visible(tray->window, TRUE);
+     tray->visible = tray->notifier->start();
  }
  
  void tray_icon_hide(TrayIcon* tray) {
      tray->visible = FALSE;
-     gtk_widget_set_visible(tray->window, FALSE);
+     tray->notifier->stop();
  }
  
- static void position_window_on_screen(TrayIcon* tray) {
-     // Get the display
-     GdkDisplay* display = gdk_display_get_default();
-     
-     if (!display) {
-         return;  // No display available
-     }
-     
-     // In GTK4, we use surface APIs to position windows
-     // Set a fixed position for the tray icon in the bottom-right corner
-     // We cannot access monitor directly in GTK4, so use fixed values for demo
-     
-     // Get the surface of the window
-     GdkSurface* surface = gtk_native_get_surface(GTK_NATIVE(tray->window));
-     if (surface) {
-         // The window needs to be visible to position it
-         // We'll set a fixed position at the bottom-right corner (e.g., 100px from right and bottom edges)
-         // In a real application, we would determine the screen size programmatically
-         gtk_window_present(GTK_WINDOW(tray->window));
-         
-         // Set a fixed bottom-right position for now
-         // In a real app, we'd calculate this based on screen dimensions
-         gtk_widget_set_margin_end(GTK_WIDGET(tray->window), 10);
-         gtk_widget_set_margin_bottom(GTK_WIDGET(tray->window), 10);
+ static void schedule_menu_update(TrayIcon* tray) {
+     // Several changes in a row produce one update
+     if (tray->refresh_source) {
+         return;
      }
+     tray->refresh_source = g_idle_add(+[](gpointer user_data) -> gboolean {
+         TrayIcon* tray = TRAY_ICON(user_data);
+         tray->refresh_source = 0;
+         update_menu(tray);
+         return G_SOURCE_REMOVE;
+     }, tray);
  }
  
- static void create_menu(TrayIcon* tray) {
-     // Create a box for the menu
-     tray->menu = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
-     gtk_widget_set_margin_start(tray->menu, 12);
-     gtk_widget_set_margin_end(tray->menu, 12);
-     gtk_widget_set_margin_top(tray->menu, 12);
-     gtk_widget_set_margin_bottom(tray->menu, 12);
-     
-     // Create a label for recent items
-     GtkWidget* recent_label = gtk_label_new("Recent Items");
-     gtk_widget_set_halign(recent_label, GTK_ALIGN_START);
-     gtk_widget_add_css_class(recent_label, "heading");
-     
-     // Create box for recent items
-     tray->recent_items_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 3);
-     
-     // Separator
-     GtkWidget* separator = gtk_separator_new(GTK_ORIENTATION_HORIZONTAL);
-     
-     // Show manager button
-     tray->show_item = gtk_button_new_with_label("Show Manager");
-     g_signal_connect(tray->show_item, "clicked", G_CALLBACK(on_show_clicked), tray);
-     
-     // Quit button
-     tray->quit_item = gtk_button_new_with_label("Quit");
-     g_signal_connect(tray->quit_item, "clicked", G_CALLBACK(on_quit_clicked), tray);
-     
-     // Add everything to the menu box
-     gtk_box_append(GTK_BOX(tray->menu), recent_label);
-     gtk_box_append(GTK_BOX(tray->menu), tray->recent_items_box);
-     gtk_box_append(GTK_BOX(tray->menu), separator);
-     gtk_box_append(GTK_BOX(tray->menu), tray->show_item);
-     gtk_box_append(GTK_BOX(tray->menu), tray->quit_item);
-     
-     // Create popover for the menu
-     tray->popover = gtk_popover_new();
-     gtk_popover_set_child(GTK_POPOVER(tray->popover), tray->menu);
-     gtk_popover_set_has_arrow(GTK_POPOVER(tray->popover), FALSE);
-     gtk_widget_set_parent(tray->popover, tray->window);
-     
-     // Populate recent items
-     update_recent_items_menu(tray);
+ // dbusmenu labels use '_' for mnemonics, so double the literal ones
+ static std::string menu_label(const std::string& text) {
+     std::string label;
+     label.reserve(text.size());
+     for (char c : text) {
+         if (c == '_') {
+             label += '_';
+         }
+         label += c;
+     }
+     return label;
  }
  
- static void update_recent_items_menu(TrayIcon* tray) {
-     // Remove existing items
-     GtkWidget* child;
-     while ((child = gtk_widget_get_first_child(tray->recent_items_box)) != NULL) {
-         // Use gtk_box_remove instead of manually setting parent to NULL
-         gtk_box_remove(GTK_BOX(tray->recent_items_box), child);
+ static void update_menu(TrayIcon* tray) {
+     if (!tray->clipboard_manager) {
+         return;
      }
      
-     // Get entries
-     auto entries = tray->clipboard_manager->get_entries();
-     
-     // Add up to 10 recent items
-     const size_t max_recent = 10;
-     size_t count = std::min(entries.size(), max_recent);
-     
-     if (count == 0) {
-         // Add a placeholder message when there are no entries
-         GtkWidget* empty_label = gtk_label_new("No clipboard entries yet");
-         gtk_widget_set_sensitive(empty_label, FALSE);
-         gtk_widget_set_halign(empty_label, GTK_ALIGN_START);
-         gtk_box_append(GTK_BOX(tray->recent_items_box), empty_label);
+     // Only the entries listed are copied out of the manager
+     auto entries = tray->clipboard_manager->get_recent_entries(MAX_RECENT);
+     
+     std::vector<TrayMenuItem> items;
+     tray->listed->clear();
+     if (entries.empty()) {
+         TrayMenuItem empty;
+         empty.id = MENU_EMPTY;
+         empty.label = "No clipboard entries yet";
+         empty.enabled = false;
+         items.push_back(empty);
      }
-     
-     for (size_t i = 0; i < count; ++i) {
-         const auto& entry = entries[i];
-         
-         // Create button with preview text
-         GtkWidget* btn = gtk_button_new_with_label(entry->get_preview(30).c_str());
-         gtk_widget_set_halign(btn, GTK_ALIGN_FILL);
-         gtk_button_set_has_frame(GTK_BUTTON(btn), FALSE);
-         
-         // Store entry index
-         g_object_set_data(G_OBJECT(btn), "entry-index", GINT_TO_POINTER(i));
-         
-         // Connect signal
-         g_signal_connect(btn, "clicked", G_CALLBACK(on_recent_item_clicked), tray);
-         
-         // Add to menu
-         gtk_box_append(GTK_BOX(tray->recent_items_box), btn);
+     for (const auto& entry : entries) {
+         TrayMenuItem item;
+         item.id = menu_id_for(entry->get_id());
+         (*tray->listed)[item.id] = entry->get_id();
+         item.label = menu_label(entry->get_preview(30));
+         item.icon_name = entry->is_pinned() ? "view-pin-symbolic" : "";
+         items.push_back(item);
      }
- }
- 
- static void on_show_clicked(GtkButton* button G_GNUC_UNUSED, gpointer user_data) {
-     TrayIcon* tray = TRAY_ICON(user_data);
-     
-     // Hide the popover
-     gtk_popover_popdown(GTK_POPOVER(tray->popover));
-     
-     // Show main window
-     main_window_toggle_visibility(MAIN_WINDOW(tray->main_window));
- }
- 
- static void on_quit_clicked(GtkButton* button G_GNUC_UNUSED, gpointer user_data) {
-     TrayIcon* tray = TRAY_ICON(user_data);
      
-     // Hide the popover
-     gtk_popover_popdown(GTK_POPOVER(tray->popover));
+     TrayMenuItem separator;
+     separator.id = MENU_SEPARATOR;
+     separator.separator = true;
+     items.push_back(separator);
      
-     // Quit application
-     g_application_quit(G_APPLICATION(gtk_window_get_application(tray->main_window)));
- }
- 
- static void on_button_clicked(GtkButton* button G_GNUC_UNUSED, gpointer user_data) {
-     TrayIcon* tray = TRAY_ICON(user_data);
+     TrayMenuItem show;
+     show.id = MENU_SHOW;
+     show.label = gtk_widget_get_visible(GTK_WIDGET(tray->main_window)) ? "Hide Manager" : "Show Manager";
+     items.push_back(show);
      
-     // Update recent items before showing menu
-     update_recent_items_menu(tray);
+     TrayMenuItem quit;
+     quit.id = MENU_QUIT;
+     quit.label = "Quit";
+     items.push_back(quit);
      
-     // Show the popover menu
-     gtk_popover_popup(GTK_POPOVER(tray->popover));
+     tray->notifier->set_items(std::move(items));
  }
  
- static void on_recent_item_clicked(GtkButton* button, gpointer user_data) {
-     TrayIcon* tray = TRAY_ICON(user_data);
-     
-     // Hide the popover
-     gtk_popover_popdown(GTK_POPOVER(tray->popover));
-     
-     // Get entry index
-     gint index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(button), "entry-index"));
+ static void on_menu_item_clicked(TrayIcon* tray, int32_t id) {
+     if (id == MENU_SHOW) {
+         main_window_toggle_visibility(MAIN_WINDOW(tray->main_window));
+         return;
+     }
+     if (id == MENU_QUIT) {
+         g_application_quit(G_APPLICATION(gtk_window_get_application(tray->main_window)));
+         return;
+     }
      
-     // Copy to clipboard
-     tray->clipboard_manager->copy_to_clipboard(index);
+     // Copy the entry behind the item, if it is still there
+     auto listed = tray->listed->find(id);
+     if (listed != tray->listed->end()) {
+         tray->clipboard_manager->copy_to_clipboard(listed->second);
+     }
  }
- 
\ No newline at end of file
@@ -18,10 +18,11 @@ G_DECLARE_FINAL_TYPE(TrayIcon, tray_icon, TRAY, ICON, GObject)
 // Create a new tray icon
 TrayIcon* tray_icon_new(std::shared_ptr<ClipboardManager> manager, GtkWindow* main_window);
 
-// Show the tray icon
+// Show the tray icon: export it as a StatusNotifierItem on the session bus
+// (it appears once a panel with a tray is running)
 void tray_icon_show(TrayIcon* tray);
 
-// Hide the tray icon
+// Hide the tray icon, leaving the bus
 void tray_icon_hide(TrayIcon* tray);
 
 G_END_DECLS
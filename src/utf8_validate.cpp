@@ -0,0 +1,267 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "utf8_validate.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_VALIDATOR 1
+#endif
+
+// Bytes looked at when deciding between repaired text and binary data
+static const size_t CLASSIFY_SAMPLE = 4096;
+
+// Length of the valid, non-NUL sequence starting at p, or 0 if there is none
+static size_t sequence_length(const unsigned char* p, size_t remaining) {
+    unsigned char lead = p[0];
+    if (lead < 0x80) {
+        return lead != 0 ? 1 : 0;
+    }
+
+    size_t length;
+    unsigned char second_min = 0x80, second_max = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) {
+            second_min = 0xA0;   // Overlong
+        } else if (lead == 0xED) {
+            second_max = 0x9F;   // Surrogates
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) {
+            second_min = 0x90;   // Overlong
+        } else if (lead == 0xF4) {
+            second_max = 0x8F;   // Above U+10FFFF
+        }
+    } else {
+        return 0;
+    }
+
+    if (remaining < length || p[1] < second_min || p[1] > second_max) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+static bool validate_scalar(const char* data, size_t size) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+    while (i < size) {
+        size_t length = sequence_length(p + i, size - i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+#ifdef HAVE_X86_VALIDATOR
+
+// Lookup-table validation (Keiser and Lemire, "Validating UTF-8 in less than
+// one instruction per byte"). Each byte pair is classified through three
+// nibble tables; any bit surviving the AND is an error. Runs of ASCII only
+// need a movemask.
+static const uint8_t TOO_SHORT = 1 << 0;
+static const uint8_t TOO_LONG = 1 << 1;
+static const uint8_t OVERLONG_3 = 1 << 2;
+static const uint8_t TOO_LARGE = 1 << 3;
+static const uint8_t SURROGATE = 1 << 4;
+static const uint8_t OVERLONG_2 = 1 << 5;
+static const uint8_t TOO_LARGE_1000 = 1 << 6;
+static const uint8_t OVERLONG_4 = 1 << 6;
+static const uint8_t TWO_CONTS = 1 << 7;
+static const uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+__attribute__((target("ssse3")))
+static __m128i check_block(__m128i input, __m128i previous) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+
+    const __m128i byte_1_high_table = _mm_setr_epi8(
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        static_cast<char>(TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4));
+    const __m128i byte_1_low_table = _mm_setr_epi8(
+        static_cast<char>(CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4),
+        static_cast<char>(CARRY | OVERLONG_2),
+        static_cast<char>(CARRY), static_cast<char>(CARRY),
+        static_cast<char>(CARRY | TOO_LARGE),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000),
+        static_cast<char>(CARRY | TOO_LARGE | TOO_LARGE_1000));
+    const __m128i byte_2_high_table = _mm_setr_epi8(
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4),
+        static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE),
+        static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+        static_cast<char>(TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE),
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    // Two-byte patterns: the previous byte against this one
+    __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, nibble));
+    __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+    // Third and fourth bytes of longer sequences must be continuations
+    __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+    __m128i is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m128i must_be_continuation = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte),
+                                                 _mm_set1_epi8(static_cast<char>(0x80)));
+
+    // NUL bytes are valid UTF-8 but not text we can show
+    __m128i nul = _mm_cmpeq_epi8(input, _mm_setzero_si128());
+
+    return _mm_or_si128(_mm_xor_si128(must_be_continuation, special_cases), nul);
+}
+
+// Non-zero where a block ends inside a sequence that needs more bytes
+__attribute__((target("ssse3")))
+static __m128i incomplete_tail(__m128i input) {
+    const __m128i max_value = _mm_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+    return _mm_subs_epu8(input, max_value);
+}
+
+__attribute__((target("ssse3")))
+static bool validate_ssse3(const char* data, size_t size) {
+    __m128i error = _mm_setzero_si128();
+    __m128i previous = _mm_setzero_si128();
+    __m128i previous_incomplete = _mm_setzero_si128();
+
+    auto process = [&](__m128i input) {
+        if (_mm_movemask_epi8(input) == 0) {
+            // ASCII block: only a sequence left open before it or a NUL can fail
+            error = _mm_or_si128(error, previous_incomplete);
+            error = _mm_or_si128(error, _mm_cmpeq_epi8(input, _mm_setzero_si128()));
+        } else {
+            error = _mm_or_si128(error, check_block(input, previous));
+            previous_incomplete = incomplete_tail(input);
+        }
+        previous = input;
+    };
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        process(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+
+        // Stop early on garbage instead of scanning the whole payload
+        if ((i & 1023) == 0 && _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) != 0xFFFF) {
+            return false;
+        }
+    }
+
+    // Pad the last partial block; the padding must not be taken for NULs
+    if (i < size) {
+        char tail[16];
+        memset(tail, ' ', sizeof(tail));
+        memcpy(tail, data + i, size - i);
+        process(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tail)));
+    }
+    error = _mm_or_si128(error, previous_incomplete);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+#endif // HAVE_X86_VALIDATOR
+
+using Validator = bool (*)(const char* data, size_t size);
+
+struct ValidatorChoice {
+    Validator validate;
+    const char* name;
+};
+
+static ValidatorChoice choose_validator() {
+#ifdef HAVE_X86_VALIDATOR
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        return {validate_ssse3, "ssse3"};
+    }
+#endif
+    return {validate_scalar, "scalar"};
+}
+
+static const ValidatorChoice& validator_choice() {
+    static const ValidatorChoice choice = choose_validator();
+    return choice;
+}
+
+const char* utf8_validator_name() {
+    return validator_choice().name;
+}
+
+bool utf8_is_valid(const char* data, size_t size) {
+    return validator_choice().validate(data, size);
+}
+
+TextKind repair_utf8(const std::string& text, std::string& repaired) {
+    static const char REPLACEMENT[] = "\xEF\xBF\xBD";
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+
+    // Control characters other than common whitespace and invalid bytes
+    // are rare in text and common in binary formats
+    size_t sample = std::min(size, CLASSIFY_SAMPLE);
+    size_t suspicious = 0;
+    for (size_t i = 0; i < sample;) {
+        size_t length = sequence_length(p + i, size - i);
+        if (length == 0) {
+            ++suspicious;
+            ++i;
+            continue;
+        }
+        unsigned char c = p[i];
+        if (c < 0x20 && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != '\v' && c != 0x1B) {
+            ++suspicious;
+        }
+        i += length;
+    }
+
+    repaired.clear();
+    if (suspicious * 8 > sample) {
+        return TextKind::BINARY;
+    }
+
+    repaired.reserve(size + 16);
+    size_t run_start = 0;
+    for (size_t i = 0; i < size;) {
+        size_t length = sequence_length(p + i, size - i);
+        if (length != 0) {
+            i += length;
+            continue;
+        }
+        repaired.append(text, run_start, i - run_start);
+        repaired.append(REPLACEMENT, 3);
+        ++i;
+        run_start = i;
+    }
+    repaired.append(text, run_start, size - run_start);
+    return TextKind::REPAIRED;
+}
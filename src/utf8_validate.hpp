@@ -0,0 +1,31 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef UTF8_VALIDATE_HPP
+#define UTF8_VALIDATE_HPP
+
+#include <cstddef>
+#include <string>
+
+// What ingest found in a captured payload
+enum class TextKind {
+    UTF8,       // Valid UTF-8 as captured
+    REPAIRED,   // Mostly text; invalid bytes were replaced with U+FFFD
+    BINARY      // Not text; kept byte for byte but never rendered or searched
+};
+
+// Whether data is valid UTF-8 without NUL bytes (which GTK cannot render).
+// Uses an SSSE3 lookup-table validator when the CPU has it.
+bool utf8_is_valid(const char* data, size_t size);
+
+// Classify a payload that failed utf8_is_valid(). Text gets each invalid
+// byte replaced with U+FFFD into repaired; payloads dominated by control
+// or invalid bytes are reported as BINARY and repaired is left empty.
+TextKind repair_utf8(const std::string& text, std::string& repaired);
+
+// Name of the validator picked for this CPU ("ssse3" or "scalar")
+const char* utf8_validator_name();
+
+#endif // UTF8_VALIDATE_HPP
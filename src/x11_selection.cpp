@@ -0,0 +1,454 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "x11_selection.hpp"
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/Xfixes.h>
+#include <poll.h>
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// Most bytes reserved up front for an INCR transfer, whatever the owner claims
+static const size_t INCR_RESERVE_MAX = 256 * 1024 * 1024;
+
+static long long monotonic_ms() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Connections opened by open(), for the process-wide error handlers
+static std::mutex private_displays_mutex;
+static std::unordered_map<Display*, X11Selection*> private_displays;
+
+// Handlers installed before ours (GTK's, or Xlib's defaults)
+static XErrorHandler previous_error_handler = nullptr;
+static XIOErrorHandler previous_io_error_handler = nullptr;
+
+static X11Selection* private_source(Display* display) {
+    std::lock_guard<std::mutex> lock(private_displays_mutex);
+    auto found = private_displays.find(display);
+    return found != private_displays.end() ? found->second : nullptr;
+}
+
+// A misbehaving selection owner can make our requests fail; that is worth
+// a line on stderr, not the process. Reading properties of another client's
+// windows fails with BadWindow once the client is gone, which is expected
+// and not reported.
+static int on_x_error(Display* display, XErrorEvent* error) {
+    if (!private_source(display)) {
+        return previous_error_handler ? previous_error_handler(display, error) : 0;
+    }
+    if (error->error_code == BadWindow) {
+        return 0;
+    }
+
+    char message[256] = {};
+    XGetErrorText(display, error->error_code, message, sizeof(message));
+    std::cerr << "X error on selection connection " << DisplayString(display) << ": " << message
+              << " (request " << static_cast<int>(error->request_code) << ")" << std::endl;
+    return 0;
+}
+
+int X11Selection::on_io_error(Display* display) {
+    X11Selection* source = private_source(display);
+    if (source) {
+        source->lost_ = true;
+        if (source->io_error_jump_) {
+            std::longjmp(*source->io_error_jump_, 1);
+        }
+    }
+
+    // Xlib exits when this returns
+    return previous_io_error_handler ? previous_io_error_handler(display) : 0;
+}
+
+void X11Selection::install_error_handlers() {
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+        previous_error_handler = XSetErrorHandler(on_x_error);
+        previous_io_error_handler = XSetIOErrorHandler(on_io_error);
+    });
+}
+
+std::unique_ptr<X11Selection> X11Selection::open(const char* display_name) {
+    install_error_handlers();
+
+    Display* display = XOpenDisplay(display_name);
+    if (!display) {
+        return nullptr;
+    }
+
+    std::unique_ptr<X11Selection> source(new X11Selection());
+    source->display_ = display;
+    {
+        std::lock_guard<std::mutex> lock(private_displays_mutex);
+        private_displays[display] = source.get();
+    }
+
+    // Invisible window used as requestor for selection transfers
+    source->window_ = XCreateSimpleWindow(display, DefaultRootWindow(display), 0, 0, 1, 1, 0, 0, 0);
+    XSelectInput(display, source->window_, PropertyChangeMask);
+
+    source->clipboard_atom_ = XInternAtom(display, "CLIPBOARD", False);
+    source->primary_atom_ = XA_PRIMARY;
+    source->utf8_atom_ = XInternAtom(display, "UTF8_STRING", False);
+    source->string_atom_ = XA_STRING;
+    source->incr_atom_ = XInternAtom(display, "INCR", False);
+    source->timestamp_atom_ = XInternAtom(display, "TIMESTAMP", False);
+    source->targets_atom_ = XInternAtom(display, "TARGETS", False);
+    source->length_atom_ = XInternAtom(display, "LENGTH", False);
+    source->password_hint_atom_ = XInternAtom(display, "x-kde-passwordManagerHint", False);
+    source->client_leader_atom_ = XInternAtom(display, "WM_CLIENT_LEADER", False);
+    source->property_atom_ = XInternAtom(display, "VMCASTLE_SELECTION", False);
+
+    int error_base = 0;
+    source->has_xfixes_ = XFixesQueryExtension(display, &source->xfixes_event_base_, &error_base);
+
+    XFlush(display);
+    return source;
+}
+
+X11Selection::~X11Selection() {
+    if (!display_) {
+        return;
+    }
+
+    // Closing a connection that is gone fails like any other request; the
+    // Display of a lost connection is left as it is
+    with_connection([this]() {
+        XDestroyWindow(display_, window_);
+        XCloseDisplay(display_);
+    });
+
+    std::lock_guard<std::mutex> lock(private_displays_mutex);
+    private_displays.erase(display_);
+}
+
+int X11Selection::get_fd() const {
+    return ConnectionNumber(display_);
+}
+
+bool X11Selection::with_connection(const std::function<void()>& body) {
+    if (lost_) {
+        return false;
+    }
+
+    std::jmp_buf* outer = io_error_jump_;
+    std::jmp_buf jump;
+    if (setjmp(jump) != 0) {
+        io_error_jump_ = outer;
+        return false;
+    }
+    io_error_jump_ = &jump;
+    body();
+    io_error_jump_ = outer;
+    return true;
+}
+
+bool X11Selection::is_lost() const {
+    return lost_;
+}
+
+unsigned long X11Selection::atom_for(Selection selection) const {
+    return selection == Selection::PRIMARY ? primary_atom_ : clipboard_atom_;
+}
+
+bool X11Selection::watch_selections() {
+    if (!has_xfixes_) {
+        return false;
+    }
+
+    const unsigned long mask = XFixesSetSelectionOwnerNotifyMask |
+                               XFixesSelectionWindowDestroyNotifyMask |
+                               XFixesSelectionClientCloseNotifyMask;
+    XFixesSelectSelectionInput(display_, window_, clipboard_atom_, mask);
+    XFixesSelectSelectionInput(display_, window_, primary_atom_, mask);
+    XFlush(display_);
+    return true;
+}
+
+std::vector<Selection> X11Selection::read_changes() {
+    std::vector<Selection> changes;
+    changes.swap(pending_changes_);
+
+    while (XPending(display_) > 0) {
+        XEvent event;
+        XNextEvent(display_, &event);
+
+        if (has_xfixes_ && event.type == xfixes_event_base_ + XFixesSelectionNotify) {
+            auto* notify = reinterpret_cast<XFixesSelectionNotifyEvent*>(&event);
+            // Ownership lost without a new owner carries no content
+            if (notify->owner == None) {
+                continue;
+            }
+            changes.push_back(notify->selection == primary_atom_ ? Selection::PRIMARY : Selection::CLIPBOARD);
+        }
+    }
+
+    return changes;
+}
+
+unsigned long X11Selection::get_owner(Selection selection) const {
+    return XGetSelectionOwner(display_, atom_for(selection));
+}
+
+bool X11Selection::wait_for_event(int type, int timeout_ms, void* out) {
+    XEvent* event = static_cast<XEvent*>(out);
+    long long deadline = monotonic_ms() + timeout_ms;
+
+    while (true) {
+        while (XPending(display_) > 0) {
+            XNextEvent(display_, event);
+
+            if (has_xfixes_ && event->type == xfixes_event_base_ + XFixesSelectionNotify) {
+                // Keep owner changes for the next read_changes()
+                auto* notify = reinterpret_cast<XFixesSelectionNotifyEvent*>(event);
+                if (notify->owner != None) {
+                    pending_changes_.push_back(notify->selection == primary_atom_ ? Selection::PRIMARY : Selection::CLIPBOARD);
+                }
+                continue;
+            }
+
+            if (event->type != type) {
+                continue;
+            }
+            if (type == SelectionNotify && event->xselection.requestor == window_) {
+                return true;
+            }
+            if (type == PropertyNotify && event->xproperty.window == window_ &&
+                event->xproperty.atom == property_atom_ && event->xproperty.state == PropertyNewValue) {
+                return true;
+            }
+        }
+
+        long long remaining = deadline - monotonic_ms();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        pollfd pfd = {ConnectionNumber(display_), POLLIN, 0};
+        poll(&pfd, 1, static_cast<int>(remaining));
+    }
+}
+
+bool X11Selection::read_property(std::string& out, int timeout_ms) {
+    Atom type = None;
+    int format = 0;
+    unsigned long count = 0;
+    unsigned long remaining = 0;
+    unsigned char* data = nullptr;
+
+    if (XGetWindowProperty(display_, window_, property_atom_, 0, LONG_MAX / 4, True, AnyPropertyType,
+                           &type, &format, &count, &remaining, &data) != Success) {
+        return false;
+    }
+
+    if (type != incr_atom_) {
+        if (data && format == 8) {
+            out.assign(reinterpret_cast<char*>(data), count);
+        }
+        if (data) {
+            XFree(data);
+        }
+        return format == 8;
+    }
+
+    // INCR: the owner sends chunks, each one announced by a new property value.
+    // Deleting the INCR property above started the transfer. Its value is a
+    // lower bound on the size, so the buffer is allocated once up front
+    // instead of doubling (and copying) its way up through the chunks.
+    size_t size_hint = 0;
+    if (data) {
+        if (format == 32 && count == 1) {
+            size_hint = static_cast<size_t>(*reinterpret_cast<unsigned long*>(data));
+        }
+        XFree(data);
+    }
+    XFlush(display_);
+
+    out.clear();
+    out.reserve(std::min(size_hint, INCR_RESERVE_MAX));
+    while (true) {
+        XEvent event;
+        if (!wait_for_event(PropertyNotify, timeout_ms, &event)) {
+            return false;
+        }
+
+        data = nullptr;
+        if (XGetWindowProperty(display_, window_, property_atom_, 0, LONG_MAX / 4, True, AnyPropertyType,
+                               &type, &format, &count, &remaining, &data) != Success) {
+            return false;
+        }
+        XFlush(display_);
+
+        // A zero-length chunk ends the transfer
+        if (count == 0) {
+            if (data) {
+                XFree(data);
+            }
+            // The hint is the owner's word; do not keep much more than it sent
+            if (out.capacity() > 2 * out.size() + 4096) {
+                out.shrink_to_fit();
+            }
+            return true;
+        }
+
+        if (format == 8) {
+            out.append(reinterpret_cast<char*>(data), count);
+        }
+        XFree(data);
+    }
+}
+
+bool X11Selection::convert(Selection selection, unsigned long target, int timeout_ms) {
+    XConvertSelection(display_, atom_for(selection), target, property_atom_, window_, CurrentTime);
+    XFlush(display_);
+
+    XEvent event;
+    return wait_for_event(SelectionNotify, timeout_ms, &event) && event.xselection.property != None;
+}
+
+bool X11Selection::fetch_timestamp(Selection selection, unsigned long& timestamp, int timeout_ms) {
+    if (!convert(selection, timestamp_atom_, timeout_ms)) {
+        return false;
+    }
+
+    Atom type = None;
+    int format = 0;
+    unsigned long count = 0;
+    unsigned long remaining = 0;
+    unsigned char* data = nullptr;
+    if (XGetWindowProperty(display_, window_, property_atom_, 0, 1, True, AnyPropertyType,
+                           &type, &format, &count, &remaining, &data) != Success) {
+        return false;
+    }
+
+    // Xlib hands 32-bit items over as longs; CurrentTime (0) tells nothing
+    bool valid = data && format == 32 && count == 1;
+    timestamp = valid ? *reinterpret_cast<unsigned long*>(data) : 0;
+    if (data) {
+        XFree(data);
+    }
+    return valid && timestamp != 0;
+}
+
+bool X11Selection::fetch_text(Selection selection, std::string& out, int timeout_ms) {
+    out.clear();
+    Atom selection_atom = atom_for(selection);
+    if (XGetSelectionOwner(display_, selection_atom) == None) {
+        return false;
+    }
+
+    // Prefer UTF8_STRING, fall back to STRING for old clients
+    for (Atom target : {static_cast<Atom>(utf8_atom_), static_cast<Atom>(string_atom_)}) {
+        XConvertSelection(display_, selection_atom, target, property_atom_, window_, CurrentTime);
+        XFlush(display_);
+
+        XEvent event;
+        if (!wait_for_event(SelectionNotify, timeout_ms, &event)) {
+            return false;
+        }
+        if (event.xselection.property == None) {
+            continue;
+        }
+        return read_property(out, timeout_ms);
+    }
+
+    return false;
+}
+
+// WM_CLASS class of a window, empty if it has none
+static std::string window_class(Display* display, Window window) {
+    std::string result;
+    XClassHint hint = {nullptr, nullptr};
+    if (XGetClassHint(display, window, &hint)) {
+        if (hint.res_class) {
+            result = hint.res_class;
+        }
+        XFree(hint.res_name);
+        XFree(hint.res_class);
+    }
+    return result;
+}
+
+bool X11Selection::fetch_metadata(Selection selection, SelectionMetadata& metadata, int timeout_ms) {
+    metadata = SelectionMetadata();
+    Window owner = XGetSelectionOwner(display_, atom_for(selection));
+    if (owner == None || !convert(selection, targets_atom_, timeout_ms)) {
+        return false;
+    }
+
+    Atom type = None;
+    int format = 0;
+    unsigned long count = 0;
+    unsigned long remaining = 0;
+    unsigned char* data = nullptr;
+    if (XGetWindowProperty(display_, window_, property_atom_, 0, 1024, True, AnyPropertyType,
+                           &type, &format, &count, &remaining, &data) != Success) {
+        return false;
+    }
+
+    // Xlib hands 32-bit items over as longs
+    bool offers_hint = false;
+    bool offers_length = false;
+    if (data && format == 32 && count > 0) {
+        Atom* atoms = reinterpret_cast<Atom*>(data);
+        std::vector<char*> names(count, nullptr);
+        if (XGetAtomNames(display_, atoms, static_cast<int>(count), names.data())) {
+            for (unsigned long i = 0; i < count; i++) {
+                metadata.targets.push_back(names[i]);
+                XFree(names[i]);
+                offers_hint = offers_hint || atoms[i] == password_hint_atom_;
+                offers_length = offers_length || atoms[i] == length_atom_;
+            }
+        }
+    }
+    if (data) {
+        XFree(data);
+    }
+
+    // KDE's convention, followed by KeePassXC and others: the value "secret"
+    std::string hint;
+    if (offers_hint && convert(selection, password_hint_atom_, timeout_ms) && read_property(hint, timeout_ms)) {
+        metadata.password_hint = hint == "secret";
+    }
+
+    // ICCCM LENGTH: few owners still answer it, but it costs nothing to ask
+    if (offers_length && convert(selection, length_atom_, timeout_ms)) {
+        data = nullptr;
+        if (XGetWindowProperty(display_, window_, property_atom_, 0, 1, True, AnyPropertyType,
+                               &type, &format, &count, &remaining, &data) == Success) {
+            if (data && format == 32 && count == 1) {
+                metadata.size = *reinterpret_cast<long*>(data);
+            }
+            if (data) {
+                XFree(data);
+            }
+        }
+    }
+
+    // Toolkits often own selections through a hidden window; its client
+    // leader carries WM_CLASS then. The owner may be gone by now; the
+    // BadWindow that follows is dropped by on_x_error().
+    metadata.owner_class = window_class(display_, owner);
+    if (metadata.owner_class.empty()) {
+        data = nullptr;
+        if (XGetWindowProperty(display_, owner, client_leader_atom_, 0, 1, False, XA_WINDOW,
+                               &type, &format, &count, &remaining, &data) == Success && data) {
+            if (format == 32 && count == 1) {
+                metadata.owner_class = window_class(display_, *reinterpret_cast<Window*>(data));
+            }
+            XFree(data);
+        }
+    }
+
+    return true;
+}
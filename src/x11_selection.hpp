@@ -0,0 +1,126 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef X11_SELECTION_HPP
+#define X11_SELECTION_HPP
+
+#include <csetjmp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "capture_event.hpp"
+#include "capture_filter.hpp"
+
+struct _XDisplay;
+
+// Private Xlib connection used by the capture thread to watch and read the
+// CLIPBOARD and PRIMARY selections without going through GTK or xclip.
+// An instance must only be used from one thread.
+//
+// Xlib's default error handlers exit the process. The first open() installs
+// process-wide handlers that keep errors on these connections to the
+// connection they happened on and hand errors on any other connection to
+// the handlers installed before (GTK's, or Xlib's own).
+class X11Selection {
+public:
+    // Open a connection to display_name (nullptr for $DISPLAY).
+    // Returns nullptr if no X server is reachable.
+    static std::unique_ptr<X11Selection> open(const char* display_name = nullptr);
+
+    ~X11Selection();
+
+    X11Selection(const X11Selection&) = delete;
+    X11Selection& operator=(const X11Selection&) = delete;
+
+    // File descriptor of the X connection, for poll()
+    int get_fd() const;
+
+    // Run body, which uses this connection, and return false if the
+    // connection is lost meanwhile. Xlib cannot carry on after an I/O error,
+    // so body is left with a longjmp: locals of the frames in between are
+    // not destroyed, which leaks what they held once per lost connection.
+    // A lost connection stays lost; later calls return false at once.
+    // Outside of this, losing the connection still exits the process.
+    bool with_connection(const std::function<void()>& body);
+
+    // Whether an I/O error ended the connection
+    bool is_lost() const;
+
+    // Subscribe to selection owner changes; false without the XFixes extension
+    bool watch_selections();
+
+    // Process queued X events and return selections whose owner changed
+    std::vector<Selection> read_changes();
+
+    // Read a selection as UTF-8 text. Returns false if there is no owner,
+    // the owner refuses the conversion or the timeout expires.
+    bool fetch_text(Selection selection, std::string& out, int timeout_ms = 1000);
+
+    // Current owner window of a selection (0 if unowned)
+    unsigned long get_owner(Selection selection) const;
+
+    // Ask the owner for the server time at which it took the selection (the
+    // TIMESTAMP target): a cheap change probe, since owners take the
+    // selection again for every copy. False if the owner does not answer
+    // with a usable time.
+    bool fetch_timestamp(Selection selection, unsigned long& timestamp, int timeout_ms = 250);
+
+    // Ask the owner what it offers (TARGETS), and for the password manager
+    // hint and LENGTH when it lists them, and read the WM_CLASS of the owner
+    // window: a few small round trips instead of the content. False if the
+    // selection is unowned or the owner does not answer TARGETS.
+    bool fetch_metadata(Selection selection, SelectionMetadata& metadata, int timeout_ms = 250);
+
+private:
+    X11Selection() = default;
+
+    // Install the process-wide handlers (once)
+    static void install_error_handlers();
+
+    // Process-wide I/O error handler: leaves with_connection() on our
+    // connections, chains to the previous handler on the others
+    static int on_io_error(_XDisplay* display);
+
+    // Wait for the next event matching the predicate, queueing owner changes
+    bool wait_for_event(int type, int timeout_ms, void* event);
+
+    // Request a conversion into our transfer property; false if the owner
+    // refuses it or does not answer in time
+    bool convert(Selection selection, unsigned long target, int timeout_ms);
+
+    // Read (and delete) our transfer property, following the INCR protocol
+    bool read_property(std::string& out, int timeout_ms);
+
+    unsigned long atom_for(Selection selection) const;
+
+    _XDisplay* display_ = nullptr;
+    unsigned long window_ = 0;
+
+    unsigned long clipboard_atom_ = 0;
+    unsigned long primary_atom_ = 0;
+    unsigned long utf8_atom_ = 0;
+    unsigned long string_atom_ = 0;
+    unsigned long incr_atom_ = 0;
+    unsigned long timestamp_atom_ = 0;
+    unsigned long targets_atom_ = 0;
+    unsigned long length_atom_ = 0;
+    unsigned long password_hint_atom_ = 0;
+    unsigned long client_leader_atom_ = 0;
+    unsigned long property_atom_ = 0;
+
+    int xfixes_event_base_ = 0;
+    bool has_xfixes_ = false;
+
+    // Owner changes seen while waiting for a transfer
+    std::vector<Selection> pending_changes_;
+
+    // Set by the I/O error handler; the jump leads out of with_connection()
+    bool lost_ = false;
+    std::jmp_buf* io_error_jump_ = nullptr;
+};
+
+#endif // X11_SELECTION_HPP
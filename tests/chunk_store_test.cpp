@@ -0,0 +1,158 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "chunk_store.hpp"
+#include "test_support.hpp"
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string random_bytes(std::mt19937& rng, size_t size) {
+    std::string data(size, '\0');
+    for (char& c : data) {
+        c = static_cast<char>(rng());
+    }
+    return data;
+}
+
+// Text that LZ4 shrinks, with enough variety for the hash to find cuts
+static std::string text_bytes(std::mt19937& rng, size_t size) {
+    static const char* const WORDS[] = {"clipboard ", "entry ", "history ", "chunk ", "pool\n", "text "};
+    std::string data;
+    while (data.size() < size) {
+        data += WORDS[rng() % 6];
+    }
+    data.resize(size);
+    return data;
+}
+
+static std::string reassemble(const ChunkList& chunks, size_t size) {
+    std::string out(size, '\0');
+    CHECK(chunk_reassemble(chunks, out.empty() ? nullptr : &out[0], size));
+    return out;
+}
+
+static void test_cut_bounds() {
+    std::mt19937 rng(7);
+    std::string data = random_bytes(rng, 1024 * 1024);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+
+    // Every chunk but the last lies within the limits
+    size_t offset = 0, count = 0;
+    while (offset < data.size()) {
+        size_t length = fastcdc_next_cut(bytes + offset, data.size() - offset);
+        CHECK(length > 0);
+        CHECK(length <= CHUNK_MAX_SIZE);
+        if (offset + length < data.size()) {
+            CHECK(length > CHUNK_MIN_SIZE);
+        }
+        offset += length;
+        ++count;
+    }
+    CHECK(offset == data.size());
+
+    // Sizes cluster around the average
+    size_t average = data.size() / count;
+    CHECK(average > CHUNK_AVG_SIZE / 2 && average < CHUNK_AVG_SIZE * 2);
+
+    // Short input is one chunk
+    CHECK(fastcdc_next_cut(bytes, CHUNK_MIN_SIZE) == CHUNK_MIN_SIZE);
+    CHECK(fastcdc_next_cut(bytes, 10) == 10);
+
+    // Input without cut points ends at the maximum
+    std::string zeros(CHUNK_MAX_SIZE * 2, '\0');
+    CHECK(fastcdc_next_cut(reinterpret_cast<const unsigned char*>(zeros.data()), zeros.size()) == CHUNK_MAX_SIZE);
+}
+
+static void test_round_trip() {
+    ChunkPool pool;
+    std::mt19937 rng(11);
+    for (size_t size : {size_t(1), CHUNK_MIN_SIZE, CHUNKING_MIN_SIZE, size_t(300 * 1024)}) {
+        std::string random = random_bytes(rng, size);
+        ChunkList chunks = pool.store(random.data(), random.size());
+        CHECK(reassemble(chunks, random.size()) == random);
+
+        std::string text = text_bytes(rng, size);
+        chunks = pool.store(text.data(), text.size());
+        CHECK(reassemble(chunks, text.size()) == text);
+        if (size >= CHUNK_MIN_SIZE) {
+            CHECK(chunks[0]->compressed);
+        }
+    }
+}
+
+static void test_sharing() {
+    ChunkPool pool;
+    std::mt19937 rng(13);
+    std::string original = random_bytes(rng, 512 * 1024);
+    ChunkList first = pool.store(original.data(), original.size());
+    size_t stored = pool.size();
+    CHECK(stored == first.size());
+
+    // The same payload again adds nothing
+    ChunkList again = pool.store(original.data(), original.size());
+    CHECK(again.size() == first.size());
+    for (size_t i = 0; i < again.size() && i < first.size(); i++) {
+        CHECK(again[i] == first[i]);
+    }
+    CHECK(pool.size() == stored);
+
+    // An insertion only changes the chunks around it
+    std::string edited = original;
+    edited.insert(edited.size() / 2, "an edit in the middle");
+    ChunkList second = pool.store(edited.data(), edited.size());
+    CHECK(reassemble(second, edited.size()) == edited);
+    CHECK(pool.size() <= stored + 2);
+    CHECK(second.front() == first.front());
+    CHECK(second.back() == first.back());
+}
+
+static void test_release() {
+    ChunkPool pool;
+    std::mt19937 rng(17);
+    {
+        ChunkList kept;
+        for (int i = 0; i < 3000; i++) {
+            std::string data = random_bytes(rng, 64);
+            ChunkRef chunk = pool.intern(data.data(), data.size());
+            if (i % 1000 == 0) {
+                kept.push_back(chunk);
+            }
+        }
+        CHECK(pool.size() == 3);
+        CHECK(pool.stored_bytes() == 3 * 64);
+    }
+    CHECK(pool.size() == 0);
+    CHECK(pool.stored_bytes() == 0);
+}
+
+static void test_reassemble_sizes() {
+    ChunkPool pool;
+    std::mt19937 rng(19);
+    std::string data = text_bytes(rng, 100 * 1024);
+    ChunkList chunks = pool.store(data.data(), data.size());
+    CHECK(chunks.size() > 1);
+
+    // The sizes must add up exactly
+    std::string out(data.size() + 1, '\0');
+    CHECK(!chunk_reassemble(chunks, &out[0], data.size() - 1));
+    CHECK(!chunk_reassemble(chunks, &out[0], data.size() + 1));
+
+    // A corrupt block is refused
+    auto broken = std::make_shared<StoredChunk>(*chunks[0]);
+    CHECK(broken->compressed);
+    broken->data.resize(broken->data.size() / 2);
+    chunks[0] = broken;
+    CHECK(!chunk_reassemble(chunks, &out[0], data.size()));
+}
+
+int main() {
+    test_cut_bounds();
+    test_round_trip();
+    test_sharing();
+    test_release();
+    test_reassemble_sizes();
+    return test_result();
+}
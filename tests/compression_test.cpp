@@ -0,0 +1,68 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "compression.hpp"
+#include "test_support.hpp"
+#include <cstdlib>
+#include <string>
+
+static void check_round_trip(const std::string& text) {
+    std::string block = lz4_compress(text.data(), text.size());
+    std::string out;
+    CHECK(lz4_decompress(block.data(), block.size(), text.size(), out));
+    CHECK(out == text);
+}
+
+static void test_round_trips() {
+    check_round_trip("");
+    check_round_trip("a");
+    check_round_trip("short text");
+
+    std::string repeated;
+    for (int i = 0; i < 5000; i++) {
+        repeated += "line " + std::to_string(i % 37) + " of a log file\n";
+    }
+    check_round_trip(repeated);
+    CHECK(lz4_compress(repeated.data(), repeated.size()).size() < repeated.size() / 4);
+
+    std::string noise;
+    srand(7);
+    for (int i = 0; i < 100000; i++) {
+        noise.push_back(static_cast<char>(rand()));
+    }
+    check_round_trip(noise);
+}
+
+static void test_rejects_bad_sizes() {
+    std::string text(10000, 'x');
+    std::string block = lz4_compress(text.data(), text.size());
+    std::string out;
+
+    // The block must expand to exactly raw_size bytes
+    CHECK(!lz4_decompress(block.data(), block.size(), text.size() - 1, out));
+    CHECK(!lz4_decompress(block.data(), block.size(), text.size() + 1, out));
+
+    // Sizes no block of this length can reach are refused before allocating
+    CHECK(!lz4_decompress(block.data(), block.size(), static_cast<size_t>(1) << 60, out));
+    CHECK(out.empty());
+}
+
+static void test_rejects_truncated_blocks() {
+    std::string text;
+    for (int i = 0; i < 1000; i++) {
+        text += std::to_string(i * 7919);
+    }
+    std::string block = lz4_compress(text.data(), text.size());
+    std::string out;
+    for (size_t cut = 0; cut < block.size(); cut += 17) {
+        CHECK(!lz4_decompress(block.data(), cut, text.size(), out));
+    }
+}
+
+int main() {
+    test_round_trips();
+    test_rejects_bad_sizes();
+    test_rejects_truncated_blocks();
+    return test_result();
+}
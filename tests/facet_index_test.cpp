@@ -0,0 +1,179 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "facet_index.hpp"
+#include "content_facets.hpp"
+#include "test_support.hpp"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Sample {
+    const char* text;
+    FacetMask facets;
+};
+
+static const FacetMask URL = facet_bit(Facet::URL);
+static const FacetMask PATH = facet_bit(Facet::PATH);
+static const FacetMask EMAIL = facet_bit(Facet::EMAIL);
+static const FacetMask NUMBER = facet_bit(Facet::NUMBER);
+static const FacetMask COLOR = facet_bit(Facet::COLOR);
+static const FacetMask JSON = facet_bit(Facet::JSON);
+static const FacetMask CODE = facet_bit(Facet::CODE);
+static const FacetMask MULTILINE = facet_bit(Facet::MULTILINE);
+
+static const Sample SAMPLES[] = {
+    {"https://example.com/a?b=1", URL},
+    {"  www.example.org\n", URL},
+    {"file:///etc/hosts", URL},
+    {"http:///etc/hosts", 0},
+    {"https://example.com/a b", 0},
+    {"user.name+tag@mail.example.com", EMAIL},
+    {"mailto:someone@example.io", EMAIL},
+    {"a@b", 0},
+    {"a@b.c1", 0},
+    {"a..b@example.com", 0},
+    {"/usr/local/bin", PATH},
+    {"~/notes.txt", PATH},
+    {"C:\\Windows\\System32", PATH},
+    {"src/main.cpp", PATH},
+    {"and/or", 0},
+    {"1/2/3", 0},
+    {"42", NUMBER},
+    {"-3.5", NUMBER},
+    {"1,234.56", NUMBER},
+    {"1.234,56", NUMBER},
+    {"1_000_000", NUMBER},
+    {"6.02e23", NUMBER},
+    {"15%", NUMBER},
+    {"0xff", NUMBER},
+    {"12,34,5", 0},
+    {"1.2.3", 0},
+    {"6.02e", 0},
+    {"#ff8800", COLOR},
+    {"#fff", COLOR},
+    {"rgb(255, 0, 0)", COLOR},
+    {"hsla(120deg 50% 50% / 0.5)", COLOR},
+    {"#12345", 0},
+    {"rgb(red)", 0},
+    {"{\"a\": [1, 2.5e3, true, null], \"b\": \"x\"}", JSON},
+    {"[1, 2", 0},
+    {"{\"a\": 1} trailing", 0},
+    {"[true, nope]", 0},
+    {"int main() {\n    return 0;\n}\n", static_cast<FacetMask>(CODE | MULTILINE)},
+    {"const x = 1", CODE},
+    {"Hello there\nhow are you", MULTILINE},
+    {"Just a sentence, with a comma.", 0},
+    {"   ", 0},
+    {"", 0},
+};
+
+static void test_classify() {
+    for (const Sample& sample : SAMPLES) {
+        FacetMask facets = classify_content(sample.text);
+        CHECK(facets == sample.facets);
+        if (facets != sample.facets) {
+            fprintf(stderr, "  for \"%s\": got %#x\n", sample.text, facets);
+        }
+    }
+}
+
+// The vector pre-scan must see bytes at any position and in the tail
+static void test_scan_positions() {
+    for (size_t before = 0; before < 80; before++) {
+        for (size_t after = 1; after < 80; after += 7) {
+            std::string text = std::string(before + 1, 'a') + "\n" + std::string(after, 'b');
+            CHECK(classify_content(text) == MULTILINE);
+
+            std::string path = std::string(before + 1, 'a') + "/" + std::string(after, 'b') + ".txt";
+            CHECK(classify_content(path) == PATH);
+        }
+    }
+}
+
+static void test_names() {
+    for (size_t i = 0; i < FACET_COUNT; i++) {
+        Facet facet;
+        CHECK(facet_from_name(facet_name(static_cast<Facet>(i)), facet));
+        CHECK(facet == static_cast<Facet>(i));
+    }
+    Facet facet;
+    CHECK(!facet_from_name("URL", facet));
+    CHECK(!facet_from_name("", facet));
+}
+
+static bool has_all(FacetMask facets, FacetMask wanted) {
+    return (facets & wanted) == wanted;
+}
+
+// select and filter against a scan of the entries
+static void test_index() {
+    std::mt19937 rng(23);
+    const size_t sample_count = sizeof(SAMPLES) / sizeof(SAMPLES[0]);
+
+    for (size_t size : {size_t(0), size_t(1), size_t(63), size_t(64), size_t(65), size_t(300)}) {
+        std::vector<std::shared_ptr<ClipboardEntry>> entries;
+        for (size_t i = 0; i < size; i++) {
+            const char* text = SAMPLES[rng() % sample_count].text;
+            entries.push_back(std::make_shared<ClipboardEntry>(std::make_shared<const std::string>(text)));
+        }
+
+        FacetIndex index;
+        index.build(entries);
+        CHECK(index.size() == size);
+
+        for (int round = 0; round < 50; round++) {
+            FacetMask wanted = static_cast<FacetMask>(rng() % (1u << FACET_COUNT));
+            if (round % 3 != 0) {
+                wanted &= static_cast<FacetMask>(rng());
+            }
+
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < size; i++) {
+                if (has_all(entries[i]->get_facets(), wanted)) {
+                    expected.push_back(i);
+                }
+            }
+            std::vector<size_t> selected = {12345};
+            index.select(wanted, selected);
+            CHECK(selected == expected);
+
+            // Filter a random subset, plus an index past the end
+            std::vector<size_t> matches;
+            std::vector<size_t> kept;
+            for (size_t i = 0; i < size; i++) {
+                if (rng() % 2) {
+                    matches.push_back(i);
+                    if (wanted == 0 || has_all(entries[i]->get_facets(), wanted)) {
+                        kept.push_back(i);
+                    }
+                }
+            }
+            matches.push_back(size + 5);
+            if (wanted == 0) {
+                kept.push_back(size + 5);
+            }
+            index.filter(wanted, matches);
+            CHECK(matches == kept);
+        }
+    }
+
+    FacetIndex index;
+    index.build({std::make_shared<ClipboardEntry>(std::make_shared<const std::string>("42"))});
+    index.clear();
+    std::vector<size_t> selected;
+    index.select(NUMBER, selected);
+    CHECK(index.size() == 0);
+    CHECK(selected.empty());
+}
+
+int main() {
+    test_classify();
+    test_scan_positions();
+    test_names();
+    test_index();
+    return test_result();
+}
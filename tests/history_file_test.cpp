@@ -0,0 +1,156 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "history_file.hpp"
+#include "test_support.hpp"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct Written {
+    std::time_t timestamp;
+    std::time_t expiry;
+    bool pinned;
+    std::string text;
+};
+
+// Write texts through write_history_text and read them back
+static std::vector<HistoryRecord> round_trip(const std::vector<Written>& entries, size_t compress_min) {
+    FILE* file = tmpfile();
+    for (const Written& entry : entries) {
+        write_history_text(file, entry.timestamp, entry.expiry, entry.text, compress_min, entry.pinned);
+    }
+    rewind(file);
+
+    std::vector<HistoryRecord> records;
+    HistoryFileReader reader(file);
+    HistoryRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    fclose(file);
+    return records;
+}
+
+static std::vector<HistoryRecord> read_text(const std::string& content) {
+    FILE* file = tmpfile();
+    fwrite(content.data(), 1, content.size(), file);
+    rewind(file);
+
+    std::vector<HistoryRecord> records;
+    HistoryFileReader reader(file);
+    HistoryRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    fclose(file);
+    return records;
+}
+
+static void check_texts(const std::vector<Written>& entries, size_t compress_min) {
+    std::vector<HistoryRecord> records = round_trip(entries, compress_min);
+    CHECK(records.size() == entries.size());
+    for (size_t i = 0; i < records.size() && i < entries.size(); i++) {
+        std::string text;
+        CHECK(records[i].get_text(text));
+        CHECK(text == entries[i].text);
+        CHECK(records[i].has_times);
+        CHECK(records[i].timestamp == entries[i].timestamp);
+        CHECK(records[i].expiry == entries[i].expiry);
+        CHECK(records[i].pinned == entries[i].pinned);
+    }
+}
+
+static void test_plain_and_compressed() {
+    std::string log;
+    for (int i = 0; i < 200; i++) {
+        log += "2025-06-02 12:00:" + std::to_string(i % 60) + " request served\n";
+    }
+    std::vector<Written> entries = {
+        {100, 0, false, "hello"},
+        {200, 260, true, "two\nlines"},
+        {300, 0, false, log},
+        {400, 0, false, "trailing newline\n"},
+        {500, 0, false, "\nleading and\n\ninner blank lines"},
+        {600, 0, true, "\n"},
+    };
+    check_texts(entries, 256);
+    check_texts(entries, 1);
+    check_texts(entries, static_cast<size_t>(-1));
+}
+
+// Copied text that looks like the file's own markers stays text
+static void test_marker_shaped_text() {
+    std::vector<Written> entries = {
+        {1, 0, false, "notes\n---ENTRY_LZ4 5 3---\nend"},
+        {2, 0, false, "before\n---ENTRY_END---\nafter"},
+        {3, 0, false, "---ENTRY_START---"},
+        {4, 0, false, "x\n---ENTRY_META 1 2 1---\n---CHUNK 0 1 1 0---\n---ENTRY_CHUNKS 1 1---\ny"},
+        {5, 0, false, "---ENTRY_LZ4 5 99999999999999---"},
+        {6, 0, false, "-- a dashed line\n--- and a rule"},
+        {7, 0, false, "last"},
+    };
+    check_texts(entries, static_cast<size_t>(-1));
+    check_texts(entries, 256);
+}
+
+static void test_chunked() {
+    std::string text;
+    for (int i = 0; i < 20000; i++) {
+        text += "row " + std::to_string(i * 31) + ",";
+    }
+    ChunkList chunks = ChunkPool::shared().store(text.data(), text.size());
+    CHECK(chunks.size() > 1);
+
+    FILE* file = tmpfile();
+    WrittenChunks written;
+    write_history_chunks(file, 10, 0, chunks, text.size(), written, true);
+    write_history_chunks(file, 11, 0, chunks, text.size(), written);
+    rewind(file);
+
+    HistoryFileReader reader(file);
+    HistoryRecord record;
+    for (int i = 0; i < 2; i++) {
+        CHECK(reader.next(record));
+        CHECK(record.chunked);
+        CHECK(record.pinned == (i == 0));
+        std::string out;
+        CHECK(record.get_text(out));
+        CHECK(out == text);
+    }
+    CHECK(!reader.next(record));
+    fclose(file);
+}
+
+// Corrupt headers end the file instead of allocating their sizes
+static void test_corrupt_sizes() {
+    std::vector<HistoryRecord> records = read_text(
+        "---ENTRY_START---\nkept\n---ENTRY_END---\n"
+        "---ENTRY_LZ4 5 99999999999999---\nxyz\n---ENTRY_END---\n"
+        "---ENTRY_START---\nlost\n---ENTRY_END---\n");
+    CHECK(records.size() == 1);
+
+    records = read_text("---ENTRY_LZ4 99999999999 3---\nabc\n---ENTRY_END---\n");
+    CHECK(records.size() == 0);
+
+    records = read_text("---ENTRY_CHUNKS 10 99999999999---\n1 2 3\n---ENTRY_END---\n");
+    CHECK(records.size() == 0);
+
+    records = read_text("---CHUNK 0 5 99999999999 0---\nabcde\n");
+    CHECK(records.size() == 0);
+
+    // A plausible header over a block that does not expand to it
+    records = read_text("---ENTRY_LZ4 900000 3---\nabc\n---ENTRY_END---\n");
+    CHECK(records.size() == 1);
+    std::string text;
+    CHECK(records.size() == 1 && !records[0].get_text(text));
+}
+
+int main() {
+    test_plain_and_compressed();
+    test_marker_shaped_text();
+    test_chunked();
+    test_corrupt_sizes();
+    return test_result();
+}
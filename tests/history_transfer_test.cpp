@@ -0,0 +1,208 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "history_transfer.hpp"
+#include "history_file.hpp"
+#include "test_support.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+struct Entry {
+    std::time_t timestamp;
+    std::time_t expiry;
+    bool pinned;
+    std::string text;
+};
+
+static std::string history_path;
+static std::string export_path;
+
+// Run the command line as main() would
+static int run(std::vector<std::string> args) {
+    args.insert(args.begin(), "clipboard_manager");
+    std::vector<char*> argv;
+    for (std::string& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+    return run_transfer_command(static_cast<int>(args.size()), argv.data());
+}
+
+static void write_history(const std::vector<Entry>& entries) {
+    FILE* file = fopen(history_path.c_str(), "wb");
+    for (const Entry& entry : entries) {
+        write_history_text(file, entry.timestamp, entry.expiry, entry.text, HISTORY_COMPRESS_MIN_SIZE,
+                           entry.pinned);
+    }
+    fclose(file);
+}
+
+static std::vector<Entry> read_history() {
+    std::vector<Entry> entries;
+    FILE* file = fopen(history_path.c_str(), "rb");
+    if (!file) {
+        return entries;
+    }
+    HistoryFileReader reader(file);
+    HistoryRecord record;
+    while (reader.next(record)) {
+        Entry entry = {record.timestamp, record.expiry, record.pinned, ""};
+        CHECK(record.get_text(entry.text));
+        entries.push_back(entry);
+    }
+    fclose(file);
+    return entries;
+}
+
+static void write_file(const std::string& path, const std::string& content) {
+    FILE* file = fopen(path.c_str(), "wb");
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+}
+
+static std::vector<Entry> sample_entries(std::time_t now) {
+    std::string large;
+    for (int i = 0; i < 200; i++) {
+        large += "line " + std::to_string(i) + "\n";
+    }
+    return {
+        {now - 10, 0, true, "pinned text"},
+        {now - 20, now + 3600, false, "quote \" backslash \\ tab \t newline \n end"},
+        {now - 30, 0, false, "na\xC3\xA7\xC3\xA3o \xF0\x9F\x93\x8B"},
+        {now - 40, 0, false, large},
+        {now - 50, 0, false, "---ENTRY_END---"},
+    };
+}
+
+// Export, empty the history and import again: everything comes back
+static void check_round_trip(const char* format) {
+    std::vector<Entry> entries = sample_entries(std::time(nullptr));
+    write_history(entries);
+    CHECK(run({"--export", format, export_path}) == 0);
+
+    unlink(history_path.c_str());
+    CHECK(run({"--import", format, export_path}) == 0);
+
+    std::vector<Entry> imported = read_history();
+    CHECK(imported.size() == entries.size());
+    for (size_t i = 0; i < imported.size() && i < entries.size(); i++) {
+        CHECK(imported[i].text == entries[i].text);
+        CHECK(imported[i].timestamp == entries[i].timestamp);
+        CHECK(imported[i].expiry == entries[i].expiry);
+        CHECK(imported[i].pinned == entries[i].pinned);
+    }
+}
+
+static void test_round_trip() {
+    check_round_trip("--format=jsonl");
+    check_round_trip("--format=binary");
+}
+
+static void test_filters() {
+    std::time_t now = std::time(nullptr);
+    write_history(sample_entries(now));
+
+    // Entries of 20 bytes or more, created in the last 35 seconds
+    CHECK(run({"--export", "--min-size=20", "--since=" + std::to_string(now - 35), export_path}) == 0);
+    unlink(history_path.c_str());
+    CHECK(run({"--import", export_path}) == 0);
+
+    std::vector<Entry> imported = read_history();
+    CHECK(imported.size() == 1);
+    CHECK(imported.size() == 1 && imported[0].timestamp == now - 20);
+
+    // --max-size and --until on the way in
+    write_history(sample_entries(now));
+    CHECK(run({"--export", export_path}) == 0);
+    unlink(history_path.c_str());
+    CHECK(run({"--import", "--max-size=12", "--until=" + std::to_string(now - 15), export_path}) == 0);
+    imported = read_history();
+    CHECK(imported.size() == 1);
+    CHECK(imported.size() == 1 && imported[0].timestamp == now - 30);
+}
+
+static void test_merge() {
+    std::time_t now = std::time(nullptr);
+    write_history({{now - 1000, 0, false, "already here"}, {now - 2000, 0, true, "kept pinned"}});
+
+    // A newer copy of an existing entry, a pinned copy of another, then
+    // more entries than the history holds
+    std::string input = "{\"timestamp\":" + std::to_string(now - 5) + ",\"text\":\"already here\"}\n"
+                        "{\"timestamp\":" + std::to_string(now - 3000) + ",\"pinned\":true,\"text\":\"kept pinned\"}\n"
+                        "{\"text\":\"caf\\u00e9 \\ud83d\\udccb\",\"timestamp\":" + std::to_string(now - 6) + "}\n"
+                        "not json\n";
+    for (size_t i = 0; i < HISTORY_MAX_ENTRIES; i++) {
+        input += "{\"timestamp\":" + std::to_string(now - 100 - static_cast<std::time_t>(i)) +
+                 ",\"text\":\"entry " + std::to_string(i) + "\"}\n";
+    }
+    write_file(export_path, input);
+    CHECK(run({"--import", export_path}) == 0);
+
+    std::vector<Entry> imported = read_history();
+    CHECK(imported.size() == HISTORY_MAX_ENTRIES);
+    size_t already = 0, pinned = 0;
+    bool escaped = false;
+    for (size_t i = 0; i < imported.size(); i++) {
+        if (i > 0) {
+            CHECK(imported[i - 1].timestamp >= imported[i].timestamp);
+        }
+        if (imported[i].text == "already here") {
+            ++already;
+            CHECK(imported[i].timestamp == now - 5);
+        }
+        if (imported[i].text == "kept pinned") {
+            ++pinned;
+            CHECK(imported[i].pinned);
+            CHECK(imported[i].timestamp == now - 2000);
+        }
+        if (imported[i].text == "caf\xC3\xA9 \xF0\x9F\x93\x8B") {
+            escaped = true;
+        }
+    }
+    CHECK(already == 1);
+    CHECK(pinned == 1);
+    CHECK(escaped);
+}
+
+static void test_bad_input() {
+    write_history({{std::time(nullptr), 0, false, "untouched"}});
+
+    CHECK(run({"--export", "--format=xml"}) == 2);
+    CHECK(run({"--import", "--archive", export_path}) == 2);
+    CHECK(run({"--import", "--min-size=big", export_path}) == 2);
+
+    // A binary import of something that is not a binary export
+    write_file(export_path, "{\"text\":\"x\"}\n");
+    CHECK(run({"--import", "--format=binary", export_path}) == 1);
+
+    std::vector<Entry> history = read_history();
+    CHECK(history.size() == 1 && history[0].text == "untouched");
+}
+
+int main() {
+    char dir[] = "/tmp/vmcastle_transfer_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    history_path = std::string(dir) + "/history";
+    export_path = std::string(dir) + "/export";
+    setenv("VMCASTLE_HISTORY_FILE", history_path.c_str(), 1);
+    unsetenv("VMCASTLE_HISTORY_TTL_DAYS");
+    unsetenv("VMCASTLE_SECRET_TTL");
+
+    test_round_trip();
+    test_filters();
+    test_merge();
+    test_bad_input();
+
+    unlink(history_path.c_str());
+    unlink(export_path.c_str());
+    rmdir(dir);
+    return test_result();
+}
@@ -0,0 +1,152 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "line_index.hpp"
+#include "entry_content.hpp"
+#include "test_support.hpp"
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool is_continuation(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// Display lines of text, found the simple way
+static std::vector<std::string> reference_lines(const std::string& text) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t newline = text.find('\n', start);
+        size_t end = newline == std::string::npos ? text.size() : newline;
+        while (end - start > LineIndex::MAX_LINE_BYTES) {
+            size_t cut = start + LineIndex::MAX_LINE_BYTES;
+            size_t back = 0;
+            while (back < 3 && is_continuation(text[cut - back])) {
+                ++back;
+            }
+            lines.push_back(text.substr(start, cut - back - start));
+            start = cut - back;
+        }
+        std::string line = text.substr(start, end - start);
+        while (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        lines.push_back(line);
+        start = end + 1;
+    }
+    return lines;
+}
+
+// Lines of random lengths, some far longer than MAX_LINE_BYTES, mixing
+// characters of every UTF-8 length
+static std::string random_text(std::mt19937& rng, size_t size) {
+    static const char* const PIECES[] = {"a", "word ", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x93\x8B"};
+    std::string text;
+    while (text.size() < size) {
+        size_t length = rng() % 8 == 0 ? rng() % 5000 : rng() % 120;
+        size_t end = text.size() + length;
+        while (text.size() < end) {
+            text += PIECES[rng() % 5];
+        }
+        text += rng() % 10 == 0 ? "\r\n" : "\n";
+    }
+    return text;
+}
+
+static void wait_complete(const LineIndex& index) {
+    while (!index.is_complete()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static void check_lines(std::shared_ptr<ClipboardEntry> entry, const std::string& text) {
+    LineIndex index(std::make_shared<EntryContent>(*entry));
+    index.start();
+    wait_complete(index);
+
+    std::vector<std::string> expected = reference_lines(text);
+    CHECK(index.get_line_count() == expected.size());
+    std::string line;
+    for (size_t i = 0; i < expected.size(); i++) {
+        CHECK(index.get_line(i, line));
+        CHECK(line == expected[i]);
+        CHECK(line.size() <= LineIndex::MAX_LINE_BYTES);
+    }
+    CHECK(!index.get_line(expected.size(), line));
+}
+
+static std::shared_ptr<ClipboardEntry> make_entry(const std::string& text) {
+    return std::make_shared<ClipboardEntry>(std::make_shared<const std::string>(text));
+}
+
+static void test_small() {
+    check_lines(make_entry(""), "");
+    check_lines(make_entry("one line"), "one line");
+    check_lines(make_entry("ends\n"), "ends\n");
+    check_lines(make_entry("a\n\nb\r\nc"), "a\n\nb\r\nc");
+
+    // A character that straddles the cut moves to the next line
+    std::string text = std::string(LineIndex::MAX_LINE_BYTES - 1, 'x') + "\xF0\x9F\x93\x8B" + "y";
+    check_lines(make_entry(text), text);
+    std::vector<std::string> expected = reference_lines(text);
+    CHECK(expected.size() == 2);
+    CHECK(expected.size() == 2 && expected[1] == "\xF0\x9F\x93\x8By");
+}
+
+// Several scan blocks: lines and cut positions fall across block edges
+static void test_large() {
+    std::mt19937 rng(31);
+
+    // One line longer than MAX_LINE_BYTES across the first block edge;
+    // entries repair invalid UTF-8, so the text is only cut after ASCII
+    std::string text = random_text(rng, LineIndex::SCAN_BLOCK_SIZE);
+    text.resize(LineIndex::SCAN_BLOCK_SIZE - 2000);
+    while (!text.empty() && static_cast<unsigned char>(text.back()) >= 0x80) {
+        text.pop_back();
+    }
+    text += std::string(4000, 'z');
+    text += random_text(rng, 2 * LineIndex::SCAN_BLOCK_SIZE);
+
+    check_lines(make_entry(text), text);
+    ChunkList chunks = ChunkPool::shared().store(text.data(), text.size());
+    check_lines(ClipboardEntry::from_chunks(chunks, text.size()), text);
+
+    // A cut one byte into the second block, inside a character that
+    // started in the first
+    size_t line_start = LineIndex::SCAN_BLOCK_SIZE + 1 - LineIndex::MAX_LINE_BYTES;
+    std::string edge;
+    while (edge.size() + 100 < line_start) {
+        edge += std::string(99, 'f') + "\n";
+    }
+    edge += std::string(line_start - edge.size() - 1, 'f') + "\n";
+    edge += std::string(LineIndex::SCAN_BLOCK_SIZE - 2 - line_start, 'x') + "\xF0\x9F\x93\x8B" + std::string(2000, 'y');
+    check_lines(make_entry(edge), edge);
+    std::vector<std::string> expected = reference_lines(edge);
+    CHECK(expected.size() > 3 && expected[expected.size() - 2].compare(0, 4, "\xF0\x9F\x93\x8B") == 0);
+}
+
+// The destructor stops a worker that is still running
+static void test_cancel() {
+    std::mt19937 rng(37);
+    std::string text = random_text(rng, 8 * LineIndex::SCAN_BLOCK_SIZE);
+    auto content = std::make_shared<EntryContent>(*make_entry(text));
+    for (int i = 0; i < 5; i++) {
+        LineIndex index(content);
+        index.start();
+    }
+    LineIndex never_started(content);
+    CHECK(never_started.get_line_count() == 0);
+    CHECK(!never_started.is_complete());
+}
+
+int main() {
+    test_small();
+    test_large();
+    test_cancel();
+    return test_result();
+}
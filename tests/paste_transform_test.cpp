@@ -0,0 +1,199 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "paste_transform.hpp"
+#include "entry_content.hpp"
+#include "test_support.hpp"
+#include "text_hash.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::mt19937 rng(29);
+
+// Feed text to a fresh stage in blocks of random sizes
+static bool run_stage(PasteTransform transform, const std::string& text, std::string& out, size_t max_block) {
+    std::unique_ptr<TransformStage> stage = make_transform_stage(transform);
+    out.clear();
+    size_t offset = 0;
+    while (offset < text.size()) {
+        size_t length = std::min(text.size() - offset, 1 + rng() % max_block);
+        if (!stage->push(text.data() + offset, length, out)) {
+            return false;
+        }
+        offset += length;
+    }
+    return stage->finish(out);
+}
+
+// The output must not depend on where the blocks end
+static void check_stage(PasteTransform transform, const std::string& text, const std::string& expected) {
+    for (size_t max_block : {size_t(1), size_t(2), size_t(3), size_t(7), text.size() + 1}) {
+        std::string out;
+        CHECK(run_stage(transform, text, out, max_block));
+        CHECK(out == expected);
+        if (out != expected) {
+            fprintf(stderr, "  transform %d of \"%s\": got \"%s\"\n", static_cast<int>(transform), text.c_str(),
+                    out.c_str());
+        }
+    }
+}
+
+static void check_rejected(PasteTransform transform, const std::string& text) {
+    for (size_t max_block : {size_t(1), size_t(3), text.size() + 1}) {
+        std::string out;
+        CHECK(!run_stage(transform, text, out, max_block));
+    }
+}
+
+static void test_trim() {
+    check_stage(PasteTransform::TRIM, "  \t hello  world \n\r\n", "hello  world");
+    check_stage(PasteTransform::TRIM, "no blanks", "no blanks");
+    check_stage(PasteTransform::TRIM, " \n\t ", "");
+    check_stage(PasteTransform::TRIM, "", "");
+}
+
+static void test_single_line() {
+    check_stage(PasteTransform::SINGLE_LINE, "first line\nsecond line", "first line second line");
+    check_stage(PasteTransform::SINGLE_LINE, "a  \r\n\t  b", "a b");
+    check_stage(PasteTransform::SINGLE_LINE, "\n\n  indented\n\n", "indented");
+    check_stage(PasteTransform::SINGLE_LINE, "  kept  blanks\t", "  kept  blanks\t");
+}
+
+static void test_json_pretty() {
+    check_stage(PasteTransform::JSON_PRETTY, "{\"a\":1,\"b\":[true,null],\"c\":{}, \"d\": [ ]}",
+                "{\n  \"a\": 1,\n  \"b\": [\n    true,\n    null\n  ],\n  \"c\": {},\n  \"d\": []\n}");
+    check_stage(PasteTransform::JSON_PRETTY, "[\"x, {y}\", \"q\\\"[\"]", "[\n  \"x, {y}\",\n  \"q\\\"[\"\n]");
+    check_stage(PasteTransform::JSON_PRETTY, "{", "{");
+    check_stage(PasteTransform::JSON_PRETTY, "plain text", "plaintext");
+}
+
+static void test_url_decode() {
+    check_stage(PasteTransform::URL_DECODE, "a%20b%2Fc%2f", "a b/c/");
+    check_stage(PasteTransform::URL_DECODE, "100% sure", "100% sure");
+    check_stage(PasteTransform::URL_DECODE, "%4x%%41", "%4x%A");
+    check_stage(PasteTransform::URL_DECODE, "end%", "end%");
+    check_stage(PasteTransform::URL_DECODE, "end%4", "end%4");
+    check_stage(PasteTransform::URL_DECODE, "%C3%A7", "\xC3\xA7");
+}
+
+static std::string base64_encode(const std::string& data, bool url_safe, bool padded) {
+    const char* alphabet = url_safe ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+                                    : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t quad = static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << 16;
+        if (i + 1 < data.size()) {
+            quad |= static_cast<uint32_t>(static_cast<unsigned char>(data[i + 1])) << 8;
+        }
+        if (i + 2 < data.size()) {
+            quad |= static_cast<unsigned char>(data[i + 2]);
+        }
+        size_t chars = std::min<size_t>(4, data.size() - i + 1);
+        for (size_t k = 0; k < 4; k++) {
+            if (k < chars) {
+                out.push_back(alphabet[(quad >> (18 - 6 * k)) & 63]);
+            } else if (padded) {
+                out.push_back('=');
+            }
+        }
+    }
+    return out;
+}
+
+static void test_base64_decode() {
+    check_stage(PasteTransform::BASE64_DECODE, "aGVsbG8gd29ybGQ=", "hello world");
+    check_stage(PasteTransform::BASE64_DECODE, "aGVs\n bG8g\r\nd29y\tbGQ", "hello world");
+    check_stage(PasteTransform::BASE64_DECODE, "", "");
+
+    // Random bytes in both alphabets, with and without padding
+    for (int round = 0; round < 200; round++) {
+        std::string data(rng() % 40, '\0');
+        for (char& c : data) {
+            c = static_cast<char>(rng());
+        }
+        check_stage(PasteTransform::BASE64_DECODE, base64_encode(data, round % 2, round % 3 != 0), data);
+    }
+
+    check_rejected(PasteTransform::BASE64_DECODE, "aGVs$G8=");
+    check_rejected(PasteTransform::BASE64_DECODE, "aGVsb");
+    check_rejected(PasteTransform::BASE64_DECODE, "aG==bG8=");
+}
+
+static void test_case() {
+    check_stage(PasteTransform::UPPERCASE, "Mixed Case 123", "MIXED CASE 123");
+    check_stage(PasteTransform::LOWERCASE, "Mixed Case 123", "mixed case 123");
+
+    // Multibyte characters split across blocks map like whole ones, and
+    // invalid bytes pass through
+    std::string text = "a\xC3\xA7\xE2\x82\xAC\xF0\x9F\x93\x8B b \xFF\xC3 z";
+    for (PasteTransform transform : {PasteTransform::UPPERCASE, PasteTransform::LOWERCASE}) {
+        std::string whole;
+        CHECK(run_stage(transform, text, whole, text.size() + 1));
+        check_stage(transform, text, whole);
+        CHECK(whole.find("\xF0\x9F\x93\x8B") != std::string::npos);
+        CHECK(whole.find("\xFF") != std::string::npos);
+    }
+}
+
+// A chunked payload read in blocks through a pipeline of stages
+static void test_run() {
+    std::string text = "   ";
+    while (text.size() < 3 * TRANSFORM_BLOCK_SIZE) {
+        text += "some Text%20to decode\n";
+    }
+    text += "\n\n";
+    std::string expected;
+    for (size_t i = 0; i + 2 < text.size(); i++) {
+        if (text.compare(i, 3, "%20") == 0) {
+            expected += ' ';
+            i += 2;
+        } else {
+            expected += text[i] == '\n' ? ' ' : static_cast<char>(toupper(text[i]));
+        }
+    }
+    expected.pop_back();
+
+    ChunkList chunks = ChunkPool::shared().store(text.data(), text.size());
+    std::shared_ptr<ClipboardEntry> entry = ClipboardEntry::from_chunks(chunks, text.size());
+    EntryContent content(*entry);
+
+    std::string out;
+    TransformedSize result;
+    size_t calls = 0;
+    CHECK(run_paste_transforms(content, {PasteTransform::URL_DECODE, PasteTransform::SINGLE_LINE,
+                                         PasteTransform::UPPERCASE},
+                               [&](const char* data, size_t size) {
+                                   out.append(data, size);
+                                   ++calls;
+                                   return true;
+                               },
+                               &result));
+    CHECK(out == expected);
+    CHECK(calls > 1);
+    CHECK(result.size == expected.size());
+    CHECK(result.hash == hash_text(expected));
+
+    // A sink may stop the run, and so may a stage
+    calls = 0;
+    CHECK(!run_paste_transforms(content, {}, [&](const char*, size_t) { return ++calls < 2; }));
+    CHECK(calls == 2);
+    CHECK(!run_paste_transforms(content, {PasteTransform::BASE64_DECODE},
+                                [](const char*, size_t) { return true; }));
+}
+
+int main() {
+    test_trim();
+    test_single_line();
+    test_json_pretty();
+    test_url_decode();
+    test_base64_decode();
+    test_case();
+    test_run();
+    return test_result();
+}
@@ -0,0 +1,191 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+// Runs the tray menu against a private dbus-daemon (GTestDBus) and checks
+// which signals a host sees as the items change.
+
+#include "status_notifier.hpp"
+#include "test_support.hpp"
+#include <gio/gio.h>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+static const char* const MENU_PATH = "/MenuBar";
+static const char* const MENU_INTERFACE = "com.canonical.dbusmenu";
+
+// Signals the host side received
+struct HostSignals {
+    int layout_updated = 0;
+    int properties_updated = 0;
+    std::vector<int32_t> updated_ids;
+};
+
+static void on_menu_signal(GDBusConnection* connection, const gchar* sender, const gchar* path,
+                           const gchar* interface, const gchar* signal, GVariant* parameters,
+                           gpointer user_data) {
+    (void)connection;
+    (void)sender;
+    (void)path;
+    (void)interface;
+    HostSignals* signals = static_cast<HostSignals*>(user_data);
+    if (strcmp(signal, "LayoutUpdated") == 0) {
+        signals->layout_updated++;
+    } else if (strcmp(signal, "ItemsPropertiesUpdated") == 0) {
+        signals->properties_updated++;
+        GVariant* updated = g_variant_get_child_value(parameters, 0);
+        for (gsize i = 0; i < g_variant_n_children(updated); ++i) {
+            GVariant* item = g_variant_get_child_value(updated, i);
+            int32_t id = 0;
+            g_variant_get_child(item, 0, "i", &id);
+            signals->updated_ids.push_back(id);
+            g_variant_unref(item);
+        }
+        g_variant_unref(updated);
+    }
+}
+
+// The item answers from this thread's main context, so run it while waiting
+static bool wait_for(const std::function<bool()>& done) {
+    gint64 deadline = g_get_monotonic_time() + 5 * G_USEC_PER_SEC;
+    while (!done() && g_get_monotonic_time() < deadline) {
+        if (!g_main_context_iteration(nullptr, FALSE)) {
+            g_usleep(1000);
+        }
+    }
+    return done();
+}
+
+struct PendingCall {
+    GVariant* reply = nullptr;
+    bool done = false;
+};
+
+static GVariant* call_menu(GDBusConnection* host, const char* item, const char* method, GVariant* arguments,
+                           const char* reply_type) {
+    PendingCall call;
+    g_dbus_connection_call(host, item, MENU_PATH, MENU_INTERFACE, method, arguments, G_VARIANT_TYPE(reply_type),
+                           G_DBUS_CALL_FLAGS_NONE, 5000, nullptr,
+                           +[](GObject* source, GAsyncResult* result, gpointer user_data) {
+                               PendingCall* call = static_cast<PendingCall*>(user_data);
+                               call->reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), result, nullptr);
+                               call->done = true;
+                           }, &call);
+    wait_for([&call]() { return call.done; });
+    return call.reply;
+}
+
+// Revision and ids of the root's children, as GetLayout reports them
+static std::vector<int32_t> layout_ids(GDBusConnection* host, const char* item, uint32_t& revision) {
+    std::vector<int32_t> ids;
+    const char* no_properties[] = {nullptr};
+    GVariant* reply = call_menu(host, item, "GetLayout", g_variant_new("(ii^as)", 0, -1, no_properties),
+                                "(u(ia{sv}av))");
+    if (!reply) {
+        return ids;
+    }
+    g_variant_get_child(reply, 0, "u", &revision);
+    GVariant* layout = g_variant_get_child_value(reply, 1);
+    GVariant* children = g_variant_get_child_value(layout, 2);
+    for (gsize i = 0; i < g_variant_n_children(children); ++i) {
+        GVariant* boxed = g_variant_get_child_value(children, i);
+        GVariant* child = g_variant_get_variant(boxed);
+        int32_t id = 0;
+        g_variant_get_child(child, 0, "i", &id);
+        ids.push_back(id);
+        g_variant_unref(child);
+        g_variant_unref(boxed);
+    }
+    g_variant_unref(children);
+    g_variant_unref(layout);
+    g_variant_unref(reply);
+    return ids;
+}
+
+static TrayMenuItem menu_item(int32_t id, const char* label) {
+    TrayMenuItem item;
+    item.id = id;
+    item.label = label;
+    return item;
+}
+
+static void test_menu_updates(GTestDBus* bus) {
+    StatusNotifier notifier("vmcastle-test", "Test", "edit-paste");
+    int32_t clicked = 0;
+    notifier.on_item_clicked = [&clicked](int32_t id) { clicked = id; };
+    notifier.set_items({menu_item(101, "one"), menu_item(102, "two")});
+    CHECK(notifier.start());
+
+    // The item lives on the shared session connection; address it by its unique name
+    GDBusConnection* session = g_bus_get_sync(G_BUS_TYPE_SESSION, nullptr, nullptr);
+    CHECK(session != nullptr);
+    if (!session) {
+        return;
+    }
+    std::string item = g_dbus_connection_get_unique_name(session);
+
+    GDBusConnection* host = g_dbus_connection_new_for_address_sync(
+        g_test_dbus_get_bus_address(bus),
+        static_cast<GDBusConnectionFlags>(G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT |
+                                          G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION),
+        nullptr, nullptr, nullptr);
+    CHECK(host != nullptr);
+    if (!host) {
+        g_object_unref(session);
+        return;
+    }
+    HostSignals signals;
+    guint subscription = g_dbus_connection_signal_subscribe(host, nullptr, MENU_INTERFACE, nullptr, MENU_PATH,
+                                                            nullptr, G_DBUS_SIGNAL_FLAGS_NONE, on_menu_signal,
+                                                            &signals, nullptr);
+
+    uint32_t revision = 0;
+    CHECK((layout_ids(host, item.c_str(), revision) == std::vector<int32_t>{101, 102}));
+    uint32_t first_revision = revision;
+
+    // A label change on an item that stays is a property update only
+    notifier.set_items({menu_item(101, "one"), menu_item(102, "TWO")});
+    CHECK(wait_for([&signals]() { return signals.properties_updated == 1; }));
+    CHECK(signals.layout_updated == 0);
+    CHECK((signals.updated_ids == std::vector<int32_t>{102}));
+    CHECK(notifier.get_revision() == first_revision);
+
+    // A new entry on top keeps the ids of the others
+    notifier.set_items({menu_item(103, "three"), menu_item(101, "one"), menu_item(102, "TWO")});
+    CHECK(wait_for([&signals]() { return signals.layout_updated == 1; }));
+    CHECK(signals.properties_updated == 1);
+    CHECK((layout_ids(host, item.c_str(), revision) == std::vector<int32_t>{103, 101, 102}));
+    CHECK(revision == first_revision + 1);
+
+    // An unchanged list is not announced at all
+    notifier.set_items({menu_item(103, "three"), menu_item(101, "one"), menu_item(102, "TWO")});
+    layout_ids(host, item.c_str(), revision);
+    CHECK(signals.layout_updated == 1 && signals.properties_updated == 1);
+
+    // Clicks reach the item by id
+    GVariant* reply = call_menu(host, item.c_str(), "Event",
+                                g_variant_new("(isvu)", 101, "clicked", g_variant_new_int32(0), 0u), "()");
+    CHECK(reply != nullptr);
+    if (reply) {
+        g_variant_unref(reply);
+    }
+    CHECK(clicked == 101);
+
+    g_dbus_connection_signal_unsubscribe(host, subscription);
+    g_dbus_connection_close_sync(host, nullptr, nullptr);
+    g_object_unref(host);
+    notifier.stop();
+    g_object_unref(session);
+}
+
+int main() {
+    GTestDBus* bus = g_test_dbus_new(G_TEST_DBUS_NONE);
+    g_test_dbus_up(bus);
+
+    test_menu_updates(bus);
+
+    g_test_dbus_down(bus);
+    g_object_unref(bus);
+    return test_result();
+}
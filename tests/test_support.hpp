@@ -0,0 +1,30 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+
+#ifndef TEST_SUPPORT_HPP
+#define TEST_SUPPORT_HPP
+
+#include <cstdio>
+
+// Minimal assertions for the unit tests: a failed CHECK reports the
+// expression and keeps going; main returns test_result()
+inline int& test_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(expr)                                                                  \
+    do {                                                                             \
+        if (!(expr)) {                                                               \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+            test_failures()++;                                                       \
+        }                                                                            \
+    } while (0)
+
+inline int test_result() {
+    return test_failures() == 0 ? 0 : 1;
+}
+
+#endif // TEST_SUPPORT_HPP
@@ -0,0 +1,115 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "timer_wheel.hpp"
+#include "test_support.hpp"
+#include <map>
+#include <random>
+#include <vector>
+
+static void test_order() {
+    TimerWheel<int> wheel(0);
+    wheel.schedule(3, 300);
+    wheel.schedule(1, 5);
+    wheel.schedule(2, 70);
+    CHECK(wheel.size() == 3);
+
+    std::vector<int> fired;
+    auto expire = [&fired](int item) { fired.push_back(item); };
+    wheel.advance(4, expire);
+    CHECK(fired.empty());
+    wheel.advance(5, expire);
+    CHECK((fired == std::vector<int>{1}));
+    wheel.advance(1000, expire);
+    CHECK((fired == std::vector<int>{1, 2, 3}));
+    CHECK(wheel.empty());
+    CHECK(wheel.next_delay() == 0);
+}
+
+static void test_past_deadline() {
+    TimerWheel<int> wheel(100);
+    wheel.schedule(1, 50);
+    int fired = 0;
+    wheel.advance(100, [&fired](int) { fired++; });
+    CHECK(fired == 0);
+    wheel.advance(101, [&fired](int) { fired++; });
+    CHECK(fired == 1);
+}
+
+// Deadlines past the 64^4 ticks the levels cover wait in the top level
+static void test_beyond_the_wheel() {
+    const uint64_t far = (uint64_t(1) << 24) * 3 + 12345;
+    TimerWheel<int> wheel(7);
+    wheel.schedule(1, far);
+    int fired = 0;
+    wheel.advance(far - 1, [&fired](int) { fired++; });
+    CHECK(fired == 0);
+    CHECK(wheel.size() == 1);
+    wheel.advance(far, [&fired](int) { fired++; });
+    CHECK(fired == 1);
+}
+
+// Random deadlines and steps: every timer fires exactly once, in the
+// advance() that reaches its deadline, and next_delay() never overshoots
+static void test_against_reference() {
+    std::mt19937_64 random(42);
+    TimerWheel<size_t> wheel(1000);
+    uint64_t now = 1000;
+    std::vector<uint64_t> deadlines;
+    std::vector<int> fire_count;
+    std::multimap<uint64_t, size_t> pending;
+    int late = 0;
+    int early = 0;
+    int overshoots = 0;
+
+    for (int round = 0; round < 2000; round++) {
+        size_t new_timers = random() % 4;
+        for (size_t i = 0; i < new_timers; i++) {
+            uint64_t span = uint64_t(1) << (random() % 28);
+            uint64_t deadline = now + 1 + random() % span;
+            deadlines.push_back(deadline);
+            fire_count.push_back(0);
+            pending.emplace(deadline, deadlines.size() - 1);
+            wheel.schedule(deadlines.size() - 1, deadline);
+        }
+
+        if (!pending.empty() && wheel.next_delay() > pending.begin()->first - now) {
+            overshoots++;
+        }
+
+        uint64_t step = random() % 3 == 0 ? (uint64_t(1) << (random() % 26)) : random() % 80;
+        uint64_t previous = now;
+        now += step;
+        wheel.advance(now, [&](size_t item) {
+            fire_count[item]++;
+            if (deadlines[item] > now) {
+                early++;
+            }
+            if (deadlines[item] <= previous) {
+                late++;
+            }
+        });
+        pending.erase(pending.begin(), pending.upper_bound(now));
+        CHECK(wheel.size() == pending.size());
+    }
+
+    wheel.advance(now + (uint64_t(1) << 30), [&](size_t item) { fire_count[item]++; });
+    bool each_once = true;
+    for (int count : fire_count) {
+        each_once = each_once && count == 1;
+    }
+    CHECK(each_once);
+    CHECK(early == 0);
+    CHECK(late == 0);
+    CHECK(overshoots == 0);
+    CHECK(wheel.empty());
+}
+
+int main() {
+    test_order();
+    test_past_deadline();
+    test_beyond_the_wheel();
+    test_against_reference();
+    return test_result();
+}
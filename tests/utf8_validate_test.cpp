@@ -0,0 +1,165 @@
+// Copyright (C) 2025 Vinícius (VmCastle)
+// Este arquivo é parte de um software licenciado sob a GPLv3.
+// Consulte o arquivo LICENSE para mais informações.
+
+#include "utf8_validate.hpp"
+#include "test_support.hpp"
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Byte-by-byte reading of RFC 3629, with NUL rejected as the validator does
+static bool reference_valid(const std::string& text) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+    size_t i = 0;
+    while (i < size) {
+        unsigned char c = p[i];
+        if (c == 0) {
+            return false;
+        }
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        size_t length;
+        uint32_t code;
+        if (c >= 0xC2 && c <= 0xDF) {
+            length = 2;
+            code = c & 0x1F;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            length = 3;
+            code = c & 0x0F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            length = 4;
+            code = c & 0x07;
+        } else {
+            return false;
+        }
+        if (i + length > size) {
+            return false;
+        }
+        for (size_t k = 1; k < length; k++) {
+            if ((p[i + k] & 0xC0) != 0x80) {
+                return false;
+            }
+            code = (code << 6) | (p[i + k] & 0x3F);
+        }
+        if ((length == 3 && code < 0x800) || (length == 4 && (code < 0x10000 || code > 0x10FFFF)) ||
+            (code >= 0xD800 && code <= 0xDFFF)) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+static std::string encode(uint32_t code) {
+    std::string out;
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    return out;
+}
+
+static bool valid(const std::string& text) {
+    return utf8_is_valid(text.data(), text.size());
+}
+
+static void test_known_sequences() {
+    CHECK(valid(""));
+    CHECK(valid("plain ascii"));
+    CHECK(valid("ação, naïve, 日本語, 😀"));
+    CHECK(valid("\xF4\x8F\xBF\xBF"));          // U+10FFFF
+    CHECK(valid("\xED\x9F\xBF"));              // U+D7FF, just below the surrogates
+
+    CHECK(!valid(std::string("a\0b", 3)));     // NUL
+    CHECK(!valid("\xC0\x80"));                 // Overlong NUL
+    CHECK(!valid("\xC1\xBF"));                 // Overlong 2-byte
+    CHECK(!valid("\xE0\x80\x80"));             // Overlong 3-byte
+    CHECK(!valid("\xF0\x80\x80\x80"));         // Overlong 4-byte
+    CHECK(!valid("\xED\xA0\x80"));             // Surrogate U+D800
+    CHECK(!valid("\xF4\x90\x80\x80"));         // U+110000
+    CHECK(!valid("\xF5\x80\x80\x80"));
+    CHECK(!valid("\xFF"));
+    CHECK(!valid("\x80"));                     // Lone continuation
+    CHECK(!valid("\xC3"));                     // Cut short at the end
+    CHECK(!valid("\xE6\x97"));
+    CHECK(!valid("\xF0\x9F\x98"));
+    CHECK(!valid("\xC3 "));                    // Cut short by ASCII
+}
+
+// Sequences straddling the 16-byte blocks of the vector validator, and a
+// cut sequence followed by an all-ASCII block
+static void test_block_boundaries() {
+    for (size_t offset = 0; offset < 40; offset++) {
+        for (uint32_t code : {0xE9u, 0x65E5u, 0x1F600u}) {
+            std::string text = std::string(offset, 'x') + encode(code) + std::string(40, 'y');
+            CHECK(valid(text));
+            std::string cut = std::string(offset, 'x') + encode(code).substr(0, 1) + std::string(40, 'y');
+            CHECK(!valid(cut));
+            CHECK(!valid(std::string(offset, 'x') + encode(code).substr(0, 1)));
+        }
+        std::string nul = std::string(offset, 'x') + std::string(1, '\0') + std::string(20, 'y');
+        CHECK(!valid(nul));
+    }
+}
+
+// Random texts and random damage to them, against the reference
+static void test_against_reference() {
+    std::mt19937 random(12345);
+    const uint32_t ranges[][2] = {{0x20, 0x7F}, {0x80, 0x7FF}, {0x800, 0xD7FF}, {0xE000, 0xFFFF}, {0x10000, 0x10FFFF}};
+    int mismatches = 0;
+    for (int round = 0; round < 20000; round++) {
+        std::string text;
+        size_t count = random() % 48;
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t* range = ranges[random() % 5];
+            text += encode(range[0] + random() % (range[1] - range[0] + 1));
+        }
+        if (!text.empty() && round % 2 == 1) {
+            text[random() % text.size()] = static_cast<char>(random() % 256);
+        }
+        if (valid(text) != reference_valid(text)) {
+            mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void test_repair() {
+    std::string repaired;
+    CHECK(repair_utf8("caf\xE9 au lait", repaired) == TextKind::REPAIRED);
+    CHECK(repaired == "caf\xEF\xBF\xBD au lait");
+    CHECK(valid(repaired));
+
+    // Mostly control and invalid bytes: a binary payload, left as it is
+    std::string binary;
+    for (int i = 0; i < 512; i++) {
+        binary += static_cast<char>((i * 37) % 32 == 10 ? 1 : (i * 37) % 32);
+        binary += static_cast<char>(0x80 + i % 64);
+    }
+    repaired = "unchanged";
+    CHECK(repair_utf8(binary, repaired) == TextKind::BINARY);
+    CHECK(repaired.empty());
+}
+
+int main() {
+    test_known_sequences();
+    test_block_boundaries();
+    test_against_reference();
+    test_repair();
+    return test_result();
+}